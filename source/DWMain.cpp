@@ -1,10 +1,21 @@
 ﻿#include "DWMain.hpp"
 
+#include <cstdio>
+
 namespace {
 	//DWMainインスタンス
 	dw::DWMain* g_dwmain = nullptr;
 	//グローバルミューテックス
 	std::mutex g_mtx;
+	//直近の終了所要時間[us]
+	std::int32_t g_shutdownLatencyUs = 0;
+
+	//背景色
+	const dw::DWColor BG_COLOR = { 255, 255, 255, 255 };
+	//時刻文字列の文字サイズ
+	const std::int32_t TEXT_SIZE = 32;
+	//時刻文字列の文字色
+	const dw::DWColor TEXT_COLOR = { 0, 0, 255, 255 };
 }
 
 namespace dw {
@@ -19,7 +30,7 @@ namespace dw {
 		//ZDigitalWatchインスタンスが未生成なら生成する
 		g_mtx.lock();
 		if (g_dwmain == nullptr) {
-			g_dwmain = new DWMain();
+			g_dwmain = new DWMain(true);
 		}
 		g_mtx.unlock();
 	}
@@ -35,36 +46,178 @@ namespace dw {
 		g_mtx.unlock();
 	}
 
+	//全体再描画要求(リサイズ、再表示時)
+	void DWMain::invalidate()
+	{
+		g_mtx.lock();
+		if (g_dwmain != nullptr) {
+			//フレーム履歴を無効化し、次の2フレームを全体再描画させる
+			g_dwmain->mtx_.lock();
+			for (std::int32_t i = 0; i < HISTORY_NUM; i++) {
+				g_dwmain->history_[i].isValid_ = false;
+			}
+			g_dwmain->isWakeup_ = true;
+			g_dwmain->mtx_.unlock();
+
+			//待ち中のタスクを起床
+			g_dwmain->cv_.notify_one();
+		}
+		g_mtx.unlock();
+	}
+
+	//1秒あたりの再描画セル数取得(時刻画像の変化したセル数と、再描画した時刻文字列の文字数の合計)
+	std::int32_t DWMain::getRedrawCellNumPerSec()
+	{
+		std::int32_t cellNum = 0;
+		g_mtx.lock();
+		if (g_dwmain != nullptr) {
+			g_dwmain->mtx_.lock();
+			cellNum = g_dwmain->redrawCellNumPerSec_;
+			g_dwmain->mtx_.unlock();
+		}
+		g_mtx.unlock();
+		return cellNum;
+	}
+
+	//描画コール数取得(直近の計測時点の前フレーム)
+	std::int32_t DWMain::getDrawCallNum()
+	{
+		std::int32_t drawCallNum = 0;
+		g_mtx.lock();
+		if (g_dwmain != nullptr) {
+			g_dwmain->mtx_.lock();
+			drawCallNum = g_dwmain->drawCallNum_;
+			g_dwmain->mtx_.unlock();
+		}
+		g_mtx.unlock();
+		return drawCallNum;
+	}
+
+	//秒境界からの表示遅延取得[us]
+	std::int32_t DWMain::getPresentLateUs()
+	{
+		std::int32_t lateUs = 0;
+		g_mtx.lock();
+		if (g_dwmain != nullptr) {
+			g_dwmain->mtx_.lock();
+			lateUs = g_dwmain->presentLateUs_;
+			g_dwmain->mtx_.unlock();
+		}
+		g_mtx.unlock();
+		return lateUs;
+	}
+
+	//秒境界からの最大表示遅延取得[us]
+	std::int32_t DWMain::getPresentMaxLateUs()
+	{
+		std::int32_t maxLateUs = 0;
+		g_mtx.lock();
+		if (g_dwmain != nullptr) {
+			g_dwmain->mtx_.lock();
+			maxLateUs = g_dwmain->presentMaxLateUs_;
+			g_dwmain->mtx_.unlock();
+		}
+		g_mtx.unlock();
+		return maxLateUs;
+	}
+
+	//直近の終了所要時間取得[us]
+	std::int32_t DWMain::getShutdownLatencyUs()
+	{
+		g_mtx.lock();
+		const std::int32_t latencyUs = g_shutdownLatencyUs;
+		g_mtx.unlock();
+		return latencyUs;
+	}
+
+	//描画性能計測(タスクを起動せずに指定フレーム数を連続描画し、1フレームあたりの時間[us]を返す)
+	std::float64_t DWMain::benchmark(const std::int32_t frameNum, const bool isFullRedraw)
+	{
+		DWMain dwmain(false);
+		dwmain.setupFrame();
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::int32_t i = 0; i < frameNum; i++) {
+			if (isFullRedraw) {
+				//毎フレーム全体再描画
+				for (std::int32_t h = 0; h < HISTORY_NUM; h++) {
+					dwmain.history_[h].isValid_ = false;
+				}
+			}
+
+			//1秒ずつ進めた時刻で描画
+			const DWTime dwTime = DWFunc::getTime(static_cast<time_t>(i));
+			(void)dwmain.drawFrame(dwTime);
+		}
+		const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+		//描画後始末
+		dwmain.cleanupFrame();
+
+		return static_cast<std::float64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / 1000.0 / frameNum;
+	}
+
 	//コンストラクタ
-	DWMain::DWMain() :
-		th_(), mtx_(), taskState_(END)
+	DWMain::DWMain(const bool isTask) :
+		th_(), mtx_(), cv_(), taskState_(END), isWakeup_(false), atlas_(), history_(), scheduler_(),
+		pageID_(-1), textHeight_(0),
+		redrawCellNum_(0), redrawCellNumPerSec_(0), drawCallNum_(0), presentLateUs_(0), presentMaxLateUs_(0), measureStart_()
 	{
-		//タスク開始
-		this->mtx_.lock();
-		this->taskState_ = START;
-		this->mtx_.unlock();
-		//スレッド作成
-		this->th_ = std::thread(&DWMain::task, this);
+		//時刻画像をデコードしてアトラスを作成(描画ループではデコードしない)
+		std::int32_t charNum = 0;
+		const std::char8_t* chars = DWFunc::getChars_TimeNumImage(&charNum);
+		(void)this->atlas_.create(chars, charNum);
+
+		if (isTask) {
+			//タスク開始
+			this->mtx_.lock();
+			this->taskState_ = START;
+			this->mtx_.unlock();
+			//スレッド作成
+			this->th_ = std::thread(&DWMain::task, this);
+		}
 	}
 
 	//デストラクタ
 	DWMain::~DWMain()
 	{
-		//タスク終了
+		if (!this->th_.joinable()) {
+			//タスク未起動
+			return;
+		}
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		//タスク終了(待ち中のタスクを起床させる)
 		this->mtx_.lock();
 		this->taskState_ = END;
+		this->isWakeup_ = true;
 		this->mtx_.unlock();
+		this->cv_.notify_one();
 		//スレッド破棄
 		this->th_.join();
+
+		//終了所要時間を記録(terminate()でg_mtx取得済み)
+		g_shutdownLatencyUs = static_cast<std::int32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
 	}
 
 	//メインタスク
 	void DWMain::task()
 	{
+		//描画準備
+		this->setupFrame();
+
+		//再描画セル数の計測開始
+		this->measureStart_ = std::chrono::steady_clock::now();
+
+		//秒境界で起床したフレームか(表示遅延の計測対象)
+		bool isTick = false;
+
 		while (true) {
 			//タスク状態を取得
 			this->mtx_.lock();
 			const bool endTask = (this->taskState_ == END) ? true : false;
+			this->isWakeup_ = false;
 			this->mtx_.unlock();
 
 			if (endTask) {
@@ -75,44 +228,191 @@ namespace dw {
 			//時刻取得
 			const DWTime dwTime = DWFunc::getTime();
 
-			//描画開始
-			DWWindow* dwwin = DWWindow::get();
-			dwwin->beginDraw();
+			//1フレーム描画
+			const std::int32_t redrawCellNum = this->drawFrame(dwTime);
+			if ((redrawCellNum > 0) && (isTick)) {
+				//秒境界からの表示遅延を記録
+				this->scheduler_.notifyPresent();
+			}
 
-			//画面クリア
-			const DWColor color = { 255, 255, 255, 255 };
-			dwwin->clear(color);
+			//再描画セル数計測
+			this->measureRedrawCell(redrawCellNum);
+
+			//次の秒境界まで待ち(終了、全体再描画要求で起床)
+			std::unique_lock<std::mutex> lock(this->mtx_);
+			isTick = this->scheduler_.waitNextTick(this->cv_, lock, this->isWakeup_);
+		}
 
-			//時刻数字描画
-			DWText text = { 0 };
-			text.textSize_ = 32;
-			text.textNum_ = dwTime.strNum_;
+		//描画後始末(描画スレッドで解放する)
+		this->cleanupFrame();
+	}
+
+	//描画準備
+	void DWMain::setupFrame()
+	{
+		DWWindow* dwwin = DWWindow::get();
+
+		//アトラスページを常駐画像として登録
+		DWBitmap page;
+		this->atlas_.getPage(&page);
+		this->pageID_ = dwwin->registerBitmap(page);
+
+		//時刻文字列の行高さ(時刻画像は文字列の下に並べる)
+		this->textHeight_ = dwwin->getTextLineHeight(TEXT_SIZE);
+	}
+
+	//描画後始末(アトラス破棄前に常駐画像の登録を解除)
+	void DWMain::cleanupFrame()
+	{
+		DWWindow* dwwin = DWWindow::get();
+
+		//アトラスページの登録を解除(解除しないと破棄後のページを参照し続け、常駐枠も埋まる)
+		if (this->pageID_ >= 0) {
+			dwwin->unregisterBitmap(this->pageID_);
+			this->pageID_ = -1;
+		}
+	}
+
+	//1フレーム描画(再描画したセル数を返す(文字列の行は全文字を数える)、0なら描画なし)
+	std::int32_t DWMain::drawFrame(const DWTime& dwTime)
+	{
+		DWWindow* dwwin = DWWindow::get();
+
+		//フレーム履歴を取得
+		this->mtx_.lock();
+		FrameHistory history[HISTORY_NUM];
+		for (std::int32_t i = 0; i < HISTORY_NUM; i++) {
+			history[i] = this->history_[i];
+		}
+		this->mtx_.unlock();
+
+		//全体再描画が必要か判定(描画先の内容が保持されない、履歴無効、文字数またはセル幅が変化)
+		bool isFullRedraw = !dwwin->isBackBufferKept();
+		for (std::int32_t h = 0; h < HISTORY_NUM; h++) {
+			if ((!history[h].isValid_) || (history[h].strNum_ != dwTime.strNum_)) {
+				isFullRedraw = true;
+				break;
+			}
 			for (std::int32_t i = 0; i < dwTime.strNum_; i++) {
-				text.text_[i] = static_cast<std::uint16_t>(dwTime.str_[i]);
+				if (this->getCellWidth(history[h].str_[i]) != this->getCellWidth(dwTime.str_[i])) {
+					isFullRedraw = true;
+					break;
+				}
 			}
-			DWCoord textCoord = { 0, 0 };
-			DWColor textColor = { 0, 0, 255, 255 };
-			dwwin->drawText(text, textCoord, textColor);
+		}
 
-			//時刻画像描画
-			DWCoord bitmapCoord = { 0, text.textSize_ };
-			for (std::int32_t i = 0; i < dwTime.strNum_; i++) {
-				DWImageFormat format;
-				std::string filePath = DWFunc::getFilePath_TimeNumImage(dwTime.str_[i], format);
-				DWImageDecorder decorder;
-				decorder.decode_RGBA8888(filePath.c_str(), nullptr, format);
-				DWBitmap bitmap;
-				bitmap.image_ = decorder.getDecodeData(&bitmap.imageSize_, &bitmap.width_, &bitmap.height_);
-				dwwin->drawBitmap(bitmap, bitmapCoord);
-
-				bitmapCoord.x_ += bitmap.width_;
+		//前回,前々回のフレームから変化した文字セルを抽出
+		//(ダブルバッファのバックバッファは前々回の内容の場合があるため両方と比較)
+		bool isDirty[32] = { false };
+		std::int32_t dirtyNum = 0;
+		for (std::int32_t i = 0; i < dwTime.strNum_; i++) {
+			isDirty[i] = isFullRedraw;
+			for (std::int32_t h = 0; h < HISTORY_NUM; h++) {
+				if (history[h].str_[i] != dwTime.str_[i]) {
+					isDirty[i] = true;
+				}
+			}
+			if (isDirty[i]) { dirtyNum++; }
+		}
+
+		if (dirtyNum == 0) {
+			//変化なし
+			return 0;
+		}
+
+		if (isFullRedraw) {
+			//ウィンドウサイズを更新
+			dwwin->updateSize();
+		}
+
+		//描画開始
+		dwwin->beginDraw();
+
+		if (isFullRedraw) {
+			//画面クリア
+			dwwin->clear(BG_COLOR);
+		}
+
+		//時刻数字描画(いずれかの文字が変化したら文字列の行を再描画)
+		//(文字送り幅、カーニングで後続の文字位置が変わり、グリフが送り幅からはみ出す場合もあるため、変化した文字のみの消去は不可)
+		//(グリフアトラスからまとめて描画するため、行全体でも描画コールは増えない)
+		const DWSize winSize = dwwin->getSize();
+		const DWArea textArea = { 0, 0, winSize.width_, this->textHeight_ };
+		dwwin->fillRect(textArea, BG_COLOR);
+		DWText text = { 0 };
+		text.textSize_ = TEXT_SIZE;
+		text.textNum_ = dwTime.strNum_;
+		for (std::int32_t i = 0; i < dwTime.strNum_; i++) {
+			text.text_[i] = static_cast<std::uint16_t>(dwTime.str_[i]);
+		}
+		DWCoord textCoord = { 0, 0 };
+		dwwin->drawText(text, textCoord, TEXT_COLOR);
+
+		//時刻画像描画(変化した文字セルのみアトラスから描画)
+		DWCoord bitmapCoord = { 0, this->textHeight_ };
+		for (std::int32_t i = 0; i < dwTime.strNum_; i++) {
+			DWArea area;
+			if (this->atlas_.getRegion(dwTime.str_[i], &area) < 0) {
+				//アトラスに無い文字
+				continue;
 			}
+			const std::int32_t cellW = area.xmax_ - area.xmin_;
+			const std::int32_t cellH = area.ymax_ - area.ymin_;
+
+			if (isDirty[i]) {
+				const DWArea cellArea = { bitmapCoord.x_, bitmapCoord.y_, bitmapCoord.x_ + cellW, bitmapCoord.y_ + cellH };
+				dwwin->fillRect(cellArea, BG_COLOR);
+				dwwin->drawBitmap(this->pageID_, area, bitmapCoord);
+			}
+
+			bitmapCoord.x_ += cellW;
+		}
 
-			//描画終了
-			dwwin->endDraw();
+		//描画終了
+		dwwin->endDraw();
+
+		//フレーム履歴を更新
+		this->mtx_.lock();
+		for (std::int32_t h = HISTORY_NUM - 1; h > 0; h--) {
+			this->history_[h] = this->history_[h - 1];
+		}
+		this->history_[0].isValid_ = true;
+		this->history_[0].strNum_ = dwTime.strNum_;
+		memcpy_s(this->history_[0].str_, sizeof(this->history_[0].str_), dwTime.str_, sizeof(dwTime.str_));
+		this->mtx_.unlock();
+
+		//時刻画像の変化したセルと、時刻文字列の行の全文字を再描画した
+		return dirtyNum + dwTime.strNum_;
+	}
+
+	//文字セル幅取得
+	std::int32_t DWMain::getCellWidth(const std::char8_t c)
+	{
+		DWArea area;
+		if (this->atlas_.getRegion(c, &area) < 0) {
+			//アトラスに無い文字
+			return 0;
+		}
+		return area.xmax_ - area.xmin_;
+	}
+
+	//再描画セル数計測
+	void DWMain::measureRedrawCell(const std::int32_t cellNum)
+	{
+		this->redrawCellNum_ += cellNum;
+
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if ((now - this->measureStart_) >= std::chrono::seconds(1)) {
+			//1秒経過毎に確定
+			this->mtx_.lock();
+			this->redrawCellNumPerSec_ = this->redrawCellNum_;
+			this->drawCallNum_ = DWWindow::get()->getDrawCallNum();
+			this->presentLateUs_ = this->scheduler_.getLateUs();
+			this->presentMaxLateUs_ = this->scheduler_.getMaxLateUs();
+			this->mtx_.unlock();
 
-			//待ち
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			this->redrawCellNum_ = 0;
+			this->measureStart_ = now;
 		}
 	}
 }
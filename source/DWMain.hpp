@@ -5,6 +5,8 @@
 #include "DWUtility.hpp"
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace dw {
 
@@ -15,24 +17,72 @@ namespace dw {
 			END,
 		};
 
+		//表示フレーム履歴
+		struct FrameHistory {
+			bool			isValid_;	//有効/無効(無効時は全体再描画)
+			std::int32_t	strNum_;	//表示文字数
+			std::char8_t	str_[32];	//表示文字列
+		};
+
+		//保持するフレーム履歴数(ダブルバッファのため前回,前々回)
+		static const std::int32_t HISTORY_NUM = 2;
+
 		//メンバ変数
 		std::thread		th_;
 		std::mutex		mtx_;
+		std::condition_variable	cv_;
 		TaskState		taskState_;
+		bool			isWakeup_;		//起床要求(終了、全体再描画時)
+		DWImageAtlas	atlas_;
+		FrameHistory	history_[HISTORY_NUM];
+		DWTickScheduler	scheduler_;
+		std::int32_t	pageID_;		//アトラスページの常駐画像ID
+		std::int32_t	textHeight_;	//時刻文字列の行高さ
+
+		std::int32_t	redrawCellNum_;			//計測中の再描画セル数
+		std::int32_t	redrawCellNumPerSec_;	//1秒あたりの再描画セル数
+		std::int32_t	drawCallNum_;			//計測時点の描画コール数(前フレーム)
+		std::int32_t	presentLateUs_;			//計測時点の表示遅延[us]
+		std::int32_t	presentMaxLateUs_;		//計測時点の最大表示遅延[us]
+		std::chrono::steady_clock::time_point	measureStart_;	//計測開始時刻
 
 	public:
 		//開始
 		static void start();
 		//終了
 		static void terminate();
+		//全体再描画要求(リサイズ、再表示時)
+		static void invalidate();
+		//1秒あたりの再描画セル数取得(時刻画像の変化したセル数と、再描画した時刻文字列の文字数の合計)
+		static std::int32_t getRedrawCellNumPerSec();
+		//描画コール数取得(直近の計測時点の前フレーム)
+		static std::int32_t getDrawCallNum();
+		//秒境界からの表示遅延取得[us]
+		static std::int32_t getPresentLateUs();
+		//秒境界からの最大表示遅延取得[us]
+		static std::int32_t getPresentMaxLateUs();
+		//直近の終了所要時間取得[us]
+		static std::int32_t getShutdownLatencyUs();
+		//描画性能計測(タスクを起動せずに指定フレーム数を連続描画し、1フレームあたりの時間[us]を返す)
+		static std::float64_t benchmark(const std::int32_t frameNum, const bool isFullRedraw);
 
 	private:
 		//コンストラクタ
-		DWMain();
+		DWMain(const bool isTask);
 		//デストラクタ
 		~DWMain();
 		//メインタスク
 		void task();
+		//描画準備
+		void setupFrame();
+		//描画後始末(アトラス破棄前に常駐画像の登録を解除)
+		void cleanupFrame();
+		//1フレーム描画(再描画したセル数を返す(文字列の行は全文字を数える)、0なら描画なし)
+		std::int32_t drawFrame(const DWTime& dwTime);
+		//文字セル幅取得
+		std::int32_t getCellWidth(const std::char8_t c);
+		//再描画セル数計測
+		void measureRedrawCell(const std::int32_t cellNum);
 	};
 };
 
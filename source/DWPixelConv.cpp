@@ -0,0 +1,1497 @@
+﻿#include "DWPixelConv.hpp"
+#include <cstring>
+
+//x86系のみSIMDカーネルを使用する
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DW_PIXELCONV_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+//MSVCは命令セットの指定なしで組み込み関数を使用できる
+#define DW_TARGET_SSSE3
+#define DW_TARGET_AVX2
+#else
+//関数単位で命令セットを有効化(実行時に判定してから呼び出す)
+#define DW_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define DW_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+	//RGBA8888画像の1ピクセルあたりのバイト数
+	static const std::int32_t BYTE_PER_PIXEL_RGBA8888 = 4;
+
+	//----------------------------------------------------------------
+	// スカラー版
+
+	//RGB→RGBA
+	void rowRGBtoRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		for (std::int32_t i = 0; i < width; i++) {
+			//1ピクセル読み込んでから書き込む(その場展開に対応)
+			const std::uint8_t r = rp[0];
+			const std::uint8_t g = rp[1];
+			const std::uint8_t b = rp[2];
+			wp[0] = r;
+			wp[1] = g;
+			wp[2] = b;
+			wp[3] = 255;
+			rp += 3;
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+
+	//BGR→RGBA
+	void rowBGRtoRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		for (std::int32_t i = 0; i < width; i++) {
+			//1ピクセル読み込んでから書き込む(その場展開に対応)
+			const std::uint8_t b = rp[0];
+			const std::uint8_t g = rp[1];
+			const std::uint8_t r = rp[2];
+			wp[0] = r;
+			wp[1] = g;
+			wp[2] = b;
+			wp[3] = 255;
+			rp += 3;
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+
+	//BGRA→RGBA
+	void rowBGRAtoRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		for (std::int32_t i = 0; i < width; i++) {
+			//1ピクセル読み込んでから書き込む(その場変換に対応)
+			const std::uint8_t b = rp[0];
+			const std::uint8_t g = rp[1];
+			const std::uint8_t r = rp[2];
+			const std::uint8_t a = rp[3];
+			wp[0] = r;
+			wp[1] = g;
+			wp[2] = b;
+			wp[3] = a;
+			rp += 4;
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+
+	//RGBA→RGBA(並べ替えなし、memcpyが命令セット毎に最適化済み)
+	void rowRGBAtoRGBA(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		memcpy(dst, src, width * BYTE_PER_PIXEL_RGBA8888);
+	}
+
+	//グレー+アルファ→RGBA
+	void rowGrayAlphatoRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		for (std::int32_t i = 0; i < width; i++) {
+			//1ピクセル読み込んでから書き込む(その場展開に対応)
+			const std::uint8_t gray = rp[0];
+			const std::uint8_t a = rp[1];
+			wp[0] = gray;
+			wp[1] = gray;
+			wp[2] = gray;
+			wp[3] = a;
+			rp += 2;
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+
+	//16bitサンプル(ビッグエンディアン)→8bit(四捨五入、(v * 255 + 32895) >> 16 は v / 257 の四捨五入と一致)
+	void rowReduce16to8_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			const std::uint32_t v = (std::uint32_t(src[i * 2]) << 8) | src[(i * 2) + 1];
+			dst[i] = static_cast<std::uint8_t>(((v * 255U) + 32895U) >> 16);
+		}
+	}
+
+	//0～255*255の値を255で除算(四捨五入)
+	inline std::uint8_t div255(const std::uint32_t v)
+	{
+		const std::uint32_t t = v + 128;
+		return static_cast<std::uint8_t>((t + (t >> 8)) >> 8);
+	}
+
+	//RGBA(R_CHANNELが2ならBGRA)→乗算済みRGBA
+	template <std::int32_t R_CHANNEL>
+	void rowToPremulRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		for (std::int32_t i = 0; i < width; i++) {
+			//1ピクセル読み込んでから書き込む(その場変換に対応)
+			const std::uint32_t r = rp[R_CHANNEL];
+			const std::uint32_t g = rp[1];
+			const std::uint32_t b = rp[2 - R_CHANNEL];
+			const std::uint32_t a = rp[3];
+			wp[0] = div255(r * a);
+			wp[1] = div255(g * a);
+			wp[2] = div255(b * a);
+			wp[3] = static_cast<std::uint8_t>(a);
+			rp += 4;
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+
+	//マスク(1ピクセルSRC_BYTEバイトのCHANNEL番目)→アルファ
+	template <std::int32_t SRC_BYTE, std::int32_t CHANNEL>
+	void rowMaskToAlpha_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			dst[(i * BYTE_PER_PIXEL_RGBA8888) + 3] = src[(i * SRC_BYTE) + CHANNEL];
+		}
+	}
+
+	//ビットフィールドの1ピクセル(pixel)をRGBAへ変換
+	inline void pixelBitFieldstoRGBA(const std::uint32_t pixel, std::uint8_t* const wp, const dw::DWPixelConv::BitFields& fields)
+	{
+		for (std::int32_t c = 0; c < 4; c++) {
+			const std::uint32_t value = (pixel >> fields.shift_[c]) & ((1U << fields.bitNum_[c]) - 1U);
+			wp[c] = static_cast<std::uint8_t>((value * fields.scale_[c]) >> fields.bitNum_[c]);
+		}
+		if (!fields.isAlpha_) {
+			wp[3] = 255;
+		}
+	}
+
+	//16bitビットフィールド→RGBA
+	void rowBitFields16toRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const dw::DWPixelConv::BitFields& fields)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			const std::uint8_t* rp = src + (i * 2);
+			const std::uint32_t pixel = std::uint32_t(rp[0]) | (std::uint32_t(rp[1]) << 8);
+			pixelBitFieldstoRGBA(pixel, dst + (i * BYTE_PER_PIXEL_RGBA8888), fields);
+		}
+	}
+
+	//32bitビットフィールド→RGBA
+	void rowBitFields32toRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const dw::DWPixelConv::BitFields& fields)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			const std::uint8_t* rp = src + (i * 4);
+			const std::uint32_t pixel = std::uint32_t(rp[0]) | (std::uint32_t(rp[1]) << 8) | (std::uint32_t(rp[2]) << 16) | (std::uint32_t(rp[3]) << 24);
+			pixelBitFieldstoRGBA(pixel, dst + (i * BYTE_PER_PIXEL_RGBA8888), fields);
+		}
+	}
+
+	//マスク→アルファ(グレー+アルファ→RGBAも同様)の後にR,G,Bへアルファを乗算(同じ命令セットの関数を組み合わせる)
+	//書き込んだ行がキャッシュに残るうちに乗算するため、CHUNK_NUMピクセル毎に交互に処理
+	template <std::int32_t SRC_BYTE, dw::DWPixelConv::RowFunc WRITE_ALPHA, dw::DWPixelConv::RowFunc PREMUL>
+	void rowMaskToPremulAlpha(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		static const std::int32_t CHUNK_NUM = 256;
+		for (std::int32_t i = 0; i < width; i += CHUNK_NUM) {
+			const std::int32_t num = ((width - i) < CHUNK_NUM) ? (width - i) : CHUNK_NUM;
+			std::uint8_t* const wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+			WRITE_ALPHA(src + (i * SRC_BYTE), wp, num);
+			PREMUL(wp, wp, num);
+		}
+	}
+
+	//RGBA→16bit(上位からR_BIT,G_BIT,B_BIT,A_BITビット、A_BITが0ならアルファなし、各チャンネルは四捨五入で量子化)
+	template <std::int32_t R_BIT, std::int32_t G_BIT, std::int32_t B_BIT, std::int32_t A_BIT>
+	void rowPackRGBAto16_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			const std::uint8_t* rp = src + (i * BYTE_PER_PIXEL_RGBA8888);
+			const std::uint32_t r = div255(rp[0] * ((1U << R_BIT) - 1U));
+			const std::uint32_t g = div255(rp[1] * ((1U << G_BIT) - 1U));
+			const std::uint32_t b = div255(rp[2] * ((1U << B_BIT) - 1U));
+			const std::uint32_t a = div255(rp[3] * ((1U << A_BIT) - 1U));
+			const std::uint16_t pixel = static_cast<std::uint16_t>((r << (G_BIT + B_BIT + A_BIT)) | (g << (B_BIT + A_BIT)) | (b << A_BIT) | a);
+			memcpy(dst + (i * 2), &pixel, sizeof(pixel));
+		}
+	}
+
+	//RGBA→A8(アルファのみ取り出す)
+	void rowPackRGBAtoA8_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			dst[i] = src[(i * BYTE_PER_PIXEL_RGBA8888) + 3];
+		}
+	}
+
+	//RGBA→L8(輝度はBT.601の整数係数、(77 * R + 150 * G + 29 * B + 128) >> 8、グレーはそのまま)
+	void rowPackRGBAtoL8_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			const std::uint8_t* rp = src + (i * BYTE_PER_PIXEL_RGBA8888);
+			dst[i] = static_cast<std::uint8_t>(((77U * rp[0]) + (150U * rp[1]) + (29U * rp[2]) + 128U) >> 8);
+		}
+	}
+
+	//コンパイル時の整数列(0,1,...,N-1)
+	template <std::int32_t... I>
+	struct IndexSequence {
+	};
+	template <std::int32_t N, std::int32_t... I>
+	struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {
+	};
+	template <std::int32_t... I>
+	struct MakeIndexSequence<0, I...> {
+		typedef IndexSequence<I...> Type;
+	};
+
+	//1バイトに含まれるBIT_DEPTHビットのインデックスを、p番目以降1バイトずつ下位から並べた値(上位ビットが先頭ピクセル)
+	template <std::int32_t BIT_DEPTH>
+	constexpr std::uint64_t expandIndex(const std::int32_t byte, const std::int32_t p)
+	{
+		return (p >= (8 / BIT_DEPTH)) ? 0U :
+			((static_cast<std::uint64_t>((byte >> (8 - (BIT_DEPTH * (p + 1)))) & ((1 << BIT_DEPTH) - 1)) << (p * 8)) | expandIndex<BIT_DEPTH>(byte, p + 1));
+	}
+
+	//1バイト→8/BIT_DEPTHピクセル分のインデックスの展開テーブル(コンパイル時に生成)
+	template <std::int32_t BIT_DEPTH, typename SEQUENCE = typename MakeIndexSequence<256>::Type>
+	struct IndexExpandTable;
+	template <std::int32_t BIT_DEPTH, std::int32_t... I>
+	struct IndexExpandTable<BIT_DEPTH, IndexSequence<I...>> {
+		static constexpr std::uint64_t TABLE[sizeof...(I)] = { expandIndex<BIT_DEPTH>(I, 0)... };
+	};
+	template <std::int32_t BIT_DEPTH, std::int32_t... I>
+	constexpr std::uint64_t IndexExpandTable<BIT_DEPTH, IndexSequence<I...>>::TABLE[sizeof...(I)];
+
+	static_assert(IndexExpandTable<1>::TABLE[0xA5] == 0x0100010000010001ULL, "1bit index expand table");
+	static_assert(IndexExpandTable<2>::TABLE[0x1B] == 0x03020100ULL, "2bit index expand table");
+	static_assert(IndexExpandTable<4>::TABLE[0xF1] == 0x010FULL, "4bit index expand table");
+
+	//BIT_DEPTHビットのインデックス(上位ビットから)→RGBA(1バイトを展開テーブルで8/BIT_DEPTHピクセルへ展開)
+	template <std::int32_t BIT_DEPTH>
+	void rowIndexToRGBA_scalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint32_t* const colors)
+	{
+		static const std::int32_t PIXEL_PER_BYTE = 8 / BIT_DEPTH;
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		std::int32_t i = 0;
+		for (; (i + PIXEL_PER_BYTE) <= width; i += PIXEL_PER_BYTE) {
+			const std::uint64_t indexes = IndexExpandTable<BIT_DEPTH>::TABLE[*rp++];
+			for (std::int32_t p = 0; p < PIXEL_PER_BYTE; p++) {
+				memcpy(wp, &colors[(indexes >> (p * 8)) & 0xFF], BYTE_PER_PIXEL_RGBA8888);
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+		}
+		if (i < width) {
+			//行末の1バイト(使用するピクセルのみ書き込む)
+			const std::uint64_t indexes = IndexExpandTable<BIT_DEPTH>::TABLE[*rp];
+			for (std::int32_t p = 0; i < width; i++, p++) {
+				memcpy(wp, &colors[(indexes >> (p * 8)) & 0xFF], BYTE_PER_PIXEL_RGBA8888);
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+		}
+	}
+
+	//8bitのインデックス→RGBA(展開不要)
+	template <>
+	void rowIndexToRGBA_scalar<8>(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint32_t* const colors)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			memcpy(dst + (i * BYTE_PER_PIXEL_RGBA8888), &colors[src[i]], BYTE_PER_PIXEL_RGBA8888);
+		}
+	}
+
+#if defined(DW_PIXELCONV_X86)
+	//----------------------------------------------------------------
+	// SSSE3版(pshufbで4ピクセル=16バイト単位に並べ替え)
+
+	//3バイト→4バイト展開(shuffleで並べ替え、アルファは255)
+	DW_TARGET_SSSE3 inline std::int32_t rowExpand3_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const __m128i shuffle)
+	{
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000U));
+
+		//16バイト読み込みで12バイト使用するため、行末を読み越さない範囲まで処理
+		std::int32_t i = 0;
+		for (; (i + 18) <= width; i += 16) {
+			const std::uint8_t* rp = src + (i * 3);
+			std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+			const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 0));
+			const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 12));
+			const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 24));
+			const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 36));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 0), _mm_or_si128(_mm_shuffle_epi8(v0, shuffle), alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 16), _mm_or_si128(_mm_shuffle_epi8(v1, shuffle), alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 32), _mm_or_si128(_mm_shuffle_epi8(v2, shuffle), alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 48), _mm_or_si128(_mm_shuffle_epi8(v3, shuffle), alpha));
+		}
+		for (; (i + 6) <= width; i += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 3)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+		}
+
+		//処理済みピクセル数
+		return i;
+	}
+
+	//RGB→RGBA
+	DW_TARGET_SSSE3 void rowRGBtoRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const std::int32_t i = rowExpand3_ssse3(src, dst, width, shuffle);
+		rowRGBtoRGBA_scalar(src + (i * 3), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//BGR→RGBA
+	DW_TARGET_SSSE3 void rowBGRtoRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const std::int32_t i = rowExpand3_ssse3(src, dst, width, shuffle);
+		rowBGRtoRGBA_scalar(src + (i * 3), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//BGRA→RGBA
+	DW_TARGET_SSSE3 void rowBGRAtoRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 4) <= width; i += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 4)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), _mm_shuffle_epi8(v, shuffle));
+		}
+		rowBGRAtoRGBA_scalar(src + (i * 4), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//4ピクセル(RGBA)のR,G,Bにアルファを乗算(16bitへ広げ、(c * a + 128) * 257 >> 16で255除算)
+	DW_TARGET_SSSE3 inline __m128i premul_ssse3(const __m128i v)
+	{
+		//各ピクセルのアルファをR,G,Bの位置へ複製、アルファの位置は255(アルファはそのまま)
+		const __m128i shuffleLo = _mm_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1);
+		const __m128i shuffleHi = _mm_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1);
+		const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+		const __m128i bias = _mm_set1_epi16(128);
+		const __m128i div = _mm_set1_epi16(257);
+		const __m128i zero = _mm_setzero_si128();
+
+		const __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), _mm_or_si128(_mm_shuffle_epi8(v, shuffleLo), alphaOne));
+		const __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), _mm_or_si128(_mm_shuffle_epi8(v, shuffleHi), alphaOne));
+		return _mm_packus_epi16(_mm_mulhi_epu16(_mm_add_epi16(lo, bias), div), _mm_mulhi_epu16(_mm_add_epi16(hi, bias), div));
+	}
+
+	//RGBA(R_CHANNELが2ならBGRA)→乗算済みRGBA
+	template <std::int32_t R_CHANNEL>
+	DW_TARGET_SSSE3 void rowToPremulRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 4) <= width; i += 4) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 4)));
+			if (R_CHANNEL == 2) {
+				v = _mm_shuffle_epi8(v, shuffle);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), premul_ssse3(v));
+		}
+		rowToPremulRGBA_scalar<R_CHANNEL>(src + (i * 4), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//4ピクセル分のアルファ(各32bitの最上位バイト、他は0)を書き込み先へ合成
+	DW_TARGET_SSSE3 inline void storeAlpha_ssse3(std::uint8_t* const wp, const __m128i alpha)
+	{
+		const __m128i keep = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(wp));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(wp), _mm_or_si128(_mm_and_si128(v, keep), alpha));
+	}
+
+	//マスク→アルファ(マスクの値を各ピクセルの最上位バイトへ移して合成)
+	template <std::int32_t SRC_BYTE, std::int32_t CHANNEL>
+	DW_TARGET_SSSE3 void rowMaskToAlpha_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		std::int32_t i = 0;
+		if (SRC_BYTE == 1) {
+			//16ピクセル単位(0を下位に挟んで8bit→32bitへ広げる)
+			for (; (i + 16) <= width; i += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				const __m128i lo = _mm_unpacklo_epi8(zero, v);
+				const __m128i hi = _mm_unpackhi_epi8(zero, v);
+				std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+				storeAlpha_ssse3(wp + 0, _mm_unpacklo_epi16(zero, lo));
+				storeAlpha_ssse3(wp + 16, _mm_unpackhi_epi16(zero, lo));
+				storeAlpha_ssse3(wp + 32, _mm_unpacklo_epi16(zero, hi));
+				storeAlpha_ssse3(wp + 48, _mm_unpackhi_epi16(zero, hi));
+			}
+		}
+		else if (SRC_BYTE == 2) {
+			//8ピクセル単位(16bitを32bitの上位へ置き、先頭バイト(グレー)を最上位へ)
+			for (; (i + 8) <= width; i += 8) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 2)));
+				std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+				storeAlpha_ssse3(wp + 0, _mm_slli_epi32(_mm_unpacklo_epi16(zero, v), 8));
+				storeAlpha_ssse3(wp + 16, _mm_slli_epi32(_mm_unpackhi_epi16(zero, v), 8));
+			}
+		}
+		else if (SRC_BYTE == 3) {
+			//4ピクセル単位(pshufbで3バイト毎のCHANNEL番目を最上位へ、行末を読み越さない範囲まで処理)
+			const __m128i shuffle = _mm_setr_epi8(
+				-1, -1, -1, CHANNEL, -1, -1, -1, 3 + CHANNEL, -1, -1, -1, 6 + CHANNEL, -1, -1, -1, 9 + CHANNEL);
+			for (; (i + 6) <= width; i += 4) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 3)));
+				storeAlpha_ssse3(dst + (i * BYTE_PER_PIXEL_RGBA8888), _mm_shuffle_epi8(v, shuffle));
+			}
+		}
+		else {
+			//4ピクセル単位(CHANNEL番目を最上位へシフト)
+			for (; (i + 4) <= width; i += 4) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 4)));
+				storeAlpha_ssse3(dst + (i * BYTE_PER_PIXEL_RGBA8888), _mm_slli_epi32(_mm_srli_epi32(v, CHANNEL * 8), 24));
+			}
+		}
+		rowMaskToAlpha_scalar<SRC_BYTE, CHANNEL>(src + (i * SRC_BYTE), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//16bitビットフィールド→RGBA(8ピクセル単位、チャンネルを16bit上詰めにしてpmulhuwで8bitへ拡張)
+	DW_TARGET_SSSE3 void rowBitFields16toRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const dw::DWPixelConv::BitFields& fields)
+	{
+		__m128i count[4];
+		__m128i mask[4];
+		__m128i scale[4];
+		for (std::int32_t c = 0; c < 4; c++) {
+			const std::int32_t bitNum = fields.bitNum_[c];
+			count[c] = _mm_cvtsi32_si128(16 - fields.shift_[c] - bitNum);
+			mask[c] = _mm_set1_epi16(static_cast<short>(((1U << bitNum) - 1U) << (16 - bitNum)));
+			scale[c] = _mm_set1_epi16(static_cast<short>(fields.scale_[c]));
+		}
+		const __m128i alpha = _mm_set1_epi16(255);
+
+		std::int32_t i = 0;
+		for (; (i + 8) <= width; i += 8) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 2)));
+			const __m128i r = _mm_mulhi_epu16(_mm_and_si128(_mm_sll_epi16(v, count[0]), mask[0]), scale[0]);
+			const __m128i g = _mm_mulhi_epu16(_mm_and_si128(_mm_sll_epi16(v, count[1]), mask[1]), scale[1]);
+			const __m128i b = _mm_mulhi_epu16(_mm_and_si128(_mm_sll_epi16(v, count[2]), mask[2]), scale[2]);
+			const __m128i a = (fields.isAlpha_) ? _mm_mulhi_epu16(_mm_and_si128(_mm_sll_epi16(v, count[3]), mask[3]), scale[3]) : alpha;
+
+			//RG,BAの16bitを組にして32bitへ並べる
+			const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+			const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+			std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 0), _mm_unpacklo_epi16(rg, ba));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 16), _mm_unpackhi_epi16(rg, ba));
+		}
+		rowBitFields16toRGBA_scalar(src + (i * 2), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i, fields);
+	}
+
+	//32bitビットフィールド→RGBA(4ピクセル単位、チャンネルを32bitの下位16bitに上詰めしてpmulhuwで8bitへ拡張)
+	DW_TARGET_SSSE3 void rowBitFields32toRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const dw::DWPixelConv::BitFields& fields)
+	{
+		__m128i shift[4];
+		__m128i count[4];
+		__m128i mask[4];
+		__m128i scale[4];
+		for (std::int32_t c = 0; c < 4; c++) {
+			const std::int32_t bitNum = fields.bitNum_[c];
+			shift[c] = _mm_cvtsi32_si128(fields.shift_[c]);
+			count[c] = _mm_cvtsi32_si128(16 - bitNum);
+			mask[c] = _mm_set1_epi32(static_cast<int>((1U << bitNum) - 1U));
+			scale[c] = _mm_set1_epi32(fields.scale_[c]);
+		}
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>((fields.isAlpha_) ? 0U : 0xFF000000U));
+
+		std::int32_t i = 0;
+		for (; (i + 4) <= width; i += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 4)));
+			__m128i rgba = alpha;
+			for (std::int32_t c = 0; c < 4; c++) {
+				const __m128i value = _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(v, shift[c]), mask[c]), count[c]);
+				rgba = _mm_or_si128(rgba, _mm_sll_epi32(_mm_mulhi_epu16(value, scale[c]), _mm_cvtsi32_si128(c * 8)));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), rgba);
+		}
+		rowBitFields32toRGBA_scalar(src + (i * 4), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i, fields);
+	}
+
+	//2ピクセル(16bit×8)の各チャンネルを量子化((c * 最大値 + 128) * 257 >> 16)し、乗算でビット位置へ移す
+	DW_TARGET_SSSE3 inline __m128i quantize_ssse3(const __m128i v, const __m128i maxValue, const __m128i position)
+	{
+		const __m128i bias = _mm_set1_epi16(128);
+		const __m128i div = _mm_set1_epi16(257);
+		return _mm_mullo_epi16(_mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(v, maxValue), bias), div), position);
+	}
+
+	//RGBA→16bit(8ピクセル単位、チャンネルのビットは重ならないのでphaddwの加算で1ピクセルへまとめる)
+	template <std::int32_t R_BIT, std::int32_t G_BIT, std::int32_t B_BIT, std::int32_t A_BIT>
+	DW_TARGET_SSSE3 void rowPackRGBAto16_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i maxValue = _mm_setr_epi16(
+			(1 << R_BIT) - 1, (1 << G_BIT) - 1, (1 << B_BIT) - 1, (1 << A_BIT) - 1,
+			(1 << R_BIT) - 1, (1 << G_BIT) - 1, (1 << B_BIT) - 1, (1 << A_BIT) - 1);
+		const __m128i position = _mm_setr_epi16(
+			static_cast<short>(1 << (G_BIT + B_BIT + A_BIT)), 1 << (B_BIT + A_BIT), 1 << A_BIT, 1,
+			static_cast<short>(1 << (G_BIT + B_BIT + A_BIT)), 1 << (B_BIT + A_BIT), 1 << A_BIT, 1);
+		const __m128i zero = _mm_setzero_si128();
+
+		std::int32_t i = 0;
+		for (; (i + 8) <= width; i += 8) {
+			const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * BYTE_PER_PIXEL_RGBA8888)));
+			const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + ((i + 4) * BYTE_PER_PIXEL_RGBA8888)));
+			const __m128i h0 = _mm_hadd_epi16(quantize_ssse3(_mm_unpacklo_epi8(v0, zero), maxValue, position), quantize_ssse3(_mm_unpackhi_epi8(v0, zero), maxValue, position));
+			const __m128i h1 = _mm_hadd_epi16(quantize_ssse3(_mm_unpacklo_epi8(v1, zero), maxValue, position), quantize_ssse3(_mm_unpackhi_epi8(v1, zero), maxValue, position));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * 2)), _mm_hadd_epi16(h0, h1));
+		}
+		rowPackRGBAto16_scalar<R_BIT, G_BIT, B_BIT, A_BIT>(src + (i * BYTE_PER_PIXEL_RGBA8888), dst + (i * 2), width - i);
+	}
+
+	//RGBA→A8(16ピクセル単位、4ピクセル毎のアルファを4バイトずつ並べて合成)
+	DW_TARGET_SSSE3 void rowPackRGBAtoA8_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffle0 = _mm_setr_epi8(3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i shuffle1 = _mm_setr_epi8(-1, -1, -1, -1, 3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i shuffle2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 3, 7, 11, 15, -1, -1, -1, -1);
+		const __m128i shuffle3 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, 7, 11, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 16) <= width; i += 16) {
+			const __m128i* rp = reinterpret_cast<const __m128i*>(src + (i * BYTE_PER_PIXEL_RGBA8888));
+			const __m128i a01 = _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128(rp + 0), shuffle0), _mm_shuffle_epi8(_mm_loadu_si128(rp + 1), shuffle1));
+			const __m128i a23 = _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128(rp + 2), shuffle2), _mm_shuffle_epi8(_mm_loadu_si128(rp + 3), shuffle3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(a01, a23));
+		}
+		rowPackRGBAtoA8_scalar(src + (i * BYTE_PER_PIXEL_RGBA8888), dst + i, width - i);
+	}
+
+	//4ピクセル(RGBA)の輝度を32bit×4で算出(pmaddwdでR,GとBの積和、phadddで1ピクセルへまとめる)
+	DW_TARGET_SSSE3 inline __m128i luma_ssse3(const __m128i v)
+	{
+		const __m128i weight = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+		const __m128i bias = _mm_set1_epi32(128);
+		const __m128i zero = _mm_setzero_si128();
+
+		const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weight);
+		const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weight);
+		return _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), bias), 8);
+	}
+
+	//RGBA→L8(16ピクセル単位)
+	DW_TARGET_SSSE3 void rowPackRGBAtoL8_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		std::int32_t i = 0;
+		for (; (i + 16) <= width; i += 16) {
+			const __m128i* rp = reinterpret_cast<const __m128i*>(src + (i * BYTE_PER_PIXEL_RGBA8888));
+			const __m128i y01 = _mm_packs_epi32(luma_ssse3(_mm_loadu_si128(rp + 0)), luma_ssse3(_mm_loadu_si128(rp + 1)));
+			const __m128i y23 = _mm_packs_epi32(luma_ssse3(_mm_loadu_si128(rp + 2)), luma_ssse3(_mm_loadu_si128(rp + 3)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(y01, y23));
+		}
+		rowPackRGBAtoL8_scalar(src + (i * BYTE_PER_PIXEL_RGBA8888), dst + i, width - i);
+	}
+
+	//グレー+アルファ→RGBA(8ピクセル単位)
+	DW_TARGET_SSSE3 void rowGrayAlphatoRGBA_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffleLo = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+		const __m128i shuffleHi = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 8) <= width; i += 8) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 2)));
+			std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 0), _mm_shuffle_epi8(v, shuffleLo));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 16), _mm_shuffle_epi8(v, shuffleHi));
+		}
+		rowGrayAlphatoRGBA_scalar(src + (i * 2), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//16bitサンプル(ビッグエンディアン)8個→8bit(バイトを入れ替えて、飽和加算(v + 128)の65281倍の上位16bitを8bit右シフト)
+	DW_TARGET_SSSE3 inline __m128i reduce16_ssse3(const __m128i v)
+	{
+		const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		const __m128i t = _mm_adds_epu16(_mm_shuffle_epi8(v, swap), _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_mulhi_epu16(t, _mm_set1_epi16(static_cast<short>(65281))), 8);
+	}
+
+	//16bitサンプル→8bit(16サンプル単位)
+	DW_TARGET_SSSE3 void rowReduce16to8_ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		std::int32_t i = 0;
+		for (; (i + 16) <= width; i += 16) {
+			const __m128i* rp = reinterpret_cast<const __m128i*>(src + (i * 2));
+			const __m128i lo = reduce16_ssse3(_mm_loadu_si128(rp + 0));
+			const __m128i hi = reduce16_ssse3(_mm_loadu_si128(rp + 1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+		}
+		rowReduce16to8_scalar(src + (i * 2), dst + i, width - i);
+	}
+
+	//----------------------------------------------------------------
+	// AVX2版(vpshufbで8ピクセル=32バイト単位に並べ替え)
+
+	//3バイト→4バイト展開(shuffleで128bitレーン毎に並べ替え、アルファは255)
+	DW_TARGET_AVX2 inline std::int32_t rowExpand3_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const __m256i shuffle)
+	{
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000U));
+
+		//レーン毎に12バイト(4ピクセル)を配置、行末を読み越さない範囲まで処理
+		std::int32_t i = 0;
+		for (; (i + 10) <= width; i += 8) {
+			const std::uint8_t* rp = src + (i * 3);
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 0));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 12));
+			const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+		}
+
+		//処理済みピクセル数
+		return i;
+	}
+
+	//RGB→RGBA
+	DW_TARGET_AVX2 void rowRGBtoRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const std::int32_t i = rowExpand3_avx2(src, dst, width, shuffle);
+		rowRGBtoRGBA_scalar(src + (i * 3), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//BGR→RGBA
+	DW_TARGET_AVX2 void rowBGRtoRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const std::int32_t i = rowExpand3_avx2(src, dst, width, shuffle);
+		rowBGRtoRGBA_scalar(src + (i * 3), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//BGRA→RGBA
+	DW_TARGET_AVX2 void rowBGRAtoRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 8) <= width; i += 8) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * 4)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), _mm256_shuffle_epi8(v, shuffle));
+		}
+		rowBGRAtoRGBA_scalar(src + (i * 4), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//8ピクセル(RGBA)のR,G,Bにアルファを乗算(unpackとpackは128bitレーン毎なので、ピクセルの順序は変わらない)
+	DW_TARGET_AVX2 inline __m256i premul_avx2(const __m256i v)
+	{
+		const __m256i shuffleLo = _mm256_setr_epi8(
+			3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1,
+			3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1);
+		const __m256i shuffleHi = _mm256_setr_epi8(
+			11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1,
+			11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1);
+		const __m256i alphaOne = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+		const __m256i bias = _mm256_set1_epi16(128);
+		const __m256i div = _mm256_set1_epi16(257);
+		const __m256i zero = _mm256_setzero_si256();
+
+		const __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(v, zero), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffleLo), alphaOne));
+		const __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(v, zero), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffleHi), alphaOne));
+		return _mm256_packus_epi16(_mm256_mulhi_epu16(_mm256_add_epi16(lo, bias), div), _mm256_mulhi_epu16(_mm256_add_epi16(hi, bias), div));
+	}
+
+	//RGBA(R_CHANNELが2ならBGRA)→乗算済みRGBA
+	template <std::int32_t R_CHANNEL>
+	DW_TARGET_AVX2 void rowToPremulRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 8) <= width; i += 8) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * 4)));
+			if (R_CHANNEL == 2) {
+				v = _mm256_shuffle_epi8(v, shuffle);
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), premul_avx2(v));
+		}
+		rowToPremulRGBA_scalar<R_CHANNEL>(src + (i * 4), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//8ピクセル分のアルファ(各32bitの最上位バイト、他は0)を書き込み先へ合成
+	DW_TARGET_AVX2 inline void storeAlpha_avx2(std::uint8_t* const wp, const __m256i alpha)
+	{
+		const __m256i keep = _mm256_set1_epi32(0x00FFFFFF);
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wp));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp), _mm256_or_si256(_mm256_and_si256(v, keep), alpha));
+	}
+
+	//マスク→アルファ(8ピクセル単位)
+	template <std::int32_t SRC_BYTE, std::int32_t CHANNEL>
+	DW_TARGET_AVX2 void rowMaskToAlpha_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		std::int32_t i = 0;
+		if (SRC_BYTE == 1) {
+			//8bit→32bitへゼロ拡張して最上位へ
+			for (; (i + 8) <= width; i += 8) {
+				const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+				storeAlpha_avx2(dst + (i * BYTE_PER_PIXEL_RGBA8888), _mm256_slli_epi32(_mm256_cvtepu8_epi32(v), 24));
+			}
+		}
+		else if (SRC_BYTE == 2) {
+			//16bit→32bitへゼロ拡張して先頭バイト(グレー)を最上位へ
+			for (; (i + 8) <= width; i += 8) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 2)));
+				storeAlpha_avx2(dst + (i * BYTE_PER_PIXEL_RGBA8888), _mm256_slli_epi32(_mm256_cvtepu16_epi32(v), 24));
+			}
+		}
+		else if (SRC_BYTE == 3) {
+			//レーン毎に12バイト(4ピクセル)を配置してpshufb、行末を読み越さない範囲まで処理
+			const __m256i shuffle = _mm256_setr_epi8(
+				-1, -1, -1, CHANNEL, -1, -1, -1, 3 + CHANNEL, -1, -1, -1, 6 + CHANNEL, -1, -1, -1, 9 + CHANNEL,
+				-1, -1, -1, CHANNEL, -1, -1, -1, 3 + CHANNEL, -1, -1, -1, 6 + CHANNEL, -1, -1, -1, 9 + CHANNEL);
+			for (; (i + 10) <= width; i += 8) {
+				const std::uint8_t* rp = src + (i * 3);
+				const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 0));
+				const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 12));
+				const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+				storeAlpha_avx2(dst + (i * BYTE_PER_PIXEL_RGBA8888), _mm256_shuffle_epi8(v, shuffle));
+			}
+		}
+		else {
+			//CHANNEL番目を最上位へシフト
+			for (; (i + 8) <= width; i += 8) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * 4)));
+				storeAlpha_avx2(dst + (i * BYTE_PER_PIXEL_RGBA8888), _mm256_slli_epi32(_mm256_srli_epi32(v, CHANNEL * 8), 24));
+			}
+		}
+		rowMaskToAlpha_scalar<SRC_BYTE, CHANNEL>(src + (i * SRC_BYTE), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//16bitビットフィールド→RGBA(16ピクセル単位)
+	DW_TARGET_AVX2 void rowBitFields16toRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const dw::DWPixelConv::BitFields& fields)
+	{
+		__m128i count[4];
+		__m256i mask[4];
+		__m256i scale[4];
+		for (std::int32_t c = 0; c < 4; c++) {
+			const std::int32_t bitNum = fields.bitNum_[c];
+			count[c] = _mm_cvtsi32_si128(16 - fields.shift_[c] - bitNum);
+			mask[c] = _mm256_set1_epi16(static_cast<short>(((1U << bitNum) - 1U) << (16 - bitNum)));
+			scale[c] = _mm256_set1_epi16(static_cast<short>(fields.scale_[c]));
+		}
+		const __m256i alpha = _mm256_set1_epi16(255);
+
+		std::int32_t i = 0;
+		for (; (i + 16) <= width; i += 16) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * 2)));
+			const __m256i r = _mm256_mulhi_epu16(_mm256_and_si256(_mm256_sll_epi16(v, count[0]), mask[0]), scale[0]);
+			const __m256i g = _mm256_mulhi_epu16(_mm256_and_si256(_mm256_sll_epi16(v, count[1]), mask[1]), scale[1]);
+			const __m256i b = _mm256_mulhi_epu16(_mm256_and_si256(_mm256_sll_epi16(v, count[2]), mask[2]), scale[2]);
+			const __m256i a = (fields.isAlpha_) ? _mm256_mulhi_epu16(_mm256_and_si256(_mm256_sll_epi16(v, count[3]), mask[3]), scale[3]) : alpha;
+
+			//RG,BAの16bitを組にして32bitへ並べる(unpackは128bitレーン毎のため、レーンを入れ替えて順序を戻す)
+			const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+			const __m256i ba = _mm256_or_si256(b, _mm256_slli_epi16(a, 8));
+			const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+			const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+			std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp + 0), _mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+		rowBitFields16toRGBA_scalar(src + (i * 2), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i, fields);
+	}
+
+	//32bitビットフィールド→RGBA(8ピクセル単位)
+	DW_TARGET_AVX2 void rowBitFields32toRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const dw::DWPixelConv::BitFields& fields)
+	{
+		__m128i shift[4];
+		__m128i count[4];
+		__m256i mask[4];
+		__m256i scale[4];
+		for (std::int32_t c = 0; c < 4; c++) {
+			const std::int32_t bitNum = fields.bitNum_[c];
+			shift[c] = _mm_cvtsi32_si128(fields.shift_[c]);
+			count[c] = _mm_cvtsi32_si128(16 - bitNum);
+			mask[c] = _mm256_set1_epi32(static_cast<int>((1U << bitNum) - 1U));
+			scale[c] = _mm256_set1_epi32(fields.scale_[c]);
+		}
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>((fields.isAlpha_) ? 0U : 0xFF000000U));
+
+		std::int32_t i = 0;
+		for (; (i + 8) <= width; i += 8) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * 4)));
+			__m256i rgba = alpha;
+			for (std::int32_t c = 0; c < 4; c++) {
+				const __m256i value = _mm256_sll_epi32(_mm256_and_si256(_mm256_srl_epi32(v, shift[c]), mask[c]), count[c]);
+				rgba = _mm256_or_si256(rgba, _mm256_sll_epi32(_mm256_mulhi_epu16(value, scale[c]), _mm_cvtsi32_si128(c * 8)));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (i * BYTE_PER_PIXEL_RGBA8888)), rgba);
+		}
+		rowBitFields32toRGBA_scalar(src + (i * 4), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i, fields);
+	}
+
+	//4ピクセル(16bit×16)の各チャンネルを量子化し、乗算でビット位置へ移す
+	DW_TARGET_AVX2 inline __m256i quantize_avx2(const __m256i v, const __m256i maxValue, const __m256i position)
+	{
+		const __m256i bias = _mm256_set1_epi16(128);
+		const __m256i div = _mm256_set1_epi16(257);
+		return _mm256_mullo_epi16(_mm256_mulhi_epu16(_mm256_add_epi16(_mm256_mullo_epi16(v, maxValue), bias), div), position);
+	}
+
+	//RGBA→16bit(16ピクセル単位、phaddwは128bitレーン毎なので最後に64bit単位で並べ直す)
+	template <std::int32_t R_BIT, std::int32_t G_BIT, std::int32_t B_BIT, std::int32_t A_BIT>
+	DW_TARGET_AVX2 void rowPackRGBAto16_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i maxValue = _mm256_setr_epi16(
+			(1 << R_BIT) - 1, (1 << G_BIT) - 1, (1 << B_BIT) - 1, (1 << A_BIT) - 1,
+			(1 << R_BIT) - 1, (1 << G_BIT) - 1, (1 << B_BIT) - 1, (1 << A_BIT) - 1,
+			(1 << R_BIT) - 1, (1 << G_BIT) - 1, (1 << B_BIT) - 1, (1 << A_BIT) - 1,
+			(1 << R_BIT) - 1, (1 << G_BIT) - 1, (1 << B_BIT) - 1, (1 << A_BIT) - 1);
+		const __m256i position = _mm256_setr_epi16(
+			static_cast<short>(1 << (G_BIT + B_BIT + A_BIT)), 1 << (B_BIT + A_BIT), 1 << A_BIT, 1,
+			static_cast<short>(1 << (G_BIT + B_BIT + A_BIT)), 1 << (B_BIT + A_BIT), 1 << A_BIT, 1,
+			static_cast<short>(1 << (G_BIT + B_BIT + A_BIT)), 1 << (B_BIT + A_BIT), 1 << A_BIT, 1,
+			static_cast<short>(1 << (G_BIT + B_BIT + A_BIT)), 1 << (B_BIT + A_BIT), 1 << A_BIT, 1);
+		const __m256i zero = _mm256_setzero_si256();
+
+		std::int32_t i = 0;
+		for (; (i + 16) <= width; i += 16) {
+			const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * BYTE_PER_PIXEL_RGBA8888)));
+			const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + ((i + 8) * BYTE_PER_PIXEL_RGBA8888)));
+			const __m256i h0 = _mm256_hadd_epi16(quantize_avx2(_mm256_unpacklo_epi8(v0, zero), maxValue, position), quantize_avx2(_mm256_unpackhi_epi8(v0, zero), maxValue, position));
+			const __m256i h1 = _mm256_hadd_epi16(quantize_avx2(_mm256_unpacklo_epi8(v1, zero), maxValue, position), quantize_avx2(_mm256_unpackhi_epi8(v1, zero), maxValue, position));
+			//レーン0は0～3,8～11、レーン1は4～7,12～15ピクセル目
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_hadd_epi16(h0, h1), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (i * 2)), packed);
+		}
+		rowPackRGBAto16_scalar<R_BIT, G_BIT, B_BIT, A_BIT>(src + (i * BYTE_PER_PIXEL_RGBA8888), dst + (i * 2), width - i);
+	}
+
+	//RGBA→A8(32ピクセル単位、128bitレーン毎に並べてから32bit単位で並べ直す)
+	DW_TARGET_AVX2 void rowPackRGBAtoA8_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle0 = _mm256_setr_epi8(
+			3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m256i shuffle1 = _mm256_setr_epi8(
+			-1, -1, -1, -1, 3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, 3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m256i shuffle2 = _mm256_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, 3, 7, 11, 15, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, 3, 7, 11, 15, -1, -1, -1, -1);
+		const __m256i shuffle3 = _mm256_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, 7, 11, 15,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, 7, 11, 15);
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+		std::int32_t i = 0;
+		for (; (i + 32) <= width; i += 32) {
+			const __m256i* rp = reinterpret_cast<const __m256i*>(src + (i * BYTE_PER_PIXEL_RGBA8888));
+			const __m256i a01 = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_loadu_si256(rp + 0), shuffle0), _mm256_shuffle_epi8(_mm256_loadu_si256(rp + 1), shuffle1));
+			const __m256i a23 = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_loadu_si256(rp + 2), shuffle2), _mm256_shuffle_epi8(_mm256_loadu_si256(rp + 3), shuffle3));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(_mm256_or_si256(a01, a23), order));
+		}
+		rowPackRGBAtoA8_scalar(src + (i * BYTE_PER_PIXEL_RGBA8888), dst + i, width - i);
+	}
+
+	//8ピクセル(RGBA)の輝度を32bit×8で算出(phadddは128bitレーン毎なので、ピクセルの順序は変わらない)
+	DW_TARGET_AVX2 inline __m256i luma_avx2(const __m256i v)
+	{
+		const __m256i weight = _mm256_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0, 77, 150, 29, 0, 77, 150, 29, 0);
+		const __m256i bias = _mm256_set1_epi32(128);
+		const __m256i zero = _mm256_setzero_si256();
+
+		const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(v, zero), weight);
+		const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(v, zero), weight);
+		return _mm256_srli_epi32(_mm256_add_epi32(_mm256_hadd_epi32(lo, hi), bias), 8);
+	}
+
+	//RGBA→L8(32ピクセル単位、packは128bitレーン毎なので最後に32bit単位で並べ直す)
+	DW_TARGET_AVX2 void rowPackRGBAtoL8_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+		std::int32_t i = 0;
+		for (; (i + 32) <= width; i += 32) {
+			const __m256i* rp = reinterpret_cast<const __m256i*>(src + (i * BYTE_PER_PIXEL_RGBA8888));
+			const __m256i y01 = _mm256_packs_epi32(luma_avx2(_mm256_loadu_si256(rp + 0)), luma_avx2(_mm256_loadu_si256(rp + 1)));
+			const __m256i y23 = _mm256_packs_epi32(luma_avx2(_mm256_loadu_si256(rp + 2)), luma_avx2(_mm256_loadu_si256(rp + 3)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(y01, y23), order));
+		}
+		rowPackRGBAtoL8_scalar(src + (i * BYTE_PER_PIXEL_RGBA8888), dst + i, width - i);
+	}
+
+	//グレー+アルファ→RGBA(16ピクセル単位、8ピクセル=16バイトを両レーンへ複製してレーン毎に4ピクセルずつ展開)
+	DW_TARGET_AVX2 void rowGrayAlphatoRGBA_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7,
+			8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+
+		std::int32_t i = 0;
+		for (; (i + 16) <= width; i += 16) {
+			//その場展開に対応するため、両方読み込んでから書き込む
+			const std::uint8_t* rp = src + (i * 2);
+			const __m256i v0 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 0)));
+			const __m256i v1 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 16)));
+			std::uint8_t* wp = dst + (i * BYTE_PER_PIXEL_RGBA8888);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp + 0), _mm256_shuffle_epi8(v0, shuffle));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp + 32), _mm256_shuffle_epi8(v1, shuffle));
+		}
+		rowGrayAlphatoRGBA_scalar(src + (i * 2), dst + (i * BYTE_PER_PIXEL_RGBA8888), width - i);
+	}
+
+	//16bitサンプル(ビッグエンディアン)16個→8bit(reduce16_ssse3と同じ計算)
+	DW_TARGET_AVX2 inline __m256i reduce16_avx2(const __m256i v)
+	{
+		const __m256i swap = _mm256_setr_epi8(
+			1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+			1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		const __m256i t = _mm256_adds_epu16(_mm256_shuffle_epi8(v, swap), _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_mulhi_epu16(t, _mm256_set1_epi16(static_cast<short>(65281))), 8);
+	}
+
+	//16bitサンプル→8bit(32サンプル単位、packは128bitレーン毎なので最後に64bit単位で並べ直す)
+	DW_TARGET_AVX2 void rowReduce16to8_avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		std::int32_t i = 0;
+		for (; (i + 32) <= width; i += 32) {
+			const __m256i* rp = reinterpret_cast<const __m256i*>(src + (i * 2));
+			const __m256i lo = reduce16_avx2(_mm256_loadu_si256(rp + 0));
+			const __m256i hi = reduce16_avx2(_mm256_loadu_si256(rp + 1));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+		rowReduce16to8_scalar(src + (i * 2), dst + i, width - i);
+	}
+
+	//----------------------------------------------------------------
+	// 命令セット判定
+
+	//実行中のCPUの命令セットを判定
+	dw::DWPixelConv::Isa detectIsa()
+	{
+		bool isSSSE3 = false;
+		bool isAVX2 = false;
+#if defined(_MSC_VER)
+		std::int32_t info[4] = { 0 };
+		__cpuid(info, 0);
+		const std::int32_t maxLeaf = info[0];
+		__cpuid(info, 1);
+		isSSSE3 = ((info[2] & (1 << 9)) != 0);
+		const bool isOSXSAVE = ((info[2] & (1 << 27)) != 0);
+		const bool isAVX = ((info[2] & (1 << 28)) != 0);
+		if ((maxLeaf >= 7) && (isOSXSAVE) && (isAVX)) {
+			//OSがYMMレジスタを保存する場合のみAVX2を使用
+			const bool isYMM = ((_xgetbv(0) & 0x6) == 0x6);
+			__cpuidex(info, 7, 0);
+			isAVX2 = (isYMM) && ((info[1] & (1 << 5)) != 0);
+		}
+#else
+		__builtin_cpu_init();
+		isSSSE3 = (__builtin_cpu_supports("ssse3") != 0);
+		isAVX2 = (__builtin_cpu_supports("avx2") != 0);
+#endif
+		if (isAVX2) {
+			return dw::DWPixelConv::Isa::AVX2;
+		}
+		if (isSSSE3) {
+			return dw::DWPixelConv::Isa::SSSE3;
+		}
+		return dw::DWPixelConv::Isa::SCALAR;
+	}
+#else
+	//実行中のCPUの命令セットを判定(x86以外はスカラーのみ)
+	dw::DWPixelConv::Isa detectIsa()
+	{
+		return dw::DWPixelConv::Isa::SCALAR;
+	}
+#endif
+}
+
+namespace dw {
+
+	//----------------------------------------------------------------
+	// DWPixelConvクラス
+	//----------------------------------------------------------------
+
+	//実行中のCPUで使用可能な最上位の命令セット取得
+	DWPixelConv::Isa DWPixelConv::getBestIsa()
+	{
+		//初回のみ判定
+		static const Isa bestIsa = detectIsa();
+		return bestIsa;
+	}
+
+	//命令セット名取得
+	const std::char8_t* DWPixelConv::getIsaName(const Isa isa)
+	{
+		const std::char8_t* name = "scalar";
+		switch (isa) {
+		case Isa::SSSE3:
+			name = "ssse3";
+			break;
+		case Isa::AVX2:
+			name = "avx2";
+			break;
+		default:
+			break;
+		}
+		return name;
+	}
+
+	//変換元の1ピクセルあたりのバイト数取得
+	std::int32_t DWPixelConv::getBytePerPixel(const Format format)
+	{
+		std::int32_t bytePerPixel = 4;
+		switch (format) {
+		case Format::RGB888:
+		case Format::BGR888:
+			bytePerPixel = 3;
+			break;
+		case Format::GRAY8:
+			bytePerPixel = 1;
+			break;
+		case Format::GRAYALPHA88:
+			bytePerPixel = 2;
+			break;
+		default:
+			break;
+		}
+		return bytePerPixel;
+	}
+
+	//RGBA8888への行変換関数取得(最上位の命令セット)
+	DWPixelConv::RowFunc DWPixelConv::getRowFunc(const Format format)
+	{
+		return getRowFunc(format, getBestIsa());
+	}
+
+	//RGBA8888への行変換関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::RowFunc DWPixelConv::getRowFunc(const Format format, const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//変換元フォーマット毎の行変換関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const RowFunc TABLE_RGB[] = { rowRGBtoRGBA_scalar, rowRGBtoRGBA_ssse3, rowRGBtoRGBA_avx2 };
+		static const RowFunc TABLE_BGR[] = { rowBGRtoRGBA_scalar, rowBGRtoRGBA_ssse3, rowBGRtoRGBA_avx2 };
+		static const RowFunc TABLE_BGRA[] = { rowBGRAtoRGBA_scalar, rowBGRAtoRGBA_ssse3, rowBGRAtoRGBA_avx2 };
+		static const RowFunc TABLE_GRAYALPHA[] = { rowGrayAlphatoRGBA_scalar, rowGrayAlphatoRGBA_ssse3, rowGrayAlphatoRGBA_avx2 };
+#else
+		static const RowFunc TABLE_RGB[] = { rowRGBtoRGBA_scalar };
+		static const RowFunc TABLE_BGR[] = { rowBGRtoRGBA_scalar };
+		static const RowFunc TABLE_BGRA[] = { rowBGRAtoRGBA_scalar };
+		static const RowFunc TABLE_GRAYALPHA[] = { rowGrayAlphatoRGBA_scalar };
+#endif
+
+		const std::int32_t isaNo = static_cast<std::int32_t>(isa);
+		RowFunc func = nullptr;
+		switch (format) {
+		case Format::RGB888:
+			func = TABLE_RGB[isaNo];
+			break;
+		case Format::BGR888:
+			func = TABLE_BGR[isaNo];
+			break;
+		case Format::BGRA8888:
+			func = TABLE_BGRA[isaNo];
+			break;
+		case Format::RGBA8888:
+			func = rowRGBAtoRGBA;
+			break;
+		case Format::GRAYALPHA88:
+			func = TABLE_GRAYALPHA[isaNo];
+			break;
+		default:
+			break;
+		}
+		return func;
+	}
+
+	//乗算済みアルファのRGBA8888への行変換関数取得(最上位の命令セット)
+	DWPixelConv::RowFunc DWPixelConv::getPremulRowFunc(const Format format)
+	{
+		return getPremulRowFunc(format, getBestIsa());
+	}
+
+	//乗算済みアルファのRGBA8888への行変換関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::RowFunc DWPixelConv::getPremulRowFunc(const Format format, const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//アルファありの変換元フォーマット毎の行変換関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const RowFunc TABLE_RGBA[] = { rowToPremulRGBA_scalar<0>, rowToPremulRGBA_ssse3<0>, rowToPremulRGBA_avx2<0> };
+		static const RowFunc TABLE_BGRA[] = { rowToPremulRGBA_scalar<2>, rowToPremulRGBA_ssse3<2>, rowToPremulRGBA_avx2<2> };
+		static const RowFunc TABLE_GRAYALPHA[] = {
+			rowMaskToPremulAlpha<2, rowGrayAlphatoRGBA_scalar, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<2, rowGrayAlphatoRGBA_ssse3, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<2, rowGrayAlphatoRGBA_avx2, rowToPremulRGBA_avx2<0> > };
+#else
+		static const RowFunc TABLE_RGBA[] = { rowToPremulRGBA_scalar<0> };
+		static const RowFunc TABLE_BGRA[] = { rowToPremulRGBA_scalar<2> };
+		static const RowFunc TABLE_GRAYALPHA[] = { rowMaskToPremulAlpha<2, rowGrayAlphatoRGBA_scalar, rowToPremulRGBA_scalar<0> > };
+#endif
+
+		const std::int32_t isaNo = static_cast<std::int32_t>(isa);
+		RowFunc func = nullptr;
+		switch (format) {
+		case Format::RGB888:
+		case Format::BGR888:
+			//アルファなし(255)は乗算しても同じ
+			func = getRowFunc(format, isa);
+			break;
+		case Format::RGBA8888:
+			func = TABLE_RGBA[isaNo];
+			break;
+		case Format::BGRA8888:
+			func = TABLE_BGRA[isaNo];
+			break;
+		case Format::GRAYALPHA88:
+			func = TABLE_GRAYALPHA[isaNo];
+			break;
+		default:
+			break;
+		}
+		return func;
+	}
+
+	//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込む関数取得(R,G,Bは変更しない、最上位の命令セット)
+	DWPixelConv::RowFunc DWPixelConv::getAlphaRowFunc(const Format format)
+	{
+		return getAlphaRowFunc(format, getBestIsa());
+	}
+
+	//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込む関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::RowFunc DWPixelConv::getAlphaRowFunc(const Format format, const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//変換元フォーマット毎のアルファ書き込み関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const RowFunc TABLE_GRAY[] = { rowMaskToAlpha_scalar<1, 0>, rowMaskToAlpha_ssse3<1, 0>, rowMaskToAlpha_avx2<1, 0> };
+		static const RowFunc TABLE_GRAYALPHA[] = { rowMaskToAlpha_scalar<2, 0>, rowMaskToAlpha_ssse3<2, 0>, rowMaskToAlpha_avx2<2, 0> };
+		static const RowFunc TABLE_RGB[] = { rowMaskToAlpha_scalar<3, 0>, rowMaskToAlpha_ssse3<3, 0>, rowMaskToAlpha_avx2<3, 0> };
+		static const RowFunc TABLE_BGR[] = { rowMaskToAlpha_scalar<3, 2>, rowMaskToAlpha_ssse3<3, 2>, rowMaskToAlpha_avx2<3, 2> };
+		static const RowFunc TABLE_RGBA[] = { rowMaskToAlpha_scalar<4, 0>, rowMaskToAlpha_ssse3<4, 0>, rowMaskToAlpha_avx2<4, 0> };
+		static const RowFunc TABLE_BGRA[] = { rowMaskToAlpha_scalar<4, 2>, rowMaskToAlpha_ssse3<4, 2>, rowMaskToAlpha_avx2<4, 2> };
+#else
+		static const RowFunc TABLE_GRAY[] = { rowMaskToAlpha_scalar<1, 0> };
+		static const RowFunc TABLE_GRAYALPHA[] = { rowMaskToAlpha_scalar<2, 0> };
+		static const RowFunc TABLE_RGB[] = { rowMaskToAlpha_scalar<3, 0> };
+		static const RowFunc TABLE_BGR[] = { rowMaskToAlpha_scalar<3, 2> };
+		static const RowFunc TABLE_RGBA[] = { rowMaskToAlpha_scalar<4, 0> };
+		static const RowFunc TABLE_BGRA[] = { rowMaskToAlpha_scalar<4, 2> };
+#endif
+
+		const std::int32_t isaNo = static_cast<std::int32_t>(isa);
+		RowFunc func = nullptr;
+		switch (format) {
+		case Format::GRAY8:
+			func = TABLE_GRAY[isaNo];
+			break;
+		case Format::GRAYALPHA88:
+			func = TABLE_GRAYALPHA[isaNo];
+			break;
+		case Format::RGB888:
+			func = TABLE_RGB[isaNo];
+			break;
+		case Format::BGR888:
+			func = TABLE_BGR[isaNo];
+			break;
+		case Format::RGBA8888:
+			func = TABLE_RGBA[isaNo];
+			break;
+		case Format::BGRA8888:
+			func = TABLE_BGRA[isaNo];
+			break;
+		default:
+			break;
+		}
+		return func;
+	}
+
+	//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込み、R,G,Bへアルファを乗算する関数取得(最上位の命令セット)
+	DWPixelConv::RowFunc DWPixelConv::getPremulAlphaRowFunc(const Format format)
+	{
+		return getPremulAlphaRowFunc(format, getBestIsa());
+	}
+
+	//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込み、R,G,Bへアルファを乗算する関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::RowFunc DWPixelConv::getPremulAlphaRowFunc(const Format format, const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//変換元フォーマット毎の関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const RowFunc TABLE_GRAY[] = {
+			rowMaskToPremulAlpha<1, rowMaskToAlpha_scalar<1, 0>, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<1, rowMaskToAlpha_ssse3<1, 0>, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<1, rowMaskToAlpha_avx2<1, 0>, rowToPremulRGBA_avx2<0> > };
+		static const RowFunc TABLE_GRAYALPHA[] = {
+			rowMaskToPremulAlpha<2, rowMaskToAlpha_scalar<2, 0>, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<2, rowMaskToAlpha_ssse3<2, 0>, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<2, rowMaskToAlpha_avx2<2, 0>, rowToPremulRGBA_avx2<0> > };
+		static const RowFunc TABLE_RGB[] = {
+			rowMaskToPremulAlpha<3, rowMaskToAlpha_scalar<3, 0>, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<3, rowMaskToAlpha_ssse3<3, 0>, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<3, rowMaskToAlpha_avx2<3, 0>, rowToPremulRGBA_avx2<0> > };
+		static const RowFunc TABLE_BGR[] = {
+			rowMaskToPremulAlpha<3, rowMaskToAlpha_scalar<3, 2>, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<3, rowMaskToAlpha_ssse3<3, 2>, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<3, rowMaskToAlpha_avx2<3, 2>, rowToPremulRGBA_avx2<0> > };
+		static const RowFunc TABLE_RGBA[] = {
+			rowMaskToPremulAlpha<4, rowMaskToAlpha_scalar<4, 0>, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<4, rowMaskToAlpha_ssse3<4, 0>, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<4, rowMaskToAlpha_avx2<4, 0>, rowToPremulRGBA_avx2<0> > };
+		static const RowFunc TABLE_BGRA[] = {
+			rowMaskToPremulAlpha<4, rowMaskToAlpha_scalar<4, 2>, rowToPremulRGBA_scalar<0> >,
+			rowMaskToPremulAlpha<4, rowMaskToAlpha_ssse3<4, 2>, rowToPremulRGBA_ssse3<0> >,
+			rowMaskToPremulAlpha<4, rowMaskToAlpha_avx2<4, 2>, rowToPremulRGBA_avx2<0> > };
+#else
+		static const RowFunc TABLE_GRAY[] = { rowMaskToPremulAlpha<1, rowMaskToAlpha_scalar<1, 0>, rowToPremulRGBA_scalar<0> > };
+		static const RowFunc TABLE_GRAYALPHA[] = { rowMaskToPremulAlpha<2, rowMaskToAlpha_scalar<2, 0>, rowToPremulRGBA_scalar<0> > };
+		static const RowFunc TABLE_RGB[] = { rowMaskToPremulAlpha<3, rowMaskToAlpha_scalar<3, 0>, rowToPremulRGBA_scalar<0> > };
+		static const RowFunc TABLE_BGR[] = { rowMaskToPremulAlpha<3, rowMaskToAlpha_scalar<3, 2>, rowToPremulRGBA_scalar<0> > };
+		static const RowFunc TABLE_RGBA[] = { rowMaskToPremulAlpha<4, rowMaskToAlpha_scalar<4, 0>, rowToPremulRGBA_scalar<0> > };
+		static const RowFunc TABLE_BGRA[] = { rowMaskToPremulAlpha<4, rowMaskToAlpha_scalar<4, 2>, rowToPremulRGBA_scalar<0> > };
+#endif
+
+		const std::int32_t isaNo = static_cast<std::int32_t>(isa);
+		RowFunc func = nullptr;
+		switch (format) {
+		case Format::GRAY8:
+			func = TABLE_GRAY[isaNo];
+			break;
+		case Format::GRAYALPHA88:
+			func = TABLE_GRAYALPHA[isaNo];
+			break;
+		case Format::RGB888:
+			func = TABLE_RGB[isaNo];
+			break;
+		case Format::BGR888:
+			func = TABLE_BGR[isaNo];
+			break;
+		case Format::RGBA8888:
+			func = TABLE_RGBA[isaNo];
+			break;
+		case Format::BGRA8888:
+			func = TABLE_BGRA[isaNo];
+			break;
+		default:
+			break;
+		}
+		return func;
+	}
+
+	//ビットフィールドの変換パラメータ作成(bitCountは16か32、masksはR,G,B,Aのマスク、マスクが不連続なら-1)
+	std::int32_t DWPixelConv::makeBitFields(const std::int32_t bitCount, const std::uint32_t* const masks, BitFields* const fields)
+	{
+		if ((bitCount != 16) && (bitCount != 32)) {
+			//未対応のビット数
+			return -1;
+		}
+
+		for (std::int32_t c = 0; c < 4; c++) {
+			const std::uint32_t mask = masks[c];
+			std::int32_t shift = 0;
+			std::int32_t bitNum = 0;
+			if (mask != 0) {
+				//最下位の1の位置とビット数
+				while (((mask >> shift) & 1U) == 0) {
+					shift++;
+				}
+				while ((shift + bitNum < 32) && (((mask >> (shift + bitNum)) & 1U) != 0)) {
+					bitNum++;
+				}
+				if (((shift + bitNum) < 32) && ((mask >> (shift + bitNum)) != 0)) {
+					//マスクが不連続
+					return -1;
+				}
+				if ((shift + bitNum) > bitCount) {
+					//マスクが画素のビット数を超える
+					return -1;
+				}
+				if (bitNum > 8) {
+					//上位8bitのみ使用
+					shift += bitNum - 8;
+					bitNum = 8;
+				}
+			}
+
+			//拡張係数(値をbitNum毎に複製して8bitを埋める係数、値 * scale >> bitNum)
+			std::uint32_t scale = 0;
+			for (std::int32_t bit = 8; (bitNum > 0) && (bit >= 0); bit -= bitNum) {
+				scale += 1U << bit;
+			}
+
+			fields->shift_[c] = shift;
+			fields->bitNum_[c] = bitNum;
+			fields->scale_[c] = static_cast<std::uint16_t>(scale);
+		}
+		fields->isAlpha_ = (masks[3] != 0);
+
+		return 0;
+	}
+
+	//ビットフィールドからRGBA8888への行変換関数取得(最上位の命令セット、bitCountは16か32)
+	DWPixelConv::BitFieldsRowFunc DWPixelConv::getBitFieldsRowFunc(const std::int32_t bitCount)
+	{
+		return getBitFieldsRowFunc(bitCount, getBestIsa());
+	}
+
+	//ビットフィールドからRGBA8888への行変換関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::BitFieldsRowFunc DWPixelConv::getBitFieldsRowFunc(const std::int32_t bitCount, const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//ビット数毎の行変換関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const BitFieldsRowFunc TABLE_16[] = { rowBitFields16toRGBA_scalar, rowBitFields16toRGBA_ssse3, rowBitFields16toRGBA_avx2 };
+		static const BitFieldsRowFunc TABLE_32[] = { rowBitFields32toRGBA_scalar, rowBitFields32toRGBA_ssse3, rowBitFields32toRGBA_avx2 };
+#else
+		static const BitFieldsRowFunc TABLE_16[] = { rowBitFields16toRGBA_scalar };
+		static const BitFieldsRowFunc TABLE_32[] = { rowBitFields32toRGBA_scalar };
+#endif
+
+		const std::int32_t isaNo = static_cast<std::int32_t>(isa);
+		BitFieldsRowFunc func = nullptr;
+		if (bitCount == 16) {
+			func = TABLE_16[isaNo];
+		}
+		else if (bitCount == 32) {
+			func = TABLE_32[isaNo];
+		}
+		return func;
+	}
+
+	//出力フォーマットの1ピクセルあたりのバイト数取得
+	std::int32_t DWPixelConv::getBytePerPixel(const DWPixelFormat format)
+	{
+		std::int32_t bytePerPixel = 4;
+		switch (format) {
+		case DWPixelFormat::RGB565:
+		case DWPixelFormat::RGBA4444:
+			bytePerPixel = 2;
+			break;
+		case DWPixelFormat::A8:
+		case DWPixelFormat::L8:
+			bytePerPixel = 1;
+			break;
+		default:
+			break;
+		}
+		return bytePerPixel;
+	}
+
+	//RGBA8888から出力フォーマットへの行変換関数取得(最上位の命令セット)
+	DWPixelConv::RowFunc DWPixelConv::getPackRowFunc(const DWPixelFormat format)
+	{
+		return getPackRowFunc(format, getBestIsa());
+	}
+
+	//RGBA8888から出力フォーマットへの行変換関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::RowFunc DWPixelConv::getPackRowFunc(const DWPixelFormat format, const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//出力フォーマット毎の行変換関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const RowFunc TABLE_RGB565[] = { rowPackRGBAto16_scalar<5, 6, 5, 0>, rowPackRGBAto16_ssse3<5, 6, 5, 0>, rowPackRGBAto16_avx2<5, 6, 5, 0> };
+		static const RowFunc TABLE_RGBA4444[] = { rowPackRGBAto16_scalar<4, 4, 4, 4>, rowPackRGBAto16_ssse3<4, 4, 4, 4>, rowPackRGBAto16_avx2<4, 4, 4, 4> };
+		static const RowFunc TABLE_A8[] = { rowPackRGBAtoA8_scalar, rowPackRGBAtoA8_ssse3, rowPackRGBAtoA8_avx2 };
+		static const RowFunc TABLE_L8[] = { rowPackRGBAtoL8_scalar, rowPackRGBAtoL8_ssse3, rowPackRGBAtoL8_avx2 };
+#else
+		static const RowFunc TABLE_RGB565[] = { rowPackRGBAto16_scalar<5, 6, 5, 0> };
+		static const RowFunc TABLE_RGBA4444[] = { rowPackRGBAto16_scalar<4, 4, 4, 4> };
+		static const RowFunc TABLE_A8[] = { rowPackRGBAtoA8_scalar };
+		static const RowFunc TABLE_L8[] = { rowPackRGBAtoL8_scalar };
+#endif
+
+		const std::int32_t isaNo = static_cast<std::int32_t>(isa);
+		RowFunc func = nullptr;
+		switch (format) {
+		case DWPixelFormat::RGBA8888:
+			//並べ替えなし
+			func = rowRGBAtoRGBA;
+			break;
+		case DWPixelFormat::RGB565:
+			func = TABLE_RGB565[isaNo];
+			break;
+		case DWPixelFormat::RGBA4444:
+			func = TABLE_RGBA4444[isaNo];
+			break;
+		case DWPixelFormat::A8:
+			func = TABLE_A8[isaNo];
+			break;
+		case DWPixelFormat::L8:
+			func = TABLE_L8[isaNo];
+			break;
+		default:
+			break;
+		}
+		return func;
+	}
+
+	//インデックスからRGBA8888への行変換関数取得(bitDepthは1,2,4,8、それ以外はnullptr)
+	DWPixelConv::IndexRowFunc DWPixelConv::getIndexRowFunc(const std::int32_t bitDepth)
+	{
+		IndexRowFunc func = nullptr;
+		switch (bitDepth) {
+		case 1:
+			func = rowIndexToRGBA_scalar<1>;
+			break;
+		case 2:
+			func = rowIndexToRGBA_scalar<2>;
+			break;
+		case 4:
+			func = rowIndexToRGBA_scalar<4>;
+			break;
+		case 8:
+			func = rowIndexToRGBA_scalar<8>;
+			break;
+		default:
+			break;
+		}
+		return func;
+	}
+
+	//16bitサンプルを8bitへ縮小する関数取得(最上位の命令セット)
+	DWPixelConv::RowFunc DWPixelConv::getReduce16RowFunc()
+	{
+		return getReduce16RowFunc(getBestIsa());
+	}
+
+	//16bitサンプルを8bitへ縮小する関数取得(命令セット指定、使用できなければnullptr)
+	DWPixelConv::RowFunc DWPixelConv::getReduce16RowFunc(const Isa isa)
+	{
+		if (static_cast<std::int32_t>(isa) > static_cast<std::int32_t>(getBestIsa())) {
+			//実行中のCPUでは使用できない
+			return nullptr;
+		}
+
+		//命令セット毎の関数テーブル(SCALAR,SSSE3,AVX2)
+#if defined(DW_PIXELCONV_X86)
+		static const RowFunc TABLE[] = { rowReduce16to8_scalar, rowReduce16to8_ssse3, rowReduce16to8_avx2 };
+#else
+		static const RowFunc TABLE[] = { rowReduce16to8_scalar };
+#endif
+		return TABLE[static_cast<std::int32_t>(isa)];
+	}
+}
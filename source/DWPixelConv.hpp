@@ -0,0 +1,91 @@
+﻿#ifndef INCLUDED_DWPIXELCONV_HPP
+#define INCLUDED_DWPIXELCONV_HPP
+
+#include "DWType.hpp"
+
+namespace dw {
+
+	//DWPixelConvクラス(画素フォーマット変換の行カーネル)
+	class DWPixelConv {
+	public:
+		//命令セット
+		enum class Isa {
+			SCALAR,		//SIMDなし
+			SSSE3,		//SSE2+SSSE3(128bit)
+			AVX2,		//AVX2(256bit)
+		};
+
+		//変換元の画素フォーマット
+		enum class Format {
+			RGB888,		//R,G,Bの順に3バイト
+			BGR888,		//B,G,Rの順に3バイト(BMP 24bit)
+			BGRA8888,	//B,G,R,Aの順に4バイト(BMP 32bit)
+			RGBA8888,	//R,G,B,Aの順に4バイト
+			GRAY8,		//グレー1バイト(アルファ書き込みのみ)
+			GRAYALPHA88,	//グレー,アルファの順に2バイト
+		};
+
+		//行変換関数(src:変換元1行、dst:RGBA8888の1行、width:ピクセル数)
+		//srcをdstの行末側に置いた場合(src >= dst + width * (4 - 変換元バイト数))は、その場変換できる
+		typedef void(*RowFunc)(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width);
+
+		//ビットフィールド(16bit,32bitの画素からマスクで取り出すR,G,B,A)の変換パラメータ
+		//各チャンネルは上位最大8bitを取り出し、ビット複製で8bitへ拡張する((値 * scale_) >> bitNum_)
+		struct BitFields {
+			std::int32_t	shift_[4];		//R,G,B,Aの取り出し位置[bit]
+			std::int32_t	bitNum_[4];		//R,G,B,Aのビット数(0～8、0はチャンネルなし)
+			std::uint16_t	scale_[4];		//R,G,B,Aの拡張係数
+			bool			isAlpha_;		//アルファあり(なしは255)
+		};
+
+		//ビットフィールドの行変換関数(src:変換元1行、dst:RGBA8888の1行、width:ピクセル数)
+		typedef void(*BitFieldsRowFunc)(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const BitFields& fields);
+
+		//インデックス(パレット番号、グレー値)の行変換関数(src:1,2,4,8bitのインデックス1行(上位ビットが先頭ピクセル)、dst:RGBA8888の1行、width:ピクセル数)
+		//colorsはインデックス毎のRGBA値(R,G,B,Aの順の4バイト、2^ビット深度個)
+		typedef void(*IndexRowFunc)(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint32_t* const colors);
+
+		//実行中のCPUで使用可能な最上位の命令セット取得
+		static Isa getBestIsa();
+		//命令セット名取得
+		static const std::char8_t* getIsaName(const Isa isa);
+		//変換元の1ピクセルあたりのバイト数取得
+		static std::int32_t getBytePerPixel(const Format format);
+		//RGBA8888への行変換関数取得(最上位の命令セット)
+		static RowFunc getRowFunc(const Format format);
+		//RGBA8888への行変換関数取得(命令セット指定、使用できなければnullptr)
+		static RowFunc getRowFunc(const Format format, const Isa isa);
+		//乗算済みアルファ(R,G,Bにアルファを乗算)のRGBA8888への行変換関数取得(最上位の命令セット、RGBA8888はその場変換できる)
+		static RowFunc getPremulRowFunc(const Format format);
+		//乗算済みアルファのRGBA8888への行変換関数取得(命令セット指定、使用できなければnullptr)
+		static RowFunc getPremulRowFunc(const Format format, const Isa isa);
+		//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込む関数取得(R,G,Bは変更しない、最上位の命令セット)
+		static RowFunc getAlphaRowFunc(const Format format);
+		//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込む関数取得(命令セット指定、使用できなければnullptr)
+		static RowFunc getAlphaRowFunc(const Format format, const Isa isa);
+		//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込み、R,G,Bへアルファを乗算する関数取得(最上位の命令セット)
+		static RowFunc getPremulAlphaRowFunc(const Format format);
+		//変換元のR(グレーはグレー)をRGBA8888の1行のアルファへ書き込み、R,G,Bへアルファを乗算する関数取得(命令セット指定、使用できなければnullptr)
+		static RowFunc getPremulAlphaRowFunc(const Format format, const Isa isa);
+		//ビットフィールドの変換パラメータ作成(bitCountは16か32、masksはR,G,B,Aのマスク、マスクが不連続なら-1)
+		static std::int32_t makeBitFields(const std::int32_t bitCount, const std::uint32_t* const masks, BitFields* const fields);
+		//ビットフィールドからRGBA8888への行変換関数取得(最上位の命令セット、bitCountは16か32)
+		static BitFieldsRowFunc getBitFieldsRowFunc(const std::int32_t bitCount);
+		//ビットフィールドからRGBA8888への行変換関数取得(命令セット指定、使用できなければnullptr)
+		static BitFieldsRowFunc getBitFieldsRowFunc(const std::int32_t bitCount, const Isa isa);
+		//出力フォーマットの1ピクセルあたりのバイト数取得
+		static std::int32_t getBytePerPixel(const DWPixelFormat format);
+		//RGBA8888の1行から出力フォーマットの1行への変換関数取得(srcがRGBA8888、dstが出力フォーマット、最上位の命令セット)
+		static RowFunc getPackRowFunc(const DWPixelFormat format);
+		//RGBA8888の1行から出力フォーマットの1行への変換関数取得(命令セット指定、使用できなければnullptr)
+		static RowFunc getPackRowFunc(const DWPixelFormat format, const Isa isa);
+		//インデックスからRGBA8888への行変換関数取得(bitDepthは1,2,4,8、それ以外はnullptr、ビット深度毎にコンパイル時に特殊化)
+		static IndexRowFunc getIndexRowFunc(const std::int32_t bitDepth);
+		//16bitサンプル(ビッグエンディアン)を8bitへ縮小する関数取得(四捨五入、widthはサンプル数、その場変換できる、最上位の命令セット)
+		static RowFunc getReduce16RowFunc();
+		//16bitサンプルを8bitへ縮小する関数取得(命令セット指定、使用できなければnullptr)
+		static RowFunc getReduce16RowFunc(const Isa isa);
+	};
+}
+
+#endif //INCLUDED_DWPIXELCONV_HPP
@@ -0,0 +1,1046 @@
+﻿#include "DWRenderer.hpp"
+#include <cstring>
+
+#if defined(_WIN32)
+//OpenGL 1.2のパックドピクセル型(Windows標準のgl/GL.hは1.1まで)
+#if !defined(GL_UNSIGNED_SHORT_4_4_4_4)
+#define GL_UNSIGNED_SHORT_4_4_4_4 0x8033
+#endif
+#if !defined(GL_UNSIGNED_SHORT_5_6_5)
+#define GL_UNSIGNED_SHORT_5_6_5 0x8363
+#endif
+#endif
+
+namespace {
+	//RGBA8888画像の1ピクセルあたりのバイト数
+	static const std::int32_t BYTE_PER_PIXEL_RGBA8888 = 4;
+
+	//0～255*255の値を255で除算(四捨五入)
+	inline std::uint8_t div255(const std::uint32_t v)
+	{
+		const std::uint32_t t = v + 128;
+		return static_cast<std::uint8_t>((t + (t >> 8)) >> 8);
+	}
+
+	//RGBA値をソースオーバーで合成
+	inline void blendPixel(std::uint8_t* const dst, const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a)
+	{
+		if (a == 255) {
+			//不透明は上書き
+			dst[0] = r;
+			dst[1] = g;
+			dst[2] = b;
+			dst[3] = 255;
+		}
+		else if (a != 0) {
+			//Cout = Csrc * Asrc + Cdst * (1 - Asrc)
+			//Aout = Asrc + Adst * (1 - Asrc)
+			const std::uint32_t ia = 255 - a;
+			dst[0] = div255((r * a) + (dst[0] * ia));
+			dst[1] = div255((g * a) + (dst[1] * ia));
+			dst[2] = div255((b * a) + (dst[2] * ia));
+			dst[3] = static_cast<std::uint8_t>(a + div255(dst[3] * ia));
+		}
+		else {
+			//透明は何もしない
+		}
+	}
+
+	//乗算済みRGBA値をソースオーバーで合成
+	inline void blendPixelPremul(std::uint8_t* const dst, const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a)
+	{
+		if (a == 255) {
+			//不透明は上書き
+			dst[0] = r;
+			dst[1] = g;
+			dst[2] = b;
+			dst[3] = 255;
+		}
+		else if ((r | g | b | a) != 0) {
+			//Cout = Csrc + Cdst * (1 - Asrc)(チャンネル毎に乗算1回)
+			const std::uint32_t ia = 255 - a;
+			dst[0] = static_cast<std::uint8_t>(r + div255(dst[0] * ia));
+			dst[1] = static_cast<std::uint8_t>(g + div255(dst[1] * ia));
+			dst[2] = static_cast<std::uint8_t>(b + div255(dst[2] * ia));
+			dst[3] = static_cast<std::uint8_t>(a + div255(dst[3] * ia));
+		}
+		else {
+			//透明は何もしない
+		}
+	}
+
+	//色のR,G,Bにアルファを乗算
+	inline dw::DWColor premulColor(const dw::DWColor& color)
+	{
+		const dw::DWColor premul = { div255(color.r_ * color.a_), div255(color.g_ * color.a_), div255(color.b_ * color.a_), color.a_ };
+		return premul;
+	}
+
+	//乗算済みアルファで合成する画像か(A8は白の乗算済みアルファ、R,G,B,Aとも被覆率)
+	inline bool isPremultipliedBitmap(const dw::DWBitmap& bitmap)
+	{
+		return (bitmap.isPremultiplied_) || (bitmap.format_ == dw::DWPixelFormat::A8);
+	}
+
+	//画素フォーマットの1ピクセルをRGBAへ展開(FORMAT毎に特殊化、ビット複製で8bitへ拡張)
+	template <dw::DWPixelFormat FORMAT>
+	inline void unpackPixel(const std::uint8_t* const rp, std::uint8_t* const rgba);
+	template <>
+	inline void unpackPixel<dw::DWPixelFormat::RGBA8888>(const std::uint8_t* const rp, std::uint8_t* const rgba)
+	{
+		rgba[0] = rp[0];
+		rgba[1] = rp[1];
+		rgba[2] = rp[2];
+		rgba[3] = rp[3];
+	}
+	template <>
+	inline void unpackPixel<dw::DWPixelFormat::RGB565>(const std::uint8_t* const rp, std::uint8_t* const rgba)
+	{
+		std::uint16_t pixel;
+		memcpy(&pixel, rp, sizeof(pixel));
+		const std::uint32_t r = (pixel >> 11) & 0x1FU;
+		const std::uint32_t g = (pixel >> 5) & 0x3FU;
+		const std::uint32_t b = pixel & 0x1FU;
+		rgba[0] = static_cast<std::uint8_t>((r << 3) | (r >> 2));
+		rgba[1] = static_cast<std::uint8_t>((g << 2) | (g >> 4));
+		rgba[2] = static_cast<std::uint8_t>((b << 3) | (b >> 2));
+		rgba[3] = 255;
+	}
+	template <>
+	inline void unpackPixel<dw::DWPixelFormat::RGBA4444>(const std::uint8_t* const rp, std::uint8_t* const rgba)
+	{
+		std::uint16_t pixel;
+		memcpy(&pixel, rp, sizeof(pixel));
+		rgba[0] = static_cast<std::uint8_t>(((pixel >> 12) & 0xFU) * 17U);
+		rgba[1] = static_cast<std::uint8_t>(((pixel >> 8) & 0xFU) * 17U);
+		rgba[2] = static_cast<std::uint8_t>(((pixel >> 4) & 0xFU) * 17U);
+		rgba[3] = static_cast<std::uint8_t>((pixel & 0xFU) * 17U);
+	}
+	template <>
+	inline void unpackPixel<dw::DWPixelFormat::L8>(const std::uint8_t* const rp, std::uint8_t* const rgba)
+	{
+		rgba[0] = rp[0];
+		rgba[1] = rp[0];
+		rgba[2] = rp[0];
+		rgba[3] = 255;
+	}
+
+	//画像の1行をRGBA8888の1行へ合成する関数
+	typedef void(*BlendRowFunc)(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width);
+
+	//画像の1行(BYTEは1ピクセルのバイト数)をRGBA8888の1行へソースオーバーで合成
+	template <dw::DWPixelFormat FORMAT, std::int32_t BYTE, bool IS_PREMULTIPLIED>
+	void blendRow(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		for (std::int32_t i = 0; i < width; i++) {
+			std::uint8_t rgba[4];
+			unpackPixel<FORMAT>(src + (i * BYTE), rgba);
+			if (IS_PREMULTIPLIED) {
+				//乗算済みアルファはチャンネル毎に乗算1回で合成
+				blendPixelPremul(dst + (i * BYTE_PER_PIXEL_RGBA8888), rgba[0], rgba[1], rgba[2], rgba[3]);
+			}
+			else {
+				blendPixel(dst + (i * BYTE_PER_PIXEL_RGBA8888), rgba[0], rgba[1], rgba[2], rgba[3]);
+			}
+		}
+	}
+
+#if defined(_WIN32)
+	//テクスチャの形式
+	struct TextureFormat {
+		GLint	internalFormat_;	//内部形式(RGBA8888以外は画素フォーマットと同じビット数を指定)
+		GLenum	format_;			//転送データの形式
+		GLenum	type_;				//転送データの型
+	};
+
+	//画素フォーマットに対応するテクスチャの形式取得(A8はR,G,B,Aとも被覆率のインテンシティテクスチャ)
+	inline TextureFormat getTextureFormat(const dw::DWPixelFormat format)
+	{
+		TextureFormat texFormat = { GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE };
+		switch (format) {
+		case dw::DWPixelFormat::RGB565:
+			texFormat.internalFormat_ = GL_RGB5;
+			texFormat.format_ = GL_RGB;
+			texFormat.type_ = GL_UNSIGNED_SHORT_5_6_5;
+			break;
+		case dw::DWPixelFormat::RGBA4444:
+			texFormat.internalFormat_ = GL_RGBA4;
+			texFormat.type_ = GL_UNSIGNED_SHORT_4_4_4_4;
+			break;
+		case dw::DWPixelFormat::A8:
+			texFormat.internalFormat_ = GL_INTENSITY8;
+			texFormat.format_ = GL_LUMINANCE;
+			break;
+		case dw::DWPixelFormat::L8:
+			texFormat.internalFormat_ = GL_LUMINANCE8;
+			texFormat.format_ = GL_LUMINANCE;
+			break;
+		default:
+			break;
+		}
+		return texFormat;
+	}
+#endif
+
+	//矩形同士の重なり判定
+	inline bool isOverlap(const dw::DWArea& a, const dw::DWArea& b)
+	{
+		return (a.xmin_ < b.xmax_) && (b.xmin_ < a.xmax_) && (a.ymin_ < b.ymax_) && (b.ymin_ < a.ymax_);
+	}
+}
+
+namespace dw {
+
+	//----------------------------------------------------------------
+	// DWRendererクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWRenderer::DWRenderer() :
+		residents_(), uploadByte_(0), lastUploadByte_(0), drawCallNum_(0), lastDrawCallNum_(0)
+	{
+	}
+
+	//デストラクタ
+	DWRenderer::~DWRenderer()
+	{
+	}
+
+	//常駐画像登録(画像データは登録解除まで保持すること)
+	std::int32_t DWRenderer::registerBitmap(const DWBitmap& bitmap)
+	{
+		std::int32_t bitmapID = -1;
+
+		//同一画像が登録済みなら、そのIDを返す
+		for (std::int32_t i = 0; i < RESIDENT_MAXNUM; i++) {
+			const Resident& resident = this->residents_[i];
+			if ((resident.isValid_) && (resident.bitmap_.image_ == bitmap.image_) &&
+				(resident.bitmap_.width_ == bitmap.width_) && (resident.bitmap_.height_ == bitmap.height_)) {
+				return i;
+			}
+		}
+
+		//空きに登録(バックエンド資源は初回描画時に作成)
+		for (std::int32_t i = 0; i < RESIDENT_MAXNUM; i++) {
+			Resident* resident = &this->residents_[i];
+			if (!resident->isValid_) {
+				resident->isValid_ = true;
+				resident->bitmap_ = bitmap;
+				resident->handle_ = 0;
+				resident->isDirty_ = false;
+				bitmapID = i;
+				break;
+			}
+		}
+
+		return bitmapID;
+	}
+
+	//常駐画像登録解除
+	void DWRenderer::unregisterBitmap(const std::int32_t bitmapID)
+	{
+		Resident* resident = this->getResident(bitmapID);
+		if (resident != nullptr) {
+			this->releaseResident(resident);
+			resident->handle_ = 0;
+			resident->isValid_ = false;
+		}
+	}
+
+	//常駐画像の更新を通知(更新領域は次回描画時に再転送)
+	void DWRenderer::updateBitmap(const std::int32_t bitmapID, const DWArea& area)
+	{
+		Resident* resident = this->getResident(bitmapID);
+		if (resident == nullptr) {
+			//未登録
+			return;
+		}
+
+		if (!resident->isDirty_) {
+			resident->isDirty_ = true;
+			resident->dirtyArea_ = area;
+		}
+		else {
+			//更新領域を拡張
+			DWArea& dirty = resident->dirtyArea_;
+			dirty.xmin_ = (area.xmin_ < dirty.xmin_) ? area.xmin_ : dirty.xmin_;
+			dirty.ymin_ = (area.ymin_ < dirty.ymin_) ? area.ymin_ : dirty.ymin_;
+			dirty.xmax_ = (area.xmax_ > dirty.xmax_) ? area.xmax_ : dirty.xmax_;
+			dirty.ymax_ = (area.ymax_ > dirty.ymax_) ? area.ymax_ : dirty.ymax_;
+		}
+	}
+
+	//常駐画像取得
+	const DWBitmap* DWRenderer::getBitmap(const std::int32_t bitmapID)
+	{
+		const Resident* resident = this->getResident(bitmapID);
+		return (resident != nullptr) ? &resident->bitmap_ : nullptr;
+	}
+
+	//前フレームの転送バイト数取得
+	std::int32_t DWRenderer::getUploadByte()
+	{
+		return this->lastUploadByte_;
+	}
+
+	//前フレームの描画コール数取得
+	std::int32_t DWRenderer::getDrawCallNum()
+	{
+		return this->lastDrawCallNum_;
+	}
+
+	//常駐画像取得
+	DWRenderer::Resident* DWRenderer::getResident(const std::int32_t bitmapID)
+	{
+		if ((bitmapID < 0) || (bitmapID >= RESIDENT_MAXNUM) || (!this->residents_[bitmapID].isValid_)) {
+			//未登録
+			return nullptr;
+		}
+		return &this->residents_[bitmapID];
+	}
+
+	//フレーム統計を更新(endDrawで呼ぶ)
+	void DWRenderer::updateFrameStat()
+	{
+		this->lastUploadByte_ = this->uploadByte_;
+		this->uploadByte_ = 0;
+		this->lastDrawCallNum_ = this->drawCallNum_;
+		this->drawCallNum_ = 0;
+	}
+
+
+
+#if defined(_WIN32)
+	//----------------------------------------------------------------
+	// DWRendererGLクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWRendererGL::DWRendererGL(HWND hWnd) :
+		DWRenderer(), hWnd_(hWnd), hDC_(nullptr), hGLRC_(nullptr), isSwapCopy_(false), size_(), batches_(), batchNum_(0), oneshotTex_(), releasedTex_()
+	{
+		//デバイスコンテキストハンドルを取得
+		this->hDC_ = ::GetDC(this->hWnd_);
+
+		//ピクセルフォーマット
+		const PIXELFORMATDESCRIPTOR pFormat = {
+			sizeof(PIXELFORMATDESCRIPTOR),	//nSize
+			1,		//nVersion
+			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER | PFD_SWAP_COPY,	//dwFlags
+			PFD_TYPE_RGBA,	//iPixelType
+			32,		//cColorBits
+			0,		//cRedBits
+			0,		//cRedShift
+			0,		//cGreenBits
+			0,		//cGreenShift
+			0,		//cBlueBits
+			0,		//cBlueShift
+			0,		//cAlphaBits
+			0,		//cAlphaShift
+			0,		//cAccumBits
+			0,		//cAccumRedBits
+			0,		//cAccumGreenBits
+			0,		//cAccumBlueBits
+			0,		//cAccumAlphaBits
+			24,		//cDepthBits
+			8,		//cStencilBits
+			0,		//cAuxBuffers
+			0,		//iLayerType
+			0,		//bReserved
+			0,		//dwLayerMask
+			0,		//dwVisibleMask
+			0		//dwDamageMask
+		};
+
+		//ピクセルフォーマットを選択
+		std::int32_t format = ::ChoosePixelFormat(this->hDC_, &pFormat);
+		::SetPixelFormat(this->hDC_, format, &pFormat);
+
+		//スワップ後のバックバッファ保持を確認(PFD_SWAP_COPYはヒントのため選択されない場合がある)
+		PIXELFORMATDESCRIPTOR pfd;
+		if (::DescribePixelFormat(this->hDC_, format, sizeof(PIXELFORMATDESCRIPTOR), &pfd) != 0) {
+			this->isSwapCopy_ = ((pfd.dwFlags & PFD_SWAP_COPY) != 0) ? true : false;
+		}
+
+		//ウィンドウサイズを取得
+		this->updateSize();
+	}
+
+	//デストラクタ
+	DWRendererGL::~DWRendererGL()
+	{
+		//カレントを解除
+		//(常駐テクスチャ、破棄待ちのテクスチャは描画コンテキストの破棄と同時に解放される)
+		::wglMakeCurrent(this->hDC_, nullptr);
+
+		if (this->hGLRC_ != nullptr) {
+			//描画コンテキストハンドルを破棄
+			::wglDeleteContext(this->hGLRC_);
+		}
+
+		if (this->hDC_ != nullptr) {
+			//デバイスコンテキストを破棄
+			::ReleaseDC(this->hWnd_, this->hDC_);
+		}
+	}
+
+	//描画開始
+	void DWRendererGL::beginDraw()
+	{
+		if (this->hGLRC_ == nullptr) {
+			//描画コンテキストハンドルを作成
+			this->hGLRC_ = ::wglCreateContext(this->hDC_);
+
+			//描画コンテキストをカレントに設定
+			::wglMakeCurrent(this->hDC_, this->hGLRC_);
+		}
+
+		//ビューポート設定
+		glViewport(0, 0, this->size_.width_, this->size_.height_);
+
+		//プロジェクション設定(正射影)
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glOrtho(0.0, this->size_.width_, this->size_.height_, 0.0, -1.0, 1.0);
+
+		//モデルビュー設定
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+	}
+
+	//描画終了
+	void DWRendererGL::endDraw()
+	{
+		//溜めた矩形をまとめて描画
+		this->flush();
+
+		//フレーム内のみ使用したテクスチャを破棄
+		if (!this->oneshotTex_.empty()) {
+			glDeleteTextures(static_cast<GLsizei>(this->oneshotTex_.size()), &this->oneshotTex_[0]);
+			this->oneshotTex_.clear();
+		}
+
+		//描画スレッド外で登録解除したテクスチャを破棄
+		if (!this->releasedTex_.empty()) {
+			glDeleteTextures(static_cast<GLsizei>(this->releasedTex_.size()), &this->releasedTex_[0]);
+			this->releasedTex_.clear();
+		}
+
+		::SwapBuffers(this->hDC_);
+
+		//フレーム統計を更新
+		this->updateFrameStat();
+	}
+
+	//画面塗りつぶし
+	void DWRendererGL::clear(const DWColor& color)
+	{
+		//未描画の矩形は塗りつぶされるので破棄
+		this->batchNum_ = 0;
+
+		GLclampf r = static_cast<std::float32_t>(color.r_) / 255.0F;
+		GLclampf g = static_cast<std::float32_t>(color.g_) / 255.0F;
+		GLclampf b = static_cast<std::float32_t>(color.b_) / 255.0F;
+		GLclampf a = static_cast<std::float32_t>(color.a_) / 255.0F;
+
+		glClearColor(r, g, b, a);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	//矩形塗りつぶし
+	void DWRendererGL::fillRect(const DWArea& area, const DWColor& color)
+	{
+		//未描画の矩形と重なる場合は、描画順を保つため先に描画
+		for (std::int32_t i = 0; i < this->batchNum_; i++) {
+			if (isOverlap(this->batches_[i].bounds_, area)) {
+				this->flush();
+				break;
+			}
+		}
+
+		GLclampf r = static_cast<std::float32_t>(color.r_) / 255.0F;
+		GLclampf g = static_cast<std::float32_t>(color.g_) / 255.0F;
+		GLclampf b = static_cast<std::float32_t>(color.b_) / 255.0F;
+		GLclampf a = static_cast<std::float32_t>(color.a_) / 255.0F;
+
+		//シザー矩形の原点は左下なので上下を反転
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(area.xmin_, this->size_.height_ - area.ymax_, area.xmax_ - area.xmin_, area.ymax_ - area.ymin_);
+		glClearColor(r, g, b, a);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	//描画先サイズ更新(描画スレッドから呼ぶこと)
+	void DWRendererGL::updateSize()
+	{
+		RECT rect;
+		::GetClientRect(this->hWnd_, &rect);
+		this->size_.width_ = rect.right - rect.left;
+		this->size_.height_ = rect.bottom - rect.top;
+	}
+
+	//描画先サイズ取得
+	DWSize DWRendererGL::getSize()
+	{
+		return this->size_;
+	}
+
+	//描画終了後もバックバッファの内容が保持されるか(falseなら毎フレーム全体再描画が必要)
+	bool DWRendererGL::isBackBufferKept()
+	{
+		//スワップ後のバックバッファはコピー時のみ前フレームの内容(交換時は未定義)
+		return this->isSwapCopy_;
+	}
+
+	//アルファ画像(1ピクセル1バイト)を指定色で描画
+	void DWRendererGL::drawAlpha(const std::uint8_t* const image, const DWSize& size, const DWCoord& coord, const DWColor& color)
+	{
+		//テクスチャ生成(フレーム終了時に破棄)
+		GLuint texID = this->createTexture();
+		this->oneshotTex_.push_back(texID);
+
+		//テクスチャロード(R,G,B,Aとも被覆率のインテンシティテクスチャ)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_INTENSITY, size.width_, size.height_, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, image);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		this->uploadByte_ += size.width_ * size.height_;
+
+		//被覆率と乗算済みアルファの指定色を乗算して描画
+		const DWArea texArea = { 0, 0, size.width_, size.height_ };
+		this->addQuad(texID, true, size, texArea, coord, premulColor(color));
+	}
+	void DWRendererGL::drawAlpha(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord, const DWColor& color)
+	{
+		Resident* resident = this->getResident(bitmapID);
+		if (resident == nullptr) {
+			//未登録
+			return;
+		}
+
+		//常駐テクスチャの描画元領域を乗算済みアルファの指定色で描画
+		const DWSize texSize = { resident->bitmap_.width_, resident->bitmap_.height_ };
+		this->addQuad(this->getTexture(resident), true, texSize, srcArea, coord, premulColor(color));
+	}
+
+	//画像描画
+	void DWRendererGL::drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord)
+	{
+		//描画元領域の幅高さ
+		const DWSize texSize = { srcArea.xmax_ - srcArea.xmin_, srcArea.ymax_ - srcArea.ymin_ };
+		const DWArea texArea = { 0, 0, texSize.width_, texSize.height_ };
+
+		//テクスチャ生成(フレーム終了時に破棄)
+		GLuint texID = this->createTexture();
+		this->oneshotTex_.push_back(texID);
+
+		//テクスチャロード(描画元領域のみ)
+		this->uploadTexture(bitmap, srcArea);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		//描画
+		const DWColor white = { 255, 255, 255, 255 };
+		this->addQuad(texID, isPremultipliedBitmap(bitmap), texSize, texArea, coord, white);
+	}
+	void DWRendererGL::drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord)
+	{
+		Resident* resident = this->getResident(bitmapID);
+		if (resident == nullptr) {
+			//未登録
+			return;
+		}
+
+		//常駐テクスチャで描画
+		const DWSize texSize = { resident->bitmap_.width_, resident->bitmap_.height_ };
+		const DWColor white = { 255, 255, 255, 255 };
+		this->addQuad(this->getTexture(resident), isPremultipliedBitmap(resident->bitmap_), texSize, srcArea, coord, white);
+	}
+
+	//常駐画像のバックエンド資源を解放
+	void DWRendererGL::releaseResident(Resident* const resident)
+	{
+		if (resident->handle_ == 0) {
+			//テクスチャ未作成
+			return;
+		}
+
+		GLuint texID = resident->handle_;
+		if ((this->hGLRC_ == nullptr) || (::wglGetCurrentContext() != this->hGLRC_)) {
+			//描画コンテキストがカレントでないスレッド(UIスレッド等)ではGLを呼べないため、次の描画終了時に破棄
+			this->releasedTex_.push_back(texID);
+			return;
+		}
+
+		//未描画の矩形が参照している可能性があるので先に描画
+		this->flush();
+
+		//テクスチャ破棄
+		glDeleteTextures(1, &texID);
+	}
+
+	//テクスチャ付き矩形をバッチへ追加(isPremultipliedならテクスチャと頂点カラーは乗算済みアルファ)
+	void DWRendererGL::addQuad(const GLuint texID, const bool isPremultiplied, const DWSize& texSize, const DWArea& srcArea, const DWCoord& coord, const DWColor& color)
+	{
+		DWArea drawArea;
+		drawArea.xmin_ = coord.x_;
+		drawArea.ymin_ = coord.y_;
+		drawArea.xmax_ = coord.x_ + (srcArea.xmax_ - srcArea.xmin_);
+		drawArea.ymax_ = coord.y_ + (srcArea.ymax_ - srcArea.ymin_);
+
+		//同じテクスチャのバッチを後ろから探す
+		//(間のバッチと重なる場合は、まとめると描画順が変わるので新しいバッチにする)
+		std::int32_t batchNo = -1;
+		for (std::int32_t i = this->batchNum_ - 1; i >= 0; i--) {
+			const Batch& batch = this->batches_[i];
+			if (batch.texID_ == texID) {
+				batchNo = i;
+				break;
+			}
+			if (isOverlap(batch.bounds_, drawArea)) {
+				break;
+			}
+		}
+
+		if (batchNo < 0) {
+			//新しいバッチ(頂点配列の領域は再利用)
+			if (this->batchNum_ == static_cast<std::int32_t>(this->batches_.size())) {
+				this->batches_.push_back(Batch());
+			}
+			batchNo = this->batchNum_;
+			this->batchNum_++;
+
+			Batch& batch = this->batches_[batchNo];
+			batch.texID_ = texID;
+			batch.isPremultiplied_ = isPremultiplied;
+			batch.bounds_ = drawArea;
+			batch.vertices_.clear();
+		}
+		else {
+			//外接矩形を拡張
+			DWArea& bounds = this->batches_[batchNo].bounds_;
+			bounds.xmin_ = (drawArea.xmin_ < bounds.xmin_) ? drawArea.xmin_ : bounds.xmin_;
+			bounds.ymin_ = (drawArea.ymin_ < bounds.ymin_) ? drawArea.ymin_ : bounds.ymin_;
+			bounds.xmax_ = (drawArea.xmax_ > bounds.xmax_) ? drawArea.xmax_ : bounds.xmax_;
+			bounds.ymax_ = (drawArea.ymax_ > bounds.ymax_) ? drawArea.ymax_ : bounds.ymax_;
+		}
+
+		//テクスチャ座標
+		const std::float32_t u0 = static_cast<std::float32_t>(srcArea.xmin_) / static_cast<std::float32_t>(texSize.width_);
+		const std::float32_t v0 = static_cast<std::float32_t>(srcArea.ymin_) / static_cast<std::float32_t>(texSize.height_);
+		const std::float32_t u1 = static_cast<std::float32_t>(srcArea.xmax_) / static_cast<std::float32_t>(texSize.width_);
+		const std::float32_t v1 = static_cast<std::float32_t>(srcArea.ymax_) / static_cast<std::float32_t>(texSize.height_);
+
+		//頂点座標
+		const GLfloat x0 = static_cast<GLfloat>(drawArea.xmin_);
+		const GLfloat y0 = static_cast<GLfloat>(drawArea.ymin_);
+		const GLfloat x1 = static_cast<GLfloat>(drawArea.xmax_);
+		const GLfloat y1 = static_cast<GLfloat>(drawArea.ymax_);
+
+		//三角形2つで追加
+		const Vertex quad[6] = {
+			{ x0, y0, u0, v0, color.r_, color.g_, color.b_, color.a_ },
+			{ x1, y0, u1, v0, color.r_, color.g_, color.b_, color.a_ },
+			{ x0, y1, u0, v1, color.r_, color.g_, color.b_, color.a_ },
+			{ x1, y0, u1, v0, color.r_, color.g_, color.b_, color.a_ },
+			{ x1, y1, u1, v1, color.r_, color.g_, color.b_, color.a_ },
+			{ x0, y1, u0, v1, color.r_, color.g_, color.b_, color.a_ },
+		};
+		std::vector<Vertex>& vertices = this->batches_[batchNo].vertices_;
+		vertices.insert(vertices.end(), quad, quad + 6);
+	}
+
+	//バッチを描画
+	void DWRendererGL::flush()
+	{
+		if (this->batchNum_ == 0) {
+			//描画なし
+			return;
+		}
+
+		//GL描画設定
+		glEnable(GL_BLEND);
+		glEnable(GL_TEXTURE_2D);
+
+		//テクスチャ環境
+		//テクスチャカラーと頂点カラーを乗算する(画像は白、アルファ画像は乗算済みアルファの指定色)
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+
+		//バッチ毎に1回の描画コール(合成方法は乗算済みアルファが変わる時のみ切り替え)
+		for (std::int32_t i = 0; i < this->batchNum_; i++) {
+			const Batch& batch = this->batches_[i];
+			const Vertex* const vertices = &batch.vertices_[0];
+
+			if ((i == 0) || (batch.isPremultiplied_ != this->batches_[i - 1].isPremultiplied_)) {
+				//乗算済みアルファはGL_ONE(線形補間で透明部分の色がにじまない)
+				glBlendFunc((batch.isPremultiplied_) ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			}
+
+			glBindTexture(GL_TEXTURE_2D, batch.texID_);
+			glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices->x_);
+			glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices->u_);
+			glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vertices->r_);
+			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(batch.vertices_.size()));
+			this->drawCallNum_++;
+		}
+
+		glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+
+		//テクスチャアンバインド
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glDisable(GL_TEXTURE_2D);
+		glDisable(GL_BLEND);
+
+		this->batchNum_ = 0;
+	}
+
+	//テクスチャ生成(生成したテクスチャはバインドされた状態で返す)
+	GLuint DWRendererGL::createTexture()
+	{
+		GLuint texID;
+		glGenTextures(1, &texID);
+		glBindTexture(GL_TEXTURE_2D, texID);
+
+		//テクスチャパラメータ設定
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+		return texID;
+	}
+
+	//常駐画像のテクスチャ取得(未作成なら作成、更新領域があれば再転送)
+	GLuint DWRendererGL::getTexture(Resident* const resident)
+	{
+		const DWBitmap& bitmap = resident->bitmap_;
+		if (resident->handle_ == 0) {
+			//初回描画時のみテクスチャを生成して転送(描画コンテキストのスレッドで実施する必要がある)
+			GLuint texID = this->createTexture();
+			const DWArea fullArea = { 0, 0, bitmap.width_, bitmap.height_ };
+			this->uploadTexture(bitmap, fullArea);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			resident->handle_ = texID;
+			resident->isDirty_ = false;
+		}
+		else if (resident->isDirty_) {
+			//描画待ちの矩形が参照している場合は、更新前の内容で先に描画
+			for (std::int32_t i = 0; i < this->batchNum_; i++) {
+				if (this->batches_[i].texID_ == resident->handle_) {
+					this->flush();
+					break;
+				}
+			}
+
+			//更新領域のみ転送
+			glBindTexture(GL_TEXTURE_2D, resident->handle_);
+			this->updateTexture(bitmap, resident->dirtyArea_);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			resident->isDirty_ = false;
+		}
+		else {
+			//転送不要
+		}
+
+		return resident->handle_;
+	}
+
+	//テクスチャ転送
+	void DWRendererGL::uploadTexture(const DWBitmap& bitmap, const DWArea& srcArea)
+	{
+		const std::int32_t srcW = srcArea.xmax_ - srcArea.xmin_;
+		const std::int32_t srcH = srcArea.ymax_ - srcArea.ymin_;
+
+		//画素フォーマットのまま転送(RGBA8888へ展開しない)
+		const TextureFormat texFormat = getTextureFormat(bitmap.format_);
+
+		//バインド中のテクスチャへ描画元領域のみ転送
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, bitmap.width_);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, srcArea.xmin_);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, srcArea.ymin_);
+		glTexImage2D(GL_TEXTURE_2D, 0, texFormat.internalFormat_, srcW, srcH, 0, texFormat.format_, texFormat.type_, bitmap.image_);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+		//転送バイト数を加算
+		this->uploadByte_ += srcW * srcH * bitmap.bytePerPixel_;
+	}
+
+	//テクスチャの部分更新
+	void DWRendererGL::updateTexture(const DWBitmap& bitmap, const DWArea& area)
+	{
+		const std::int32_t w = area.xmax_ - area.xmin_;
+		const std::int32_t h = area.ymax_ - area.ymin_;
+
+		//画素フォーマットのまま転送
+		const TextureFormat texFormat = getTextureFormat(bitmap.format_);
+
+		//バインド中のテクスチャの同じ位置へ転送
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, bitmap.width_);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, area.xmin_);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, area.ymin_);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, area.xmin_, area.ymin_, w, h, texFormat.format_, texFormat.type_, bitmap.image_);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+		//転送バイト数を加算
+		this->uploadByte_ += w * h * bitmap.bytePerPixel_;
+	}
+#endif
+
+
+
+	//----------------------------------------------------------------
+	// DWRendererSoftクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWRendererSoft::DWRendererSoft(const std::int32_t width, const std::int32_t height) :
+		DWRenderer(), frame_(nullptr), frameSize_(0), size_(), frameNum_(0)
+	{
+		//フレームバッファを確保
+		this->size_.width_ = width;
+		this->size_.height_ = height;
+		this->frameSize_ = width * height * BYTE_PER_PIXEL_RGBA8888;
+		this->frame_ = new std::uint8_t[this->frameSize_];
+		memset(this->frame_, 0, this->frameSize_);
+	}
+
+	//デストラクタ
+	DWRendererSoft::~DWRendererSoft()
+	{
+		if (this->frame_ != nullptr) {
+			delete[] this->frame_;
+		}
+	}
+
+	//描画開始
+	void DWRendererSoft::beginDraw()
+	{
+		//フレームバッファへ直接描画するため処理なし
+	}
+
+	//描画終了
+	void DWRendererSoft::endDraw()
+	{
+		this->frameNum_++;
+
+		//フレーム統計を更新
+		this->updateFrameStat();
+	}
+
+	//画面塗りつぶし
+	void DWRendererSoft::clear(const DWColor& color)
+	{
+		const DWArea area = { 0, 0, this->size_.width_, this->size_.height_ };
+		this->fillRect(area, color);
+	}
+
+	//矩形塗りつぶし
+	void DWRendererSoft::fillRect(const DWArea& area, const DWColor& color)
+	{
+		//フレームバッファ内にクリップ
+		const DWCoord coord = { area.xmin_, area.ymin_ };
+		const DWSize size = { area.xmax_ - area.xmin_, area.ymax_ - area.ymin_ };
+		DWArea dstArea;
+		DWCoord srcOffset;
+		if (!this->clipArea(coord, size, &dstArea, &srcOffset)) {
+			return;
+		}
+
+		//1行目を塗りつぶし、以降の行は1行目を複写
+		const std::int32_t rowByte = (dstArea.xmax_ - dstArea.xmin_) * BYTE_PER_PIXEL_RGBA8888;
+		const std::int32_t stride = this->size_.width_ * BYTE_PER_PIXEL_RGBA8888;
+		std::uint8_t* firstRow = this->frame_ + (dstArea.ymin_ * stride) + (dstArea.xmin_ * BYTE_PER_PIXEL_RGBA8888);
+		for (std::int32_t w = 0; w < rowByte; w += BYTE_PER_PIXEL_RGBA8888) {
+			firstRow[w + 0] = color.r_;
+			firstRow[w + 1] = color.g_;
+			firstRow[w + 2] = color.b_;
+			firstRow[w + 3] = color.a_;
+		}
+		std::uint8_t* wp = firstRow + stride;
+		for (std::int32_t h = dstArea.ymin_ + 1; h < dstArea.ymax_; h++) {
+			memcpy(wp, firstRow, rowByte);
+			wp += stride;
+		}
+	}
+
+	//描画先サイズ更新(描画スレッドから呼ぶこと)
+	void DWRendererSoft::updateSize()
+	{
+		//フレームバッファのサイズは固定
+	}
+
+	//描画先サイズ取得
+	DWSize DWRendererSoft::getSize()
+	{
+		return this->size_;
+	}
+
+	//描画終了後もバックバッファの内容が保持されるか(falseなら毎フレーム全体再描画が必要)
+	bool DWRendererSoft::isBackBufferKept()
+	{
+		//フレームバッファは1枚のため常に保持
+		return true;
+	}
+
+	//アルファ画像(1ピクセル1バイト)を指定色で描画
+	void DWRendererSoft::drawAlpha(const std::uint8_t* const image, const DWSize& size, const DWCoord& coord, const DWColor& color)
+	{
+		this->blendAlpha(image, size.width_, size, coord, color);
+	}
+	void DWRendererSoft::drawAlpha(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord, const DWColor& color)
+	{
+		const Resident* resident = this->getResident(bitmapID);
+		if (resident == nullptr) {
+			//未登録
+			return;
+		}
+
+		//常駐画像はそのまま参照して描画(転送不要)
+		const DWBitmap& bitmap = resident->bitmap_;
+		const std::uint8_t* const image = bitmap.image_ + (srcArea.ymin_ * bitmap.width_) + srcArea.xmin_;
+		const DWSize size = { srcArea.xmax_ - srcArea.xmin_, srcArea.ymax_ - srcArea.ymin_ };
+		this->blendAlpha(image, bitmap.width_, size, coord, color);
+	}
+
+	//画像描画
+	void DWRendererSoft::drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord)
+	{
+		//フレームバッファ内にクリップ
+		const DWSize size = { srcArea.xmax_ - srcArea.xmin_, srcArea.ymax_ - srcArea.ymin_ };
+		DWArea dstArea;
+		DWCoord srcOffset;
+		if (!this->clipArea(coord, size, &dstArea, &srcOffset)) {
+			return;
+		}
+
+		const std::int32_t srcX = srcArea.xmin_ + srcOffset.x_;
+		const std::int32_t srcY = srcArea.ymin_ + srcOffset.y_;
+		const std::int32_t srcStride = bitmap.width_ * bitmap.bytePerPixel_;
+		const std::uint8_t* const srcImage = bitmap.image_ + (srcY * srcStride) + (srcX * bitmap.bytePerPixel_);
+		if (bitmap.format_ == DWPixelFormat::A8) {
+			//A8は白のマスクとして合成
+			const DWSize clipSize = { dstArea.xmax_ - dstArea.xmin_, dstArea.ymax_ - dstArea.ymin_ };
+			const DWCoord clipCoord = { dstArea.xmin_, dstArea.ymin_ };
+			const DWColor white = { 255, 255, 255, 255 };
+			this->blendAlpha(srcImage, srcStride, clipSize, clipCoord, white);
+			return;
+		}
+
+		//画素フォーマット毎の1行の合成関数
+		BlendRowFunc blend = nullptr;
+		switch (bitmap.format_) {
+		case DWPixelFormat::RGBA8888:
+			blend = (bitmap.isPremultiplied_) ? blendRow<DWPixelFormat::RGBA8888, 4, true> : blendRow<DWPixelFormat::RGBA8888, 4, false>;
+			break;
+		case DWPixelFormat::RGB565:
+			blend = blendRow<DWPixelFormat::RGB565, 2, false>;
+			break;
+		case DWPixelFormat::RGBA4444:
+			blend = (bitmap.isPremultiplied_) ? blendRow<DWPixelFormat::RGBA4444, 2, true> : blendRow<DWPixelFormat::RGBA4444, 2, false>;
+			break;
+		case DWPixelFormat::L8:
+			blend = blendRow<DWPixelFormat::L8, 1, false>;
+			break;
+		default:
+			return;
+		}
+
+		const std::int32_t stride = this->size_.width_ * BYTE_PER_PIXEL_RGBA8888;
+		for (std::int32_t h = dstArea.ymin_; h < dstArea.ymax_; h++) {
+			const std::uint8_t* rp = srcImage + ((h - dstArea.ymin_) * srcStride);
+			std::uint8_t* wp = this->frame_ + (h * stride) + (dstArea.xmin_ * BYTE_PER_PIXEL_RGBA8888);
+			blend(rp, wp, dstArea.xmax_ - dstArea.xmin_);
+		}
+	}
+	void DWRendererSoft::drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord)
+	{
+		const Resident* resident = this->getResident(bitmapID);
+		if (resident == nullptr) {
+			//未登録
+			return;
+		}
+
+		//常駐画像はそのまま参照して描画(転送不要)
+		this->drawBitmap(resident->bitmap_, srcArea, coord);
+	}
+
+	//フレームバッファ取得
+	void DWRendererSoft::getFrame(DWBitmap* const bitmap)
+	{
+		if (bitmap != nullptr) {
+			bitmap->width_ = this->size_.width_;
+			bitmap->height_ = this->size_.height_;
+			bitmap->bytePerPixel_ = BYTE_PER_PIXEL_RGBA8888;
+			bitmap->imageSize_ = this->frameSize_;
+			bitmap->image_ = this->frame_;
+			bitmap->format_ = DWPixelFormat::RGBA8888;
+			bitmap->isPremultiplied_ = false;
+		}
+	}
+
+	//描画終了したフレーム数取得
+	std::int32_t DWRendererSoft::getFrameNum()
+	{
+		return this->frameNum_;
+	}
+
+	//常駐画像のバックエンド資源を解放
+	void DWRendererSoft::releaseResident(Resident* const resident)
+	{
+		//画像データを直接参照しているため解放なし
+		(void)resident;
+	}
+
+	//アルファ画像を指定色で合成(imageは描画元左上、strideは1行のバイト数)
+	void DWRendererSoft::blendAlpha(const std::uint8_t* const image, const std::int32_t stride, const DWSize& size, const DWCoord& coord, const DWColor& color)
+	{
+		//フレームバッファ内にクリップ
+		DWArea dstArea;
+		DWCoord srcOffset;
+		if (!this->clipArea(coord, size, &dstArea, &srcOffset)) {
+			return;
+		}
+
+		const std::int32_t dstStride = this->size_.width_ * BYTE_PER_PIXEL_RGBA8888;
+		for (std::int32_t h = dstArea.ymin_; h < dstArea.ymax_; h++) {
+			const std::uint8_t* rp = image + ((srcOffset.y_ + (h - dstArea.ymin_)) * stride) + srcOffset.x_;
+			std::uint8_t* wp = this->frame_ + (h * dstStride) + (dstArea.xmin_ * BYTE_PER_PIXEL_RGBA8888);
+			for (std::int32_t w = dstArea.xmin_; w < dstArea.xmax_; w++) {
+				//被覆率と指定色のアルファを掛け合わせて合成
+				const std::uint8_t a = (color.a_ == 255) ? *rp : div255(*rp * color.a_);
+				blendPixel(wp, color.r_, color.g_, color.b_, a);
+				rp++;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+		}
+	}
+
+	//描画先領域をフレームバッファ内にクリップ(描画不要ならfalse)
+	bool DWRendererSoft::clipArea(const DWCoord& coord, const DWSize& size, DWArea* const dstArea, DWCoord* const srcOffset)
+	{
+		dstArea->xmin_ = (coord.x_ < 0) ? 0 : coord.x_;
+		dstArea->ymin_ = (coord.y_ < 0) ? 0 : coord.y_;
+		dstArea->xmax_ = coord.x_ + size.width_;
+		dstArea->ymax_ = coord.y_ + size.height_;
+		if (dstArea->xmax_ > this->size_.width_) { dstArea->xmax_ = this->size_.width_; }
+		if (dstArea->ymax_ > this->size_.height_) { dstArea->ymax_ = this->size_.height_; }
+
+		//クリップで切り取られた描画元の左上オフセット
+		srcOffset->x_ = dstArea->xmin_ - coord.x_;
+		srcOffset->y_ = dstArea->ymin_ - coord.y_;
+
+		return ((dstArea->xmin_ < dstArea->xmax_) && (dstArea->ymin_ < dstArea->ymax_));
+	}
+}
@@ -0,0 +1,206 @@
+﻿#ifndef INCLUDED_DWRENDERER_HPP
+#define INCLUDED_DWRENDERER_HPP
+
+#include "DWType.hpp"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <vector>
+
+//OpenGL
+#include <gl/GL.h>
+#endif
+
+namespace dw {
+
+	//DWRendererクラス(描画バックエンドの基底)
+	class DWRenderer {
+	protected:
+		//常駐画像
+		struct Resident {
+			bool			isValid_;	//登録済み
+			DWBitmap		bitmap_;	//登録画像(image_が識別キー)
+			std::uint32_t	handle_;	//バックエンド毎のハンドル(0:未作成)
+			bool			isDirty_;	//登録後に画像データを更新した
+			DWArea			dirtyArea_;	//更新領域
+		};
+
+		//常駐画像最大数
+		static const std::int32_t RESIDENT_MAXNUM = 32;
+
+		//メンバ変数
+		Resident		residents_[RESIDENT_MAXNUM];
+		std::int32_t	uploadByte_;		//現フレームの転送バイト数
+		std::int32_t	lastUploadByte_;	//前フレームの転送バイト数
+		std::int32_t	drawCallNum_;		//現フレームの描画コール数
+		std::int32_t	lastDrawCallNum_;	//前フレームの描画コール数
+
+	public:
+		//コンストラクタ
+		DWRenderer();
+		//デストラクタ
+		virtual ~DWRenderer();
+
+		//描画開始
+		virtual void beginDraw() = 0;
+		//描画終了
+		virtual void endDraw() = 0;
+		//画面塗りつぶし
+		virtual void clear(const DWColor& color) = 0;
+		//矩形塗りつぶし
+		virtual void fillRect(const DWArea& area, const DWColor& color) = 0;
+		//描画先サイズ更新(描画スレッドから呼ぶこと)
+		virtual void updateSize() = 0;
+		//描画先サイズ取得
+		virtual DWSize getSize() = 0;
+		//描画終了後もバックバッファの内容が保持されるか(falseなら毎フレーム全体再描画が必要)
+		virtual bool isBackBufferKept() = 0;
+		//アルファ画像(1ピクセル1バイト)を指定色で描画
+		virtual void drawAlpha(const std::uint8_t* const image, const DWSize& size, const DWCoord& coord, const DWColor& color) = 0;
+		virtual void drawAlpha(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord, const DWColor& color) = 0;
+		//画像描画
+		virtual void drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord) = 0;
+		virtual void drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord) = 0;
+
+		//常駐画像登録(画像データは登録解除まで保持すること)
+		std::int32_t registerBitmap(const DWBitmap& bitmap);
+		//常駐画像登録解除
+		void unregisterBitmap(const std::int32_t bitmapID);
+		//常駐画像の更新を通知(更新領域は次回描画時に再転送)
+		void updateBitmap(const std::int32_t bitmapID, const DWArea& area);
+		//常駐画像取得
+		const DWBitmap* getBitmap(const std::int32_t bitmapID);
+		//前フレームの転送バイト数取得
+		std::int32_t getUploadByte();
+		//前フレームの描画コール数取得
+		std::int32_t getDrawCallNum();
+
+	protected:
+		//常駐画像取得
+		Resident* getResident(const std::int32_t bitmapID);
+		//常駐画像のバックエンド資源を解放
+		virtual void releaseResident(Resident* const resident) = 0;
+		//フレーム統計を更新(endDrawで呼ぶ)
+		void updateFrameStat();
+
+	private:
+		//コピーコンストラクタ(禁止)
+		DWRenderer(const DWRenderer& org) = delete;
+		//代入演算子(禁止)
+		DWRenderer& operator=(const DWRenderer& org) = delete;
+	};
+
+#if defined(_WIN32)
+	//DWRendererGLクラス(Win32 + OpenGL)
+	class DWRendererGL : public DWRenderer {
+		//頂点(座標、テクスチャ座標、色)
+		struct Vertex {
+			GLfloat		x_;
+			GLfloat		y_;
+			GLfloat		u_;
+			GLfloat		v_;
+			GLubyte		r_;
+			GLubyte		g_;
+			GLubyte		b_;
+			GLubyte		a_;
+		};
+
+		//バッチ(同一テクスチャの矩形の集まり、endDrawでまとめて描画)
+		struct Batch {
+			GLuint				texID_;		//テクスチャ
+			bool				isPremultiplied_;	//乗算済みアルファ(GL_ONEで合成)
+			DWArea				bounds_;	//描画先の外接矩形
+			std::vector<Vertex>	vertices_;	//頂点配列(1矩形6頂点)
+		};
+
+		//メンバ変数
+		HWND				hWnd_;
+		HDC					hDC_;
+		HGLRC				hGLRC_;
+		bool				isSwapCopy_;	//SwapBuffersでバックバッファをコピー(内容を保持)
+		DWSize				size_;
+		std::vector<Batch>	batches_;		//バッチ(フレーム間で再利用)
+		std::int32_t		batchNum_;		//使用中のバッチ数
+		std::vector<GLuint>	oneshotTex_;	//フレーム内のみ使用するテクスチャ(描画後に破棄)
+		std::vector<GLuint>	releasedTex_;	//登録解除した常駐テクスチャ(描画スレッド外で解除した場合、次の描画終了時に破棄)
+
+	public:
+		//コンストラクタ
+		DWRendererGL(HWND hWnd);
+		//デストラクタ
+		virtual ~DWRendererGL();
+
+		virtual void beginDraw();
+		virtual void endDraw();
+		virtual void clear(const DWColor& color);
+		virtual void fillRect(const DWArea& area, const DWColor& color);
+		virtual void updateSize();
+		virtual DWSize getSize();
+		virtual bool isBackBufferKept();
+		virtual void drawAlpha(const std::uint8_t* const image, const DWSize& size, const DWCoord& coord, const DWColor& color);
+		virtual void drawAlpha(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord, const DWColor& color);
+		virtual void drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord);
+		virtual void drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord);
+
+	protected:
+		virtual void releaseResident(Resident* const resident);
+
+	private:
+		//テクスチャ付き矩形をバッチへ追加(isPremultipliedならテクスチャと頂点カラーは乗算済みアルファ)
+		void addQuad(const GLuint texID, const bool isPremultiplied, const DWSize& texSize, const DWArea& srcArea, const DWCoord& coord, const DWColor& color);
+		//バッチを描画
+		void flush();
+		//テクスチャ生成
+		GLuint createTexture();
+		//常駐画像のテクスチャ取得(未作成なら作成、更新領域があれば再転送)
+		GLuint getTexture(Resident* const resident);
+		//テクスチャ転送
+		void uploadTexture(const DWBitmap& bitmap, const DWArea& srcArea);
+		//テクスチャの部分更新
+		void updateTexture(const DWBitmap& bitmap, const DWArea& area);
+	};
+#endif
+
+	//DWRendererSoftクラス(CPU上のRGBA8888フレームバッファ、ヘッドレス)
+	class DWRendererSoft : public DWRenderer {
+		//メンバ変数
+		std::uint8_t*	frame_;			//フレームバッファ(RGBA8888)
+		std::int32_t	frameSize_;		//フレームバッファサイズ
+		DWSize			size_;
+		std::int32_t	frameNum_;		//描画終了したフレーム数
+
+	public:
+		//コンストラクタ
+		DWRendererSoft(const std::int32_t width, const std::int32_t height);
+		//デストラクタ
+		virtual ~DWRendererSoft();
+
+		virtual void beginDraw();
+		virtual void endDraw();
+		virtual void clear(const DWColor& color);
+		virtual void fillRect(const DWArea& area, const DWColor& color);
+		virtual void updateSize();
+		virtual DWSize getSize();
+		virtual bool isBackBufferKept();
+		virtual void drawAlpha(const std::uint8_t* const image, const DWSize& size, const DWCoord& coord, const DWColor& color);
+		virtual void drawAlpha(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord, const DWColor& color);
+		virtual void drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord);
+		virtual void drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord);
+
+		//フレームバッファ取得
+		void getFrame(DWBitmap* const bitmap);
+		//描画終了したフレーム数取得
+		std::int32_t getFrameNum();
+
+	protected:
+		virtual void releaseResident(Resident* const resident);
+
+	private:
+		//アルファ画像を指定色で合成(imageは描画元左上、strideは1行のバイト数)
+		void blendAlpha(const std::uint8_t* const image, const std::int32_t stride, const DWSize& size, const DWCoord& coord, const DWColor& color);
+		//描画先領域をフレームバッファ内にクリップ(描画不要ならfalse)
+		bool clipArea(const DWCoord& coord, const DWSize& size, DWArea* const dstArea, DWCoord* const srcOffset);
+	};
+};
+
+#endif //INCLUDED_DWRENDERER_HPP
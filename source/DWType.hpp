@@ -3,6 +3,26 @@
 
 #include <cstdint>
 
+#if !defined(_MSC_VER)
+#include <cstring>
+#include <ctime>
+
+//MSVC以外の環境向けにセキュア関数を定義
+inline int memcpy_s(void* const dest, const size_t destSize, const void* const src, const size_t count)
+{
+	if (count > destSize) {
+		//コピー先サイズ不足
+		return -1;
+	}
+	(void)memcpy(dest, src, count);
+	return 0;
+}
+inline int localtime_s(struct tm* const result, const time_t* const t)
+{
+	return (localtime_r(t, result) != nullptr) ? 0 : -1;
+}
+#endif
+
 namespace std {
 	typedef char char8_t;
 	typedef float float32_t;
@@ -17,6 +37,15 @@ namespace dw {
 		PNG,
 	};
 
+	//画素フォーマット(デコード出力、ビットマップ)
+	enum class DWPixelFormat {
+		RGBA8888,	//R,G,B,Aの順に4バイト
+		RGB565,		//16bit(上位からR5,G6,B5、ネイティブエンディアン、アルファなし)
+		RGBA4444,	//16bit(上位からR4,G4,B4,A4、ネイティブエンディアン)
+		A8,			//アルファ1バイト(白のマスクとして描画)
+		L8,			//輝度1バイト(アルファなし)
+	};
+
 	//サイズ
 	struct DWSize {
 		std::int32_t	width_;
@@ -59,6 +88,16 @@ namespace dw {
 		std::int32_t	bytePerPixel_;
 		std::int32_t	imageSize_;
 		std::uint8_t*	image_;
+		DWPixelFormat	format_;			//画素フォーマット
+		bool			isPremultiplied_;	//R,G,Bにアルファを乗算済み(RGBA8888,RGBA4444のみ)
+	};
+
+	//デコード出力先(呼び出し元のメモリへ直接デコードする場合に指定)
+	struct DWDecodeTarget {
+		std::uint8_t*	image_;		//出力先メモリ
+		std::int32_t	imageSize_;	//出力先メモリサイズ
+		std::int32_t	stride_;	//1行のバイト数
+		DWCoord			coord_;		//出力先内の書き込み位置(左上)
 	};
 
 	//時刻
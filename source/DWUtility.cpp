@@ -1,13 +1,37 @@
 ﻿#include "DWUtility.hpp"
+#include "DWPixelConv.hpp"
+
+#if !defined(_WIN32)
+//POSIX(ファイルマップ)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace {
 	//DWWindowインスタンス
 	dw::DWWindow* g_dwwindow = nullptr;
 	//グローバルミューテックス
 	std::mutex g_mtx;
+	//DWWorkerPoolのワーカー関数を実行中のスレッドか(ワーカー関数内からのrunは、runMtx_を取得せずに呼び出しスレッドのみで処理)
+	thread_local bool g_isPoolWork = false;
 
 	//RGBA8888画像の1ピクセルあたりのバイト数
 	static const std::int32_t BYTE_PER_PIXEL_RGBA8888 = 4;
+
+	//既定のフォントファイルパス(ヘッドレス版は引数で変更可)
+#if defined(_WIN32)
+	static const char* const FONT_FILE_PATH = "C:/Windows/Fonts/meiryo.ttc";
+#else
+	static const char* const FONT_FILE_PATH = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+#endif
+
+	//グリフキャッシュの上限バイト数
+	static const std::int32_t GLYPHCACHE_BYTEBUDGET = 256 * 1024;
+
+	//デコード済み画像キャッシュの上限バイト数
+	static const std::int32_t IMAGECACHE_BYTEBUDGET = 16 * 1024 * 1024;
 }
 
 namespace {
@@ -49,19 +73,387 @@ namespace {
 
 namespace dw {
 
+	//----------------------------------------------------------------
+	// DWGlyphCacheクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWGlyphCache::DWGlyphCache(const std::int32_t byteBudget) :
+		buckets_(), entries_(), byteBudget_(byteBudget), byteUsed_(0), generation_(0), hitNum_(0), missNum_(0)
+	{
+		for (std::int32_t i = 0; i < BUCKET_NUM; i++) {
+			this->buckets_[i] = -1;
+		}
+	}
+
+	//デストラクタ
+	DWGlyphCache::~DWGlyphCache()
+	{
+		this->clear();
+	}
+
+	//参照世代を進める(現世代で参照したグリフは追い出さない)
+	void DWGlyphCache::nextGeneration()
+	{
+		this->generation_++;
+	}
+
+	//グリフ取得(未キャッシュならFreeTypeで描画して登録、失敗時はnullptr)
+	DWGlyphCache::Glyph* DWGlyphCache::get(FT_Face face, const std::int32_t textSize, const FT_UInt index, const FT_Render_Mode renderMode)
+	{
+		//バケットを検索
+		const std::int32_t bucketNo = this->getBucketNo(face, textSize, index, renderMode);
+		for (std::int32_t e = this->buckets_[bucketNo]; e >= 0; e = this->entries_[e].next_) {
+			Entry* entry = &this->entries_[e];
+			if ((entry->face_ == face) && (entry->textSize_ == textSize) && (entry->index_ == index) && (entry->renderMode_ == renderMode)) {
+				//ヒット
+				entry->lastUse_ = this->generation_;
+				this->hitNum_++;
+				return &entry->glyph_;
+			}
+		}
+
+		//ミス
+		this->missNum_++;
+
+		//グリフを描画
+		Glyph glyph;
+		if (this->renderGlyph(face, textSize, index, renderMode, &glyph) != 0) {
+			return nullptr;
+		}
+		const std::int32_t glyphByte = glyph.metrics_.width_ * glyph.metrics_.height_;
+
+		//上限バイト数を超える間、古いエントリから追い出す
+		while ((this->byteUsed_ + glyphByte) > this->byteBudget_) {
+			if (this->evictOldest() < 0) {
+				//追い出せるエントリなし(現世代のグリフは一時的に上限を超えて保持)
+				break;
+			}
+		}
+
+		//空きエントリを検索(なければ追い出す)
+		std::int32_t entryNo = -1;
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			if (!this->entries_[i].isValid_) {
+				entryNo = i;
+				break;
+			}
+		}
+		if (entryNo < 0) {
+			entryNo = this->evictOldest();
+		}
+		if (entryNo < 0) {
+			//登録不可
+			delete[] glyph.image_;
+			return nullptr;
+		}
+
+		//登録してバケットの先頭へ連結
+		Entry* entry = &this->entries_[entryNo];
+		entry->isValid_ = true;
+		entry->face_ = face;
+		entry->textSize_ = textSize;
+		entry->index_ = index;
+		entry->renderMode_ = renderMode;
+		entry->glyph_ = glyph;
+		entry->lastUse_ = this->generation_;
+		entry->next_ = this->buckets_[bucketNo];
+		this->buckets_[bucketNo] = entryNo;
+		this->byteUsed_ += glyphByte;
+
+		return &entry->glyph_;
+	}
+
+	//上限バイト数設定
+	void DWGlyphCache::setByteBudget(const std::int32_t byteBudget)
+	{
+		this->byteBudget_ = byteBudget;
+
+		//上限を超えた分を追い出す
+		while (this->byteUsed_ > this->byteBudget_) {
+			if (this->evictOldest() < 0) {
+				break;
+			}
+		}
+	}
+
+	//全エントリ破棄
+	void DWGlyphCache::clear()
+	{
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			Entry* entry = &this->entries_[i];
+			if (entry->isValid_) {
+				delete[] entry->glyph_.image_;
+				entry->isValid_ = false;
+			}
+		}
+		for (std::int32_t i = 0; i < BUCKET_NUM; i++) {
+			this->buckets_[i] = -1;
+		}
+		this->byteUsed_ = 0;
+	}
+
+	//統計取得
+	std::int32_t DWGlyphCache::getHitNum()
+	{
+		return this->hitNum_;
+	}
+	std::int32_t DWGlyphCache::getMissNum()
+	{
+		return this->missNum_;
+	}
+	std::int32_t DWGlyphCache::getByteUsed()
+	{
+		return this->byteUsed_;
+	}
+
+	//ハッシュ値からバケット番号を算出
+	std::int32_t DWGlyphCache::getBucketNo(FT_Face face, const std::int32_t textSize, const FT_UInt index, const FT_Render_Mode renderMode)
+	{
+		std::uint32_t hash = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(face) >> 4);
+		hash = (hash * 31U) + static_cast<std::uint32_t>(textSize);
+		hash = (hash * 31U) + static_cast<std::uint32_t>(index);
+		hash = (hash * 31U) + static_cast<std::uint32_t>(renderMode);
+		hash *= 0x9E3779B1U;
+		return static_cast<std::int32_t>(hash >> 24) & (BUCKET_NUM - 1);
+	}
+
+	//グリフをA8画像へ描画
+	std::int32_t DWGlyphCache::renderGlyph(FT_Face face, const std::int32_t textSize, const FT_UInt index, const FT_Render_Mode renderMode, Glyph* const glyph)
+	{
+		std::int32_t rc = -1;
+		FT_Glyph image = nullptr;
+		FT_BitmapGlyph bit = nullptr;
+		std::int32_t imageSize = 0;
+
+		//フォントサイズ設定
+		FT_Set_Char_Size(face, textSize * 64, 0, 96, 0);
+
+		//グリフをロード
+		if (FT_Load_Glyph(face, index, FT_LOAD_DEFAULT) != 0) {
+			goto END;
+		}
+
+		//グリフを描画
+		if (FT_Get_Glyph(face->glyph, &image) != 0) {
+			image = nullptr;
+			goto END;
+		}
+		if (FT_Glyph_To_Bitmap(&image, renderMode, nullptr, 1) != 0) {
+			goto END;
+		}
+		bit = (FT_BitmapGlyph)image;
+		if ((bit->bitmap.rows > 0) && (bit->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)) {
+			//A8以外は未対応
+			goto END;
+		}
+
+		//寸法情報を取得
+		glyph->metrics_.width_ = bit->bitmap.width;
+		glyph->metrics_.height_ = bit->bitmap.rows;
+		glyph->metrics_.offsetX_ = bit->left;
+		glyph->metrics_.offsetY_ = bit->top;
+		glyph->metrics_.nextX_ = face->glyph->advance.x >> 6;
+		glyph->metrics_.nextY_ = face->glyph->advance.y >> 6;
+		glyph->metrics_.kerningX_ = 0;
+		glyph->metrics_.kerningY_ = 0;
+		glyph->atlasGeneration_ = 0;
+
+		//グリフイメージを詰めてコピー
+		imageSize = glyph->metrics_.width_ * glyph->metrics_.height_;
+		glyph->image_ = nullptr;
+		if (imageSize > 0) {
+			glyph->image_ = new std::uint8_t[imageSize];
+			for (std::int32_t h = 0; h < glyph->metrics_.height_; h++) {
+				memcpy(glyph->image_ + (h * glyph->metrics_.width_), bit->bitmap.buffer + (h * bit->bitmap.pitch), glyph->metrics_.width_);
+			}
+		}
+
+		rc = 0;
+	END:
+		if (image != nullptr) {
+			//グリフイメージ破棄
+			FT_Done_Glyph(image);
+		}
+		return rc;
+	}
+
+	//最も古いエントリを追い出す(追い出したエントリ番号、なければ-1)
+	std::int32_t DWGlyphCache::evictOldest()
+	{
+		//現世代以外で最終参照が最も古いエントリを検索
+		std::int32_t entryNo = -1;
+		std::uint32_t oldestAge = 0;
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			const Entry& entry = this->entries_[i];
+			const std::uint32_t age = this->generation_ - entry.lastUse_;
+			if ((entry.isValid_) && (age > 0) && ((entryNo < 0) || (age > oldestAge))) {
+				entryNo = i;
+				oldestAge = age;
+			}
+		}
+		if (entryNo < 0) {
+			return -1;
+		}
+
+		//バケットから切り離す
+		Entry* entry = &this->entries_[entryNo];
+		std::int32_t* link = &this->buckets_[this->getBucketNo(entry->face_, entry->textSize_, entry->index_, entry->renderMode_)];
+		while (*link != entryNo) {
+			link = &this->entries_[*link].next_;
+		}
+		*link = entry->next_;
+
+		//破棄
+		this->byteUsed_ -= entry->glyph_.metrics_.width_ * entry->glyph_.metrics_.height_;
+		delete[] entry->glyph_.image_;
+		entry->isValid_ = false;
+
+		return entryNo;
+	}
+
+
+
+	//----------------------------------------------------------------
+	// DWGlyphAtlasクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWGlyphAtlas::DWGlyphAtlas() :
+		page_(nullptr), shelves_(), shelfNum_(0), generation_(1)
+	{
+		//ページを確保
+		this->page_ = new std::uint8_t[PAGE_WIDTH * PAGE_HEIGHT];
+		memset(this->page_, 0, PAGE_WIDTH * PAGE_HEIGHT);
+	}
+
+	//デストラクタ
+	DWGlyphAtlas::~DWGlyphAtlas()
+	{
+		if (this->page_ != nullptr) {
+			delete[] this->page_;
+		}
+	}
+
+	//グリフを配置(イメージをページへコピー、空きがなければ-1)
+	std::int32_t DWGlyphAtlas::add(DWGlyphCache::Glyph* const glyph)
+	{
+		const std::int32_t w = glyph->metrics_.width_;
+		const std::int32_t h = glyph->metrics_.height_;
+		const std::int32_t paddedW = w + PADDING;
+		const std::int32_t paddedH = h + PADDING;
+
+		//収まるシェルフのうち、高さの余りが最小のものを選択
+		std::int32_t shelfNo = -1;
+		for (std::int32_t i = 0; i < this->shelfNum_; i++) {
+			const Shelf& shelf = this->shelves_[i];
+			if ((shelf.height_ >= paddedH) && ((shelf.x_ + paddedW) <= PAGE_WIDTH)) {
+				if ((shelfNo < 0) || (shelf.height_ < this->shelves_[shelfNo].height_)) {
+					shelfNo = i;
+				}
+			}
+		}
+
+		if (shelfNo < 0) {
+			//新しいシェルフを最下段に追加
+			const std::int32_t y = (this->shelfNum_ == 0) ? 0 : (this->shelves_[this->shelfNum_ - 1].y_ + this->shelves_[this->shelfNum_ - 1].height_);
+			if ((this->shelfNum_ >= SHELF_MAXNUM) || ((y + paddedH) > PAGE_HEIGHT) || (paddedW > PAGE_WIDTH)) {
+				//空きなし
+				return -1;
+			}
+			shelfNo = this->shelfNum_;
+			this->shelfNum_++;
+
+			Shelf* shelf = &this->shelves_[shelfNo];
+			shelf->y_ = y;
+			shelf->height_ = paddedH;
+			shelf->x_ = 0;
+		}
+
+		//シェルフの末尾へ配置
+		Shelf* shelf = &this->shelves_[shelfNo];
+		glyph->atlasArea_.xmin_ = shelf->x_;
+		glyph->atlasArea_.ymin_ = shelf->y_;
+		glyph->atlasArea_.xmax_ = shelf->x_ + w;
+		glyph->atlasArea_.ymax_ = shelf->y_ + h;
+		glyph->atlasGeneration_ = this->generation_;
+		shelf->x_ += paddedW;
+
+		//グリフイメージをコピー
+		for (std::int32_t y = 0; y < h; y++) {
+			memcpy(this->page_ + ((glyph->atlasArea_.ymin_ + y) * PAGE_WIDTH) + glyph->atlasArea_.xmin_, glyph->image_ + (y * w), w);
+		}
+
+		return 0;
+	}
+
+	//全配置を破棄(配置世代を進める)
+	void DWGlyphAtlas::reset()
+	{
+		//余白に前の配置が残らないようにクリア
+		memset(this->page_, 0, PAGE_WIDTH * PAGE_HEIGHT);
+		this->shelfNum_ = 0;
+		this->generation_++;
+	}
+
+	//配置世代取得
+	std::uint32_t DWGlyphAtlas::getGeneration()
+	{
+		return this->generation_;
+	}
+
+	//ページ取得
+	void DWGlyphAtlas::getPage(DWBitmap* const bitmap)
+	{
+		if (bitmap != nullptr) {
+			bitmap->width_ = PAGE_WIDTH;
+			bitmap->height_ = PAGE_HEIGHT;
+			bitmap->bytePerPixel_ = 1;
+			bitmap->imageSize_ = PAGE_WIDTH * PAGE_HEIGHT;
+			bitmap->image_ = this->page_;
+			bitmap->format_ = DWPixelFormat::A8;
+			bitmap->isPremultiplied_ = false;
+		}
+	}
+
+
+
 	//----------------------------------------------------------------
 	// DWWindowクラス
 	//----------------------------------------------------------------
 
-	//作成
+#if defined(_WIN32)
+	//作成(Win32ウィンドウへOpenGLで描画)
 	void DWWindow::create(void* native)
 	{
 		//Windowインスタンスが未生成なら生成する
 		g_mtx.lock();
 		if (g_dwwindow == nullptr) {
-			g_dwwindow = new DWWindow(static_cast<HWND>(native));
+			g_dwwindow = new DWWindow(new DWRendererGL(static_cast<HWND>(native)), FONT_FILE_PATH);
+		}
+		g_mtx.unlock();
+	}
+#endif
+
+	//作成(ヘッドレス、CPU上のフレームバッファへ描画、fontPathがnullptrなら既定のフォント、フォントを読み込めなければ作成せず-1)
+	std::int32_t DWWindow::createHeadless(const std::int32_t width, const std::int32_t height, const char* const fontPath)
+	{
+		std::int32_t rc = 0;
+
+		//Windowインスタンスが未生成なら生成する
+		g_mtx.lock();
+		if (g_dwwindow == nullptr) {
+			g_dwwindow = new DWWindow(new DWRendererSoft(width, height), (fontPath != nullptr) ? fontPath : FONT_FILE_PATH);
+			if (g_dwwindow->ftFace_ == nullptr) {
+				//フォント読み込み失敗(文字列を描画できないため破棄)
+				delete g_dwwindow;
+				g_dwwindow = nullptr;
+				rc = -1;
+			}
 		}
 		g_mtx.unlock();
+
+		return rc;
 	}
 
 	//取得
@@ -70,6 +462,12 @@ namespace dw {
 		return g_dwwindow;
 	}
 
+	//既定のフォントファイルパス取得
+	const char* DWWindow::getDefaultFontPath()
+	{
+		return FONT_FILE_PATH;
+	}
+
 	//破棄
 	void DWWindow::destroy()
 	{
@@ -84,407 +482,712 @@ namespace dw {
 	//描画開始
 	void DWWindow::beginDraw()
 	{
-		if (this->hGLRC_ == nullptr) {
-			//描画コンテキストハンドルを作成
-			this->hGLRC_ = ::wglCreateContext(this->hDC_);
-
-			//描画コンテキストをカレントに設定
-			::wglMakeCurrent(this->hDC_, this->hGLRC_);
-		}
-
-		//ビューポート設定
-		glViewport(0, 0, this->size_.width_, this->size_.height_);
-
-		//プロジェクション設定(正射影)
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
-		glOrtho(0.0, this->size_.width_, this->size_.height_, 0.0, -1.0, 1.0);
-
-		//モデルビュー設定
-		glMatrixMode(GL_MODELVIEW);
-		glLoadIdentity();
+		this->renderer_->beginDraw();
 	}
 
 	//描画終了
 	void DWWindow::endDraw()
 	{
-		::SwapBuffers(this->hDC_);
+		this->renderer_->endDraw();
 	}
 
 	//画面塗りつぶし
 	void DWWindow::clear(const DWColor& color)
 	{
-		GLclampf r = static_cast<std::float32_t>(color.r_) / 255.0F;
-		GLclampf g = static_cast<std::float32_t>(color.g_) / 255.0F;
-		GLclampf b = static_cast<std::float32_t>(color.b_) / 255.0F;
-		GLclampf a = static_cast<std::float32_t>(color.a_) / 255.0F;
+		this->renderer_->clear(color);
+	}
+
+	//矩形塗りつぶし
+	void DWWindow::fillRect(const DWArea& area, const DWColor& color)
+	{
+		this->renderer_->fillRect(area, color);
+	}
+
+	//ウィンドウサイズ更新(描画スレッドから呼ぶこと)
+	void DWWindow::updateSize()
+	{
+		this->renderer_->updateSize();
+	}
+
+	//ウィンドウサイズ取得
+	DWSize DWWindow::getSize()
+	{
+		return this->renderer_->getSize();
+	}
+
+	//描画終了後もバックバッファの内容が保持されるか(falseなら毎フレーム全体再描画が必要)
+	bool DWWindow::isBackBufferKept()
+	{
+		return this->renderer_->isBackBufferKept();
+	}
+
+	//文字列の行高さ取得[pixel]
+	std::int32_t DWWindow::getTextLineHeight(const std::int32_t textSize)
+	{
+		if (this->ftFace_ == nullptr) {
+			//フォント未読み込み
+			return 0;
+		}
 
-		glClearColor(r, g, b, a);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		//フォントサイズ設定(drawTextと同じ設定)
+		FT_Set_Char_Size(this->ftFace_, textSize * 64, 0, 96, 0);
+
+		//行高さ(26.6固定小数点)を切り上げ
+		return static_cast<std::int32_t>((this->ftFace_->size->metrics.height + 63) >> 6);
 	}
 
 	//文字描画
 	void DWWindow::drawText(const DWText& text, const DWCoord& coord, const DWColor& color)
 	{
-		//テキスト文字列のフォントグリフ保持用
+		if (this->ftFace_ == nullptr) {
+			//フォント未読み込み
+			return;
+		}
+
+		//テキスト文字列のグリフ保持用
 		const std::int32_t MAX_GLYPHS = 32;
-		FontGlyph glyphs[MAX_GLYPHS];
+		DWGlyphCache::Glyph* glyphs[MAX_GLYPHS];
 		std::int32_t numGlyphs = 0;
 
 		//文字列のバウンディングボックス
-		FT_BBox stringBBox;
+		FT_BBox stringBBox = { 0, 0, 0, 0 };
 
-		//フォントサイズ設定
-		FT_Set_Char_Size(this->ftFace_, text.textSize_ * 64, 0, 96, 0);
+		//この文字列のグリフは描画が終わるまで追い出さない
+		this->glyphCache_.nextGeneration();
 
 		//テキスト文字分ループ
-		DWCoord baseCoord = coord;
-		for (std::int32_t i = 0; i < text.textNum_; i++) {
-			//処理対象文字のグリフ格納用
-			FontGlyph* glyph = &glyphs[numGlyphs];
-
+		for (std::int32_t i = 0; (i < text.textNum_) && (numGlyphs < MAX_GLYPHS); i++) {
 			//グリフインデックスを取得
-			glyph->index_ = FT_Get_Char_Index(this->ftFace_, text.text_[i]);
-
-			//グリフをロード
-			FT_Load_Glyph(this->ftFace_, glyph->index_, FT_LOAD_DEFAULT);
+			const FT_UInt index = FT_Get_Char_Index(this->ftFace_, text.text_[i]);
 
-			//グリフを描画
-			FT_Get_Glyph(this->ftFace_->glyph, &glyph->image_);
-			FT_Glyph_To_Bitmap(&glyph->image_, FT_RENDER_MODE_NORMAL, nullptr, 1);
-
-			//寸法情報を取得
-			FT_BitmapGlyph bit = (FT_BitmapGlyph)glyph->image_;
-			glyph->metrics_.width_ = bit->bitmap.width;
-			glyph->metrics_.height_ = bit->bitmap.rows;
-			glyph->metrics_.offsetX_ = bit->left;
-			glyph->metrics_.offsetY_ = bit->top;
-			glyph->metrics_.nextX_ = this->ftFace_->glyph->advance.x >> 6;
-			glyph->metrics_.nextY_ = this->ftFace_->glyph->advance.y >> 6;
+			//グリフを取得(未キャッシュなら描画)
+			DWGlyphCache::Glyph* glyph = this->glyphCache_.get(this->ftFace_, text.textSize_, index, FT_RENDER_MODE_NORMAL);
+			if (glyph == nullptr) {
+				continue;
+			}
+			glyphs[numGlyphs] = glyph;
 
-			//処理対象文字のバウンディングボックスを取得
-			FT_BBox bbox;
-			FT_Glyph_Get_CBox(glyph->image_, ft_glyph_bbox_pixels, &bbox);
+			//処理対象文字のバウンディングボックス
+			const std::int32_t yMin = glyph->metrics_.offsetY_ - glyph->metrics_.height_;
+			const std::int32_t yMax = glyph->metrics_.offsetY_;
 
-			if (i == 0) {
+			if (numGlyphs == 0) {
 				stringBBox.xMin = 0;
 				stringBBox.xMax = glyph->metrics_.nextX_;
-				stringBBox.yMin = bbox.yMin;
-				stringBBox.yMax = bbox.yMax;
+				stringBBox.yMin = yMin;
+				stringBBox.yMax = yMax;
 			}
 			else {
 				stringBBox.xMin = 0;
 				stringBBox.xMax += glyph->metrics_.nextX_;
-				if (bbox.yMin < stringBBox.yMin) { stringBBox.yMin = bbox.yMin; }
-				if (bbox.yMax > stringBBox.yMax) { stringBBox.yMax = bbox.yMax; }
+				if (yMin < stringBBox.yMin) { stringBBox.yMin = yMin; }
+				if (yMax > stringBBox.yMax) { stringBBox.yMax = yMax; }
 			}
 
 			//次文字へ
 			numGlyphs++;
 		}
 
-		//文字列の幅高さ
-		const std::int32_t stringW = stringBBox.xMax - stringBBox.xMin;
-		const std::int32_t stringH = stringBBox.yMax - stringBBox.yMin;
-		const std::int32_t stringSize = stringW * stringH;
-
-		//文字列画像の領域を確保
-		std::uint8_t* tex = new std::uint8_t[stringSize];
-		memset(tex, 0, stringSize);
+		//未配置のグリフをグリフアトラスへ配置
+		if (this->placeGlyphs(glyphs, numGlyphs) != 0) {
+			//空きがなければ作り直して、この文字列のグリフのみ配置し直す
+			DWBitmap page;
+			this->glyphAtlas_.reset();
+			this->glyphAtlas_.getPage(&page);
+			const DWArea pageArea = { 0, 0, page.width_, page.height_ };
+			this->renderer_->updateBitmap(this->glyphPageID_, pageArea);
+			this->placeGlyphs(glyphs, numGlyphs);
+		}
 
-		//文字列画像を生成
+		//グリフ毎にグリフアトラスから描画(文字列の上端をcoordに合わせる)
 		FT_Vector pen = { 0, stringBBox.yMax };
 		for (std::int32_t i = 0; i < numGlyphs; i++) {
 			//処理対象文字のグリフを取得
-			FontGlyph* glyph = &glyphs[i];
-			FT_BitmapGlyph bit = (FT_BitmapGlyph)glyph->image_;
-
-			const std::int32_t xoffset = pen.x + glyph->metrics_.offsetX_;
-			const std::int32_t yoffset = pen.y - glyph->metrics_.offsetY_;
-			std::int32_t readOffset = 0;
-			std::int32_t writeOffset = xoffset + (yoffset * stringW);
-			for (std::int32_t h = 0; h < glyph->metrics_.height_; h++) {
-				memcpy_s(tex + writeOffset, stringW, bit->bitmap.buffer + readOffset, glyph->metrics_.width_);
-				readOffset += glyph->metrics_.width_;
-				writeOffset += stringW;
+			const DWGlyphCache::Glyph* glyph = glyphs[i];
+
+			if ((glyph->image_ != nullptr) && (glyph->atlasGeneration_ != 0)) {
+				const DWCoord glyphCoord = {
+					coord.x_ + static_cast<std::int32_t>(pen.x) + glyph->metrics_.offsetX_,
+					coord.y_ + static_cast<std::int32_t>(pen.y) - glyph->metrics_.offsetY_
+				};
+				this->renderer_->drawAlpha(this->glyphPageID_, glyph->atlasArea_, glyphCoord, color);
 			}
 
 			pen.x += glyph->metrics_.nextX_;
-
-			//グリフイメージ破棄
-			FT_Done_Glyph(glyph->image_);
-		}
-
-		//GL描画設定
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glEnable(GL_BLEND);
-		glEnable(GL_TEXTURE_2D);
-
-		//テクスチャ生成
-		GLuint texID;
-		glGenTextures(1, &texID);
-
-		//テクスチャバインド
-		glBindTexture(GL_TEXTURE_2D, texID);
-
-		//テクスチャロード(ロード後、文字列画像の領域を解放)
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, stringW, stringH, 0, GL_ALPHA, GL_UNSIGNED_BYTE, tex);
-		delete[] tex;
-
-		//テクスチャパラメータ設定
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-		DWArea drawArea;
-		drawArea.xmin_ = baseCoord.x_;
-		drawArea.ymin_ = baseCoord.y_;
-		drawArea.xmax_ = baseCoord.x_ + stringW;
-		drawArea.ymax_ = baseCoord.y_ + stringH;;
-
-		//描画
-		glColor4ub(color.r_, color.g_, color.b_, color.a_);
-		glBegin(GL_TRIANGLE_STRIP);
-		glTexCoord2f(0.0F, 0.0F);
-		glVertex2i(drawArea.xmin_, drawArea.ymin_);
-		glTexCoord2f(1.0F, 0.0F);
-		glVertex2i(drawArea.xmax_, drawArea.ymin_);
-		glTexCoord2f(0.0F, 1.0F);
-		glVertex2i(drawArea.xmin_, drawArea.ymax_);
-		glTexCoord2f(1.0F, 1.0F);
-		glVertex2i(drawArea.xmax_, drawArea.ymax_);
-		glEnd();
-
-		//テクスチャアンバインド
-		glBindTexture(GL_TEXTURE_2D, 0);
-		//テクスチャ破棄
-		glDeleteTextures(1, &texID);
-
-		glDisable(GL_TEXTURE_2D);
-		glDisable(GL_BLEND);
+		}
 	}
 
 	//画像描画
 	void DWWindow::drawBitmap(const DWBitmap& bitmap, const DWCoord& coord)
 	{
-		//GL描画設定
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glEnable(GL_BLEND);
-		glEnable(GL_TEXTURE_2D);
-
-		//テクスチャ生成
-		GLuint texID;
-		glGenTextures(1, &texID);
-
-		//テクスチャバインド
-		glBindTexture(GL_TEXTURE_2D, texID);
-
-		//テクスチャロード
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bitmap.width_, bitmap.height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap.image_);
-
-		//テクスチャパラメータ設定
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-		//テクスチャ環境
-		//テクスチャカラーを使用する
-		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-		DWArea drawArea;
-		drawArea.xmin_ = coord.x_;
-		drawArea.ymin_ = coord.y_;
-		drawArea.xmax_ = coord.x_ + bitmap.width_;
-		drawArea.ymax_ = coord.y_ + bitmap.height_;
-
-		//描画
-		glColor4ub(255, 255, 255, 255);
-		glBegin(GL_TRIANGLE_STRIP);
-		glTexCoord2f(0.0F, 0.0F);
-		glVertex2i(drawArea.xmin_, drawArea.ymin_);
-		glTexCoord2f(1.0F, 0.0F);
-		glVertex2i(drawArea.xmax_, drawArea.ymin_);
-		glTexCoord2f(0.0F, 1.0F);
-		glVertex2i(drawArea.xmin_, drawArea.ymax_);
-		glTexCoord2f(1.0F, 1.0F);
-		glVertex2i(drawArea.xmax_, drawArea.ymax_);
-		glEnd();
-
-		//テクスチャアンバインド
-		glBindTexture(GL_TEXTURE_2D, 0);
-		//テクスチャ破棄
-		glDeleteTextures(1, &texID);
-
-		glDisable(GL_TEXTURE_2D);
-		glDisable(GL_BLEND);
+		//画像全体を描画
+		const DWArea srcArea = { 0, 0, bitmap.width_, bitmap.height_ };
+		this->drawBitmap(bitmap, srcArea, coord);
+	}
+	void DWWindow::drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord)
+	{
+		this->renderer_->drawBitmap(bitmap, srcArea, coord);
 	}
+	void DWWindow::drawBitmap(const std::int32_t bitmapID, const DWCoord& coord)
+	{
+		const DWBitmap* bitmap = this->renderer_->getBitmap(bitmapID);
+		if (bitmap == nullptr) {
+			//未登録
+			return;
+		}
 
-	//コンストラクタ
-	DWWindow::DWWindow(HWND hWnd) :
-		hWnd_(hWnd), hDC_(nullptr), hGLRC_(nullptr), ftLibrary_(nullptr), ftFace_(nullptr), size_()
-	{
-		//デバイスコンテキストハンドルを取得
-		this->hDC_ = ::GetDC(this->hWnd_);
-
-		//ピクセルフォーマット
-		const PIXELFORMATDESCRIPTOR pFormat = {
-			sizeof(PIXELFORMATDESCRIPTOR),	//nSize
-			1,		//nVersion
-			PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,	//dwFlags
-			PFD_TYPE_RGBA,	//iPixelType
-			32,		//cColorBits
-			0,		//cRedBits
-			0,		//cRedShift
-			0,		//cGreenBits
-			0,		//cGreenShift
-			0,		//cBlueBits
-			0,		//cBlueShift
-			0,		//cAlphaBits
-			0,		//cAlphaShift
-			0,		//cAccumBits
-			0,		//cAccumRedBits
-			0,		//cAccumGreenBits
-			0,		//cAccumBlueBits
-			0,		//cAccumAlphaBits
-			24,		//cDepthBits
-			8,		//cStencilBits
-			0,		//cAuxBuffers
-			0,		//iLayerType
-			0,		//bReserved
-			0,		//dwLayerMask
-			0,		//dwVisibleMask
-			0		//dwDamageMask
-		};
-
-		//ピクセルフォーマットを選択
-		std::int32_t format = ::ChoosePixelFormat(this->hDC_, &pFormat);
-		::SetPixelFormat(this->hDC_, format, &pFormat);
+		//画像全体を描画
+		const DWArea srcArea = { 0, 0, bitmap->width_, bitmap->height_ };
+		this->renderer_->drawBitmap(bitmapID, srcArea, coord);
+	}
+	void DWWindow::drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord)
+	{
+		this->renderer_->drawBitmap(bitmapID, srcArea, coord);
+	}
+
+	//常駐画像登録(画像データは登録解除まで保持すること)
+	std::int32_t DWWindow::registerBitmap(const DWBitmap& bitmap)
+	{
+		return this->renderer_->registerBitmap(bitmap);
+	}
+
+	//常駐画像登録解除
+	void DWWindow::unregisterBitmap(const std::int32_t bitmapID)
+	{
+		this->renderer_->unregisterBitmap(bitmapID);
+	}
+
+	//前フレームのテクスチャ転送バイト数取得
+	std::int32_t DWWindow::getUploadByte()
+	{
+		return this->renderer_->getUploadByte();
+	}
+
+	//前フレームの描画コール数取得
+	std::int32_t DWWindow::getDrawCallNum()
+	{
+		return this->renderer_->getDrawCallNum();
+	}
+
+	//グリフキャッシュ取得
+	DWGlyphCache* DWWindow::getGlyphCache()
+	{
+		return &this->glyphCache_;
+	}
+
+	//描画バックエンド取得
+	DWRenderer* DWWindow::getRenderer()
+	{
+		return this->renderer_;
+	}
+
+	//未配置のグリフをグリフアトラスへ配置
+	std::int32_t DWWindow::placeGlyphs(DWGlyphCache::Glyph* const* const glyphs, const std::int32_t glyphNum)
+	{
+		std::int32_t rc = 0;
+
+		for (std::int32_t i = 0; i < glyphNum; i++) {
+			DWGlyphCache::Glyph* glyph = glyphs[i];
+			if ((glyph->image_ == nullptr) || (glyph->atlasGeneration_ == this->glyphAtlas_.getGeneration())) {
+				//イメージなし(空白)、または配置済み
+				continue;
+			}
+
+			if (this->glyphAtlas_.add(glyph) != 0) {
+				//空きなし
+				glyph->atlasGeneration_ = 0;
+				rc = -1;
+				continue;
+			}
+
+			//配置した領域を次回描画時に転送
+			this->renderer_->updateBitmap(this->glyphPageID_, glyph->atlasArea_);
+		}
+
+		return rc;
+	}
 
+	//コンストラクタ
+	DWWindow::DWWindow(DWRenderer* const renderer, const char* const fontPath) :
+		renderer_(renderer), ftLibrary_(nullptr), ftFace_(nullptr), glyphCache_(GLYPHCACHE_BYTEBUDGET), glyphAtlas_(), glyphPageID_(-1)
+	{
 		//FreeType開始
 		FT_Init_FreeType(&this->ftLibrary_);
-		//MeiryoUIフォントのフェイスを生成
-		FT_New_Face(this->ftLibrary_, "C:/Windows/Fonts/meiryo.ttc", 0, &this->ftFace_);
+		//フォントのフェイスを生成(WindowsはMeiryoUI)
+		if (FT_New_Face(this->ftLibrary_, fontPath, 0, &this->ftFace_) != 0) {
+			this->ftFace_ = nullptr;
+		}
 
-		//ウィンドウサイズを取得
-		RECT rect;
-		::GetClientRect(hWnd, &rect);
-		this->size_.width_ = rect.right - rect.left;
-		this->size_.height_ = rect.bottom - rect.top;
+		//グリフアトラスを常駐画像として登録
+		DWBitmap page;
+		this->glyphAtlas_.getPage(&page);
+		this->glyphPageID_ = this->renderer_->registerBitmap(page);
 	}
 
 	//デストラクタ
 	DWWindow::~DWWindow()
 	{
+		//グリフアトラスの登録解除、グリフキャッシュを破棄
+		this->renderer_->unregisterBitmap(this->glyphPageID_);
+		this->glyphCache_.clear();
+
 		//フェイスを破棄
-		FT_Done_Face(this->ftFace_);
+		if (this->ftFace_ != nullptr) {
+			FT_Done_Face(this->ftFace_);
+		}
 		//FreeType終了
 		FT_Done_FreeType(this->ftLibrary_);
 
-		//カレントを解除
-		::wglMakeCurrent(this->hDC_, nullptr);
-
-		if (this->hGLRC_ != nullptr) {
-			//描画コンテキストハンドルを破棄
-			::wglDeleteContext(this->hGLRC_);
-		}
-
-		if (this->hDC_ != nullptr) {
-			//デバイスコンテキストを破棄
-			::ReleaseDC(this->hWnd_, this->hDC_);
-		}
+		//描画バックエンドを破棄
+		delete this->renderer_;
 	}
 
 
 	//----------------------------------------------------------------
-	// DWImageDecorderクラス
+	// DWFileMapクラス
 	//----------------------------------------------------------------
 
 	//コンストラクタ
-	DWImageDecorder::DWImageDecorder() :
-		decData_(nullptr), decDataSize_(0), width_(0), height_(0)
+	DWFileMap::DWFileMap() :
+		data_(nullptr), size_(0), isMapped_(false)
 	{
 	}
 
 	//デストラクタ
-	DWImageDecorder::~DWImageDecorder()
+	DWFileMap::~DWFileMap()
 	{
-		if (this->decData_ != nullptr) {
-			delete[] this->decData_;
-		}
+		this->close();
 	}
 
-	//RGBA8888画像へデコード
-	std::int32_t DWImageDecorder::decode_RGBA8888(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const bool isFlip)
+	//オープン(isMapEnableがfalseまたはマップ失敗時は全体を読み込む、MAP_MINSIZE未満は常に読み込む)
+	std::int32_t DWFileMap::open(const std::char8_t* const filePath, const bool isMapEnable)
 	{
 		std::int32_t rc = -1;
 
-		//画像データ
-		std::uint8_t* bodyData = nullptr;
-		std::uint8_t* blendData = nullptr;
-		std::int32_t bodyDataSize = 0;
-		std::int32_t blendDataSize = 0;
+		//以前のファイルがあればクローズ
+		this->close();
 
-		//本体画像ファイルオープン
-		std::ifstream ifs_body(bodyFilePath, std::ios::binary);
-		if (!ifs_body) {
-			//オープン失敗
-			goto END;
+		if (isMapEnable) {
+			rc = this->map(filePath);
 		}
-
-		//本体画像データサイズ取得
-		ifs_body.seekg(0, std::ios::end);
-		bodyDataSize = static_cast<std::int32_t>(ifs_body.tellg());
-		ifs_body.seekg(0, std::ios::beg);
-		if (bodyDataSize <= 0) {
-			//サイズ異常
-			goto END;
+		if (rc < 0) {
+			//マップできない場合は全体を読み込む
+			rc = this->read(filePath);
 		}
 
-		//本体画像データ領域を確保し、ファイル読み込み
-		bodyData = new std::uint8_t[bodyDataSize];
-		ifs_body.read(reinterpret_cast<std::char8_t*>(bodyData), bodyDataSize);
+		return rc;
+	}
 
-		//ブレンド画像ファイルの指定があれば、ブレンド画像を読み込む
-		if (blendFilePath != nullptr) {
-			//ブレンド画像ファイルオープン
-			std::ifstream ifs_blend(blendFilePath, std::ios::binary);
-			if (!ifs_blend) {
-				//オープン失敗
-				goto END;
+	//クローズ
+	void DWFileMap::close()
+	{
+		if (this->data_ != nullptr) {
+			if (this->isMapped_) {
+#if defined(_WIN32)
+				(void)::UnmapViewOfFile(this->data_);
+#else
+				(void)::munmap(this->data_, static_cast<size_t>(this->size_));
+#endif
+			}
+			else {
+				delete[] this->data_;
 			}
+		}
+		this->data_ = nullptr;
+		this->size_ = 0;
+		this->isMapped_ = false;
+	}
+
+	//データ取得
+	std::uint8_t* DWFileMap::getData()
+	{
+		return this->data_;
+	}
+
+	//サイズ取得
+	std::int32_t DWFileMap::getSize()
+	{
+		return this->size_;
+	}
+
+	//マップ済みか
+	bool DWFileMap::isMapped()
+	{
+		return this->isMapped_;
+	}
+
+	//ファイルをページキャッシュから破棄(コールド計測用、未対応環境は-1)
+	std::int32_t DWFileMap::dropCache(const std::char8_t* const filePath)
+	{
+		std::int32_t rc = -1;
+#if defined(_WIN32)
+		//Win32はファイル単位でキャッシュを破棄できないため未対応
+		(void)filePath;
+#else
+		const int fd = ::open(filePath, O_RDONLY);
+		if (fd >= 0) {
+			//変更のないページのみ破棄される(画像ファイルは読み込み専用)
+			rc = (::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0) ? 0 : -1;
+			(void)::close(fd);
+		}
+#endif
+		return rc;
+	}
+
+	//ファイルの更新時刻取得(環境毎の単位、比較にのみ使用)
+	std::int32_t DWFileMap::getModifiedTime(const std::char8_t* const filePath, std::int64_t* const mtime)
+	{
+		std::int32_t rc = -1;
+#if defined(_WIN32)
+		//100ns単位
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (::GetFileAttributesExA(filePath, GetFileExInfoStandard, &data) != 0) {
+			*mtime = (static_cast<std::int64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | static_cast<std::int64_t>(data.ftLastWriteTime.dwLowDateTime);
+			rc = 0;
+		}
+#else
+		struct stat st;
+		if (::stat(filePath, &st) == 0) {
+#if defined(__linux__)
+			//ns単位
+			*mtime = (static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000) + static_cast<std::int64_t>(st.st_mtim.tv_nsec);
+#else
+			//秒単位
+			*mtime = static_cast<std::int64_t>(st.st_mtime);
+#endif
+			rc = 0;
+		}
+#endif
+		return rc;
+	}
+
+	//マップ(MAP_MINSIZE未満は同じハンドルから読み込む)
+	std::int32_t DWFileMap::map(const std::char8_t* const filePath)
+	{
+		std::int32_t rc = -1;
+
+#if defined(_WIN32)
+		HANDLE hMap = nullptr;
+		LARGE_INTEGER fileSize;
+		fileSize.QuadPart = 0;
+
+		//ファイルオープン
+		HANDLE hFile = ::CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) {
+			//オープン失敗
+			goto END;
+		}
 
-			//ブレンド画像データサイズ取得
-			ifs_blend.seekg(0, std::ios::end);
-			blendDataSize = static_cast<std::int32_t>(ifs_blend.tellg());
-			ifs_blend.seekg(0, std::ios::beg);
-			if (blendDataSize <= 0) {
-				//サイズ異常
+		//ファイルサイズ取得(空ファイルはマップできない)
+		if ((::GetFileSizeEx(hFile, &fileSize) == 0) || (fileSize.QuadPart <= 0) || (fileSize.QuadPart > INT32_MAX)) {
+			goto END;
+		}
+		this->size_ = static_cast<std::int32_t>(fileSize.QuadPart);
+
+		if (this->size_ < MAP_MINSIZE) {
+			//小さいファイルはマップせず、同じハンドルから読み込む
+			DWORD readByte = 0;
+			this->data_ = new std::uint8_t[this->size_];
+			if ((::ReadFile(hFile, this->data_, static_cast<DWORD>(this->size_), &readByte, nullptr) == 0) || (readByte != static_cast<DWORD>(this->size_))) {
+				this->close();
 				goto END;
 			}
+			rc = 0;
+			goto END;
+		}
 
-			//ブレンド画像データ領域を確保し、ファイル読み込み
-			blendData = new std::uint8_t[blendDataSize];
-			ifs_blend.read(reinterpret_cast<std::char8_t*>(blendData), blendDataSize);
+		//マップ(ビューを作成すればハンドルは閉じてよい)
+		hMap = ::CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (hMap == nullptr) {
+			goto END;
 		}
+		this->data_ = static_cast<std::uint8_t*>(::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0));
+		if (this->data_ == nullptr) {
+			this->size_ = 0;
+			goto END;
+		}
+		this->isMapped_ = true;
 
-		//RGBA8888画像へデコード
-		rc = this->decode_RGBA8888(bodyData, bodyDataSize, blendData, blendDataSize, format, isFlip);
+		//正常終了
+		rc = 0;
+
+	END:
+		if (hMap != nullptr) {
+			(void)::CloseHandle(hMap);
+		}
+		if (hFile != INVALID_HANDLE_VALUE) {
+			(void)::CloseHandle(hFile);
+		}
+#else
+		void* addr = MAP_FAILED;
+		struct stat st;
+
+		//ファイルオープン
+		const int fd = ::open(filePath, O_RDONLY);
+		if (fd < 0) {
+			//オープン失敗
+			goto END;
+		}
+
+		//ファイルサイズ取得(空ファイルはマップできない)
+		if ((::fstat(fd, &st) != 0) || (st.st_size <= 0) || (st.st_size > INT32_MAX)) {
+			goto END;
+		}
+		this->size_ = static_cast<std::int32_t>(st.st_size);
+
+		if (this->size_ < MAP_MINSIZE) {
+			//小さいファイルはマップせず、同じディスクリプタから読み込む
+			std::int32_t readByte = 0;
+			this->data_ = new std::uint8_t[this->size_];
+			while (readByte < this->size_) {
+				const ssize_t ret = ::read(fd, this->data_ + readByte, static_cast<size_t>(this->size_ - readByte));
+				if (ret <= 0) {
+					break;
+				}
+				readByte += static_cast<std::int32_t>(ret);
+			}
+			if (readByte != this->size_) {
+				this->close();
+				goto END;
+			}
+			rc = 0;
+			goto END;
+		}
+
+		//マップ(マップ後はファイルを閉じてよい)
+		addr = ::mmap(nullptr, static_cast<size_t>(this->size_), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			this->size_ = 0;
+			goto END;
+		}
+		//先頭から全体を読むので先読みを要求
+		(void)::posix_madvise(addr, static_cast<size_t>(this->size_), POSIX_MADV_WILLNEED);
+		this->data_ = static_cast<std::uint8_t*>(addr);
+		this->isMapped_ = true;
+
+		//正常終了
+		rc = 0;
 
 	END:
-		//画像データ読み込み用領域を解放
-		if (bodyData != nullptr) {
-			delete[] bodyData;
+		if (fd >= 0) {
+			(void)::close(fd);
+		}
+#endif
+
+		return rc;
+	}
+
+	//全体を読み込み
+	std::int32_t DWFileMap::read(const std::char8_t* const filePath)
+	{
+		std::int32_t rc = -1;
+
+		//ファイルオープン
+		std::ifstream ifs(filePath, std::ios::binary);
+		if (!ifs) {
+			//オープン失敗
+			goto END;
+		}
+
+		//データサイズ取得
+		ifs.seekg(0, std::ios::end);
+		this->size_ = static_cast<std::int32_t>(ifs.tellg());
+		ifs.seekg(0, std::ios::beg);
+		if (this->size_ <= 0) {
+			//サイズ異常
+			this->size_ = 0;
+			goto END;
 		}
-		if (blendData != nullptr) {
-			delete[] blendData;
+
+		//データ領域を確保し、ファイル読み込み
+		this->data_ = new std::uint8_t[this->size_];
+		this->isMapped_ = false;
+		if (!ifs.read(reinterpret_cast<std::char8_t*>(this->data_), this->size_)) {
+			//読み込み失敗(サイズ取得後に縮んだ場合など)
+			delete[] this->data_;
+			this->data_ = nullptr;
+			this->size_ = 0;
+			goto END;
 		}
+
+		//正常終了
+		rc = 0;
+
+	END:
 		return rc;
 	}
+
+
+	//----------------------------------------------------------------
+	// DWImageDecorderクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWImageDecorder::DWImageDecorder() :
+		decData_(nullptr), decDataSize_(0), width_(0), height_(0), dst_(nullptr), dstStride_(0), workData_(nullptr), packDst_(nullptr), packStride_(0),
+		isFileMap_(true), isPremultiplied_(false), pixelFormat_(DWPixelFormat::RGBA8888), progressFunc_(nullptr), progressUser_(nullptr), passNum_(1)
+	{
+	}
+
+	//デストラクタ
+	DWImageDecorder::~DWImageDecorder()
+	{
+		if (this->decData_ != nullptr) {
+			delete[] this->decData_;
+		}
+		if (this->workData_ != nullptr) {
+			delete[] this->workData_;
+		}
+	}
+
+	//RGBA8888画像へデコード
+	std::int32_t DWImageDecorder::decode_RGBA8888(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const bool isFlip)
+	{
+		return this->decodeFile(bodyFilePath, blendFilePath, format, nullptr, isFlip);
+	}
 	std::int32_t DWImageDecorder::decode_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, std::uint8_t* const blendData, const std::int32_t blendDataSize, const DWImageFormat format, const bool isFlip)
+	{
+		return this->decode(bodyData, bodyDataSize, blendData, blendDataSize, format, nullptr, isFlip);
+	}
+
+	//呼び出し元の出力先へRGBA8888画像をデコード(内部領域は確保しない)
+	std::int32_t DWImageDecorder::decode_RGBA8888(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const DWDecodeTarget& target, const bool isFlip)
+	{
+		return this->decodeFile(bodyFilePath, blendFilePath, format, &target, isFlip);
+	}
+	std::int32_t DWImageDecorder::decode_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, std::uint8_t* const blendData, const std::int32_t blendDataSize, const DWImageFormat format, const DWDecodeTarget& target, const bool isFlip)
+	{
+		return this->decode(bodyData, bodyDataSize, blendData, blendDataSize, format, &target, isFlip);
+	}
+
+	//デコードせずに幅高さ取得
+	std::int32_t DWImageDecorder::readWH(const std::char8_t* const bodyFilePath, const DWImageFormat format, std::int32_t* const width, std::int32_t* const height)
+	{
+		std::int32_t rc = -1;
+
+		//本体画像ファイルを開き、ヘッダから幅高さ取得
+		DWFileMap body;
+		if (body.open(bodyFilePath, this->isFileMap_) == 0) {
+			rc = this->readWH(body.getData(), body.getSize(), format, width, height);
+		}
+
+		return rc;
+	}
+	std::int32_t DWImageDecorder::readWH(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, const DWImageFormat format, std::int32_t* const width, std::int32_t* const height)
+	{
+		std::int32_t rc = -1;
+
+		if (format == BMP) {
+			DWImageBMP bmp_body;
+			if (bmp_body.create(bodyData, bodyDataSize) == 0) {
+				bmp_body.getWH(width, height);
+				rc = 0;
+			}
+		}
+		else if (format == PNG) {
+			DWImagePNG png_body;
+			if (png_body.create(bodyData, bodyDataSize) == 0) {
+				png_body.getWH(width, height);
+				rc = 0;
+			}
+		}
+		else {
+		}
+
+		return rc;
+	}
+
+	//デコードデータ取得(出力先指定でデコードした場合はnullptr)
+	std::uint8_t* DWImageDecorder::getDecodeData(std::int32_t* const decDataSize, std::int32_t* const width, std::int32_t* const height)
+	{
+		if (decDataSize != nullptr) { *decDataSize = this->decDataSize_; }
+		if (width != nullptr) { *width = this->width_; }
+		if (height != nullptr) { *height = this->height_; }
+		return this->decData_;
+	}
+
+	//画像ファイルのマップ有効/無効設定(既定は有効、無効時は全体を読み込む)
+	void DWImageDecorder::setFileMap(const bool isFileMap)
+	{
+		this->isFileMap_ = isFileMap;
+	}
+
+	//乗算済みアルファ出力の有効/無効設定(既定は無効、有効時はR,G,Bにアルファを乗算して出力)
+	void DWImageDecorder::setPremultiplied(const bool isPremultiplied)
+	{
+		this->isPremultiplied_ = isPremultiplied;
+	}
+
+	//出力画素フォーマット設定(既定はRGBA8888、それ以外はRGBA8888でデコードしてから1行ずつ変換)
+	void DWImageDecorder::setPixelFormat(const DWPixelFormat pixelFormat)
+	{
+		this->pixelFormat_ = pixelFormat;
+	}
+
+	//出力画素フォーマット取得
+	DWPixelFormat DWImageDecorder::getPixelFormat()
+	{
+		return this->pixelFormat_;
+	}
+
+	//乗算済みアルファで出力するか(乗算済みアルファ出力が有効で、出力画素フォーマットがR,G,Bとアルファを持つ)
+	bool DWImageDecorder::isPremultipliedOutput()
+	{
+		return (this->isPremultiplied_) && ((this->pixelFormat_ == DWPixelFormat::RGBA8888) || (this->pixelFormat_ == DWPixelFormat::RGBA4444));
+	}
+
+	//進捗コールバック関数設定(インターレースPNGは各パスの粗い画像を出力先へ書き込む毎に通知、ブレンド前なのでアルファは本体のもの、
+	//最後の通知はブレンドと出力画素フォーマットへの変換の完了後)
+	void DWImageDecorder::setProgressFunc(const ProgressFunc progressFunc, void* const user)
+	{
+		this->progressFunc_ = progressFunc;
+		this->progressUser_ = user;
+	}
+
+	//本体PNG画像のパス完了コールバック関数(最終パス以外を出力画素フォーマットへ変換して通知)
+	void DWImageDecorder::callbackPassPng(void* const user, const std::int32_t pass, const std::int32_t passNum)
+	{
+		DWImageDecorder* const decorder = static_cast<DWImageDecorder*>(user);
+		decorder->passNum_ = passNum;
+		if (pass < passNum) {
+			//RGBA8888以外は作業領域から出力画素フォーマットへ変換
+			if (decorder->workData_ != nullptr) {
+				decorder->packDest();
+			}
+			decorder->progressFunc_(decorder->progressUser_, pass, passNum);
+		}
+	}
+
+	//ファイル指定のデコード(targetがnullptrなら内部領域へ)
+	std::int32_t DWImageDecorder::decodeFile(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const DWDecodeTarget* const target, const bool isFlip)
+	{
+		std::int32_t rc = -1;
+
+		//画像ファイル(マップしたデータをそのままデコーダへ渡す、本関数の最後にクローズ)
+		DWFileMap body;
+		DWFileMap blend;
+
+		//本体画像ファイルを開く
+		if (body.open(bodyFilePath, this->isFileMap_) < 0) {
+			goto END;
+		}
+
+		//ブレンド画像ファイルの指定があれば、ブレンド画像を開く
+		if (blendFilePath != nullptr) {
+			if (blend.open(blendFilePath, this->isFileMap_) < 0) {
+				goto END;
+			}
+		}
+
+		//RGBA8888画像へデコード
+		rc = this->decode(body.getData(), body.getSize(), blend.getData(), blend.getSize(), format, target, isFlip);
+
+	END:
+		return rc;
+	}
+
+	//デコード(targetがnullptrなら内部領域へ)
+	std::int32_t DWImageDecorder::decode(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, std::uint8_t* const blendData, const std::int32_t blendDataSize, const DWImageFormat format, const DWDecodeTarget* const target, const bool isFlip)
 	{
 		std::int32_t rc = -1;
 		std::int32_t ret = -1;
@@ -492,21 +1195,33 @@ namespace dw {
 		//以前のデコードデータがあれば解放
 		if (this->decData_ != nullptr) {
 			delete[] this->decData_;
+			this->decData_ = nullptr;
 		}
+		this->decDataSize_ = 0;
+		this->dst_ = nullptr;
+		this->dstStride_ = 0;
+		this->packDst_ = nullptr;
+		this->packStride_ = 0;
+		this->passNum_ = 1;
+
+		//ブレンド画像ありの場合、本体はそのままデコードし、アルファを置き換える時に乗算する
+		//(アルファかR,G,Bのない出力画素フォーマットは乗算しない)
+		const bool isPremultiplied = this->isPremultipliedOutput();
+		const bool isBodyPremultiplied = (isPremultiplied) && (blendData == nullptr);
 
 		//画像フォーマット毎の処理
 		if (format == BMP) {
 			//BMP画像
 
 			//本体画像をデコード
-			ret = this->decodeBMP_RGBA8888(bodyData, bodyDataSize);
+			ret = this->decodeBMP_RGBA8888(bodyData, bodyDataSize, target, isFlip, isBodyPremultiplied);
 			if (ret < 0) {
 				goto END;
 			}
 
 			//ブレンド画像の指定があれば、ブレンド処理を実施
 			if (blendData != nullptr) {
-				ret = this->blendBMP_RGBA8888(blendData, blendDataSize);
+				ret = this->blendBMP_RGBA8888(blendData, blendDataSize, isPremultiplied);
 				if (ret < 0) {
 					goto END;
 				}
@@ -516,220 +1231,1060 @@ namespace dw {
 			//PNG画像
 
 			//本体画像をデコード
-			ret = this->decodePNG_RGBA8888(bodyData, bodyDataSize);
+			ret = this->decodePNG_RGBA8888(bodyData, bodyDataSize, target, isFlip, isBodyPremultiplied);
 			if (ret < 0) {
 				goto END;
 			}
 
 			//ブレンド画像の指定があれば、ブレンド処理を実施
 			if (blendData != nullptr) {
-				ret = this->blendPNG_RGBA8888(blendData, blendDataSize);
+				ret = this->blendPNG_RGBA8888(blendData, blendDataSize, isPremultiplied);
 				if (ret < 0) {
 					goto END;
 				}
 			}
 		}
-		else {
+		else {
+		}
+
+		//RGBA8888以外は作業領域から出力画素フォーマットへ変換
+		if (this->workData_ != nullptr) {
+			this->packDest();
+		}
+
+		//最終パスの完了を通知
+		if (this->progressFunc_ != nullptr) {
+			this->progressFunc_(this->progressUser_, this->passNum_, this->passNum_);
+		}
+
+		//正常終了
+		rc = 0;
+
+	END:
+		//作業領域を解放
+		if (this->workData_ != nullptr) {
+			delete[] this->workData_;
+			this->workData_ = nullptr;
+		}
+		return rc;
+	}
+
+	//書き込み先を準備(幅高さ取得後に呼ぶ、isFlipなら最終行から負のstrideで書き込む)
+	std::int32_t DWImageDecorder::prepareDest(const DWDecodeTarget* const target, const bool isFlip)
+	{
+		std::int32_t rc = -1;
+
+		//出力画素フォーマットの1ピクセルのバイト数
+		const std::int32_t bytePerPixel = DWPixelConv::getBytePerPixel(this->pixelFormat_);
+		std::uint8_t* outDst = nullptr;
+		std::int32_t outStride = 0;
+
+		//1行のバイト数(出力画素フォーマット、RGBA8888の作業領域)、ヘッダの幅高さで桁あふれしないよう64bitで計算
+		const std::int64_t rowByte = std::int64_t(this->width_) * bytePerPixel;
+		const std::int64_t workRowByte = std::int64_t(this->width_) * BYTE_PER_PIXEL_RGBA8888;
+		if ((this->width_ <= 0) || (this->height_ <= 0)) {
+			//幅高さ異常
+			goto END;
+		}
+		if ((rowByte > (INT32_MAX / this->height_)) || (workRowByte > (INT32_MAX / this->height_))) {
+			//画像全体のバイト数がint32に収まらない
+			goto END;
+		}
+
+		if (target == nullptr) {
+			//デコードデータ格納領域を確保
+			this->decDataSize_ = static_cast<std::int32_t>(rowByte * this->height_);
+			this->decData_ = new std::uint8_t[this->decDataSize_];
+			outDst = this->decData_;
+			outStride = static_cast<std::int32_t>(rowByte);
+		}
+		else {
+			//出力先の範囲チェック(書き込み位置から画像全体が収まること)
+			const std::int64_t x = target->coord_.x_;
+			const std::int64_t y = target->coord_.y_;
+			if ((target->image_ == nullptr) || (x < 0) || (y < 0) || (target->stride_ <= 0)) {
+				goto END;
+			}
+			if (((x * bytePerPixel) + rowByte) > target->stride_) {
+				//1行に収まらない
+				goto END;
+			}
+			if ((((y + this->height_ - 1) * target->stride_) + (x * bytePerPixel) + rowByte) > target->imageSize_) {
+				//出力先メモリを超える
+				goto END;
+			}
+			outDst = target->image_ + (y * target->stride_) + (x * bytePerPixel);
+			outStride = target->stride_;
+		}
+
+		if (this->pixelFormat_ == DWPixelFormat::RGBA8888) {
+			//出力先へ直接デコード
+			this->dst_ = outDst;
+			this->dstStride_ = outStride;
+		}
+		else {
+			//RGBA8888の作業領域へデコードし、最後に出力先へ変換
+			this->workData_ = new std::uint8_t[static_cast<std::size_t>(workRowByte * this->height_)];
+			this->dst_ = this->workData_;
+			this->dstStride_ = static_cast<std::int32_t>(workRowByte);
+			this->packDst_ = outDst;
+			this->packStride_ = outStride;
+		}
+
+		if (isFlip) {
+			//上下反転(各デコーダは1行目を最終行へ、以降は上へ向かって書き込む)
+			this->dst_ += (this->height_ - 1) * this->dstStride_;
+			this->dstStride_ = -this->dstStride_;
+		}
+
+		//正常終了
+		rc = 0;
+
+	END:
+		return rc;
+	}
+
+	//作業領域のRGBA8888画像を出力画素フォーマットへ変換
+	void DWImageDecorder::packDest()
+	{
+		//作業領域は上下反転済みなので上から順に変換
+		const DWPixelConv::RowFunc packRow = DWPixelConv::getPackRowFunc(this->pixelFormat_);
+		const std::int32_t workStride = this->width_ * BYTE_PER_PIXEL_RGBA8888;
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			packRow(this->workData_ + (h * workStride), this->packDst_ + (h * this->packStride_), this->width_);
+		}
+	}
+
+	//本体BMP画像をRGBA8888画像へデコード(isPremultipliedなら乗算済みアルファで出力)
+	std::int32_t DWImageDecorder::decodeBMP_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, const DWDecodeTarget* const target, const bool isFlip, const bool isPremultiplied)
+	{
+		std::int32_t rc = -1;
+		std::int32_t ret = -1;
+
+		//本体BMP画像オブジェクト生成
+		DWImageBMP bmp_body;
+		ret = bmp_body.create(bodyData, bodyDataSize);
+		if (ret < 0) {
+			//生成失敗
+			goto END;
+		}
+
+		//本体BMP画像幅高さを取得
+		bmp_body.getWH(&this->width_, &this->height_);
+
+		//書き込み先を準備
+		ret = this->prepareDest(target, isFlip);
+		if (ret < 0) {
+			goto END;
+		}
+
+		//本体BMP画像をRGBA8888画像へデコード
+		bmp_body.setPremultiplied(isPremultiplied);
+		ret = bmp_body.decode_RGBA8888(this->dst_, this->dstStride_);
+		if (ret < 0) {
+			//デコード失敗
+			goto END;
+		}
+
+		//正常終了
+		rc = 0;
+
+	END:
+		return rc;
+	}
+
+	//ブレンドBMP画像を本体デコード画像のアルファへデコード(isPremultipliedなら乗算済みアルファで出力)
+	std::int32_t DWImageDecorder::blendBMP_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize, const bool isPremultiplied)
+	{
+		std::int32_t rc = -1;
+		std::int32_t ret = -1;
+
+		//ブレンドBMP画像オブジェクト生成
+		DWImageBMP bmp_blend;
+		ret = bmp_blend.create(blendData, blendDataSize);
+		if (ret < 0) {
+			//生成失敗
+			goto END;
+		}
+
+		//ブレンドBMP画像幅高さを取得
+		std::int32_t width_blend, height_blend;
+		bmp_blend.getWH(&width_blend, &height_blend);
+		if ((this->width_ != width_blend) || (this->height_ != height_blend)) {
+			//幅高さが不一致
+			goto END;
+		}
+
+		//ブレンドBMP画像を本体デコード画像のアルファへ直接デコード(RGBA8888の中間画像は作らない)
+		bmp_blend.setPremultiplied(isPremultiplied);
+		ret = bmp_blend.decodeAlpha_RGBA8888(this->dst_, this->dstStride_);
+		if (ret < 0) {
+			//デコード失敗
+			goto END;
+		}
+
+		//正常終了
+		rc = 0;
+
+	END:
+		return rc;
+	}
+
+	//本体PNG画像をRGBA8888画像へデコード(isPremultipliedなら乗算済みアルファで出力)
+	std::int32_t DWImageDecorder::decodePNG_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, const DWDecodeTarget* const target, const bool isFlip, const bool isPremultiplied)
+	{
+		std::int32_t rc = -1;
+		std::int32_t ret = -1;
+
+		//本体PNG画像オブジェクト生成
+		DWImagePNG png_body;
+		ret = png_body.create(bodyData, bodyDataSize);
+		if (ret < 0) {
+			//生成失敗
+			goto END;
+		}
+
+		//本体PNG画像幅高さを取得
+		png_body.getWH(&this->width_, &this->height_);
+
+		//書き込み先を準備
+		ret = this->prepareDest(target, isFlip);
+		if (ret < 0) {
+			goto END;
+		}
+
+		//本体PNG画像をRGBA8888画像へデコード
+		png_body.setPremultiplied(isPremultiplied);
+		if (this->progressFunc_ != nullptr) {
+			//インターレース画像はパス毎に出力先へ書き込んで通知
+			png_body.setPassFunc(DWImageDecorder::callbackPassPng, this);
+		}
+		ret = png_body.decode_RGBA8888(this->dst_, this->dstStride_);
+		if (ret < 0) {
+			//デコード失敗
+			goto END;
+		}
+
+		//正常終了
+		rc = 0;
+
+	END:
+		return rc;
+	}
+
+	//ブレンドPNG画像を本体デコード画像のアルファへデコード(isPremultipliedなら乗算済みアルファで出力)
+	std::int32_t DWImageDecorder::blendPNG_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize, const bool isPremultiplied)
+	{
+		std::int32_t rc = -1;
+		std::int32_t ret = -1;
+
+		//ブレンドPNG画像オブジェクト生成
+		DWImagePNG png_blend;
+		ret = png_blend.create(blendData, blendDataSize);
+		if (ret < 0) {
+			//生成失敗
+			goto END;
+		}
+
+		//ブレンドPNG画像幅高さを取得
+		std::int32_t width_blend, height_blend;
+		png_blend.getWH(&width_blend, &height_blend);
+		if ((this->width_ != width_blend) || (this->height_ != height_blend)) {
+			//幅高さが不一致
+			goto END;
+		}
+
+		//ブレンドPNG画像を本体デコード画像のアルファへ直接デコード(RGBA8888の中間画像は作らない)
+		png_blend.setPremultiplied(isPremultiplied);
+		ret = png_blend.decodeAlpha_RGBA8888(this->dst_, this->dstStride_);
+		if (ret < 0) {
+			//デコード失敗
+			goto END;
+		}
+
+		//正常終了
+		rc = 0;
+
+	END:
+		return rc;
+	}
+
+
+
+
+
+	//----------------------------------------------------------------
+	// DWWorkerPoolクラス
+	//----------------------------------------------------------------
+
+	//インスタンス取得
+	DWWorkerPool* DWWorkerPool::get()
+	{
+		static DWWorkerPool pool;
+		return &pool;
+	}
+
+	//コンストラクタ
+	DWWorkerPool::DWWorkerPool() :
+		runMtx_(), mtx_(), cv_(), doneCv_(), threads_(), threadNum_(0), func_(nullptr), user_(nullptr), helperNum_(0), doneNum_(0), generation_(0), isEnd_(false)
+	{
+	}
+
+	//デストラクタ(常駐ワーカースレッドを終了)
+	DWWorkerPool::~DWWorkerPool()
+	{
+		this->mtx_.lock();
+		this->isEnd_ = true;
+		this->mtx_.unlock();
+		this->cv_.notify_all();
+		for (std::int32_t i = 0; i < this->threadNum_; i++) {
+			this->threads_[i].join();
+		}
+	}
+
+	//実行(呼び出しスレッドと常駐ワーカースレッドのworkerNum個でfuncを並列に実行し、全ワーカーの完了まで待つ、実際のワーカー数を返す)
+	std::int32_t DWWorkerPool::run(const WorkFunc func, void* const user, const std::int32_t workerNum)
+	{
+		if ((workerNum <= 1) || (g_isPoolWork) || (!this->runMtx_.try_lock())) {
+			//1ワーカー、ワーカー関数内からの呼び出し(ワーカー0はrunMtx_を取得済みのため再取得しない)、
+			//または他の呼び出し元が実行中なら、呼び出しスレッドのみで処理
+			func(user, 0);
+			return 1;
+		}
+
+		//常駐ワーカースレッドを起床
+		std::unique_lock<std::mutex> lock(this->mtx_);
+		const std::int32_t helperNum = this->createThreads(workerNum - 1);
+		this->func_ = func;
+		this->user_ = user;
+		this->helperNum_ = helperNum;
+		this->doneNum_ = 0;
+		this->generation_++;
+		lock.unlock();
+		this->cv_.notify_all();
+
+		//呼び出しスレッドはワーカー0として処理
+		g_isPoolWork = true;
+		func(user, 0);
+		g_isPoolWork = false;
+
+		//常駐ワーカースレッドの完了を待つ
+		lock.lock();
+		while (this->doneNum_ < this->helperNum_) {
+			this->doneCv_.wait(lock);
+		}
+		this->func_ = nullptr;
+		this->user_ = nullptr;
+		lock.unlock();
+		this->runMtx_.unlock();
+
+		return helperNum + 1;
+	}
+
+	//常駐ワーカースレッドをnum個まで作成(作成できた数を返す、mtx_取得済みで呼ぶ)
+	std::int32_t DWWorkerPool::createThreads(const std::int32_t num)
+	{
+		const std::int32_t maxNum = (num < THREAD_MAXNUM) ? num : THREAD_MAXNUM;
+		while (this->threadNum_ < maxNum) {
+			//std::threadは作成失敗を例外で通知するため、ここでのみ捕捉して作成済みの数で処理
+			try {
+				this->threads_[this->threadNum_] = std::thread(&DWWorkerPool::work, this, this->threadNum_ + 1, this->generation_);
+			}
+			catch (...) {
+				break;
+			}
+			this->threadNum_++;
+		}
+		return (this->threadNum_ < maxNum) ? this->threadNum_ : maxNum;
+	}
+
+	//常駐ワーカースレッド(seenは作成時の実行世代)
+	void DWWorkerPool::work(const std::int32_t workerNo, std::uint32_t seen)
+	{
+		//常駐ワーカースレッドはワーカー関数のみを実行
+		g_isPoolWork = true;
+
+		std::unique_lock<std::mutex> lock(this->mtx_);
+		for (;;) {
+			//終了要求か次の実行まで待つ
+			while ((!this->isEnd_) && (this->generation_ == seen)) {
+				this->cv_.wait(lock);
+			}
+			if (this->isEnd_) {
+				break;
+			}
+			seen = this->generation_;
+			if (workerNo > this->helperNum_) {
+				//今回の実行には参加しない
+				continue;
+			}
+
+			//ワーカー関数を実行(実行中はロックを解放)
+			const WorkFunc func = this->func_;
+			void* const user = this->user_;
+			lock.unlock();
+			func(user, workerNo);
+			lock.lock();
+
+			this->doneNum_++;
+			if (this->doneNum_ == this->helperNum_) {
+				this->doneCv_.notify_one();
+			}
+		}
+	}
+
+
+
+	//----------------------------------------------------------------
+	// DWImageBatchクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWImageBatch::DWImageBatch() :
+		decorders_(nullptr), results_(nullptr), jobNum_(0), workerNum_(0), totalUs_(0.0), jobs_(nullptr), nextJobNo_(0)
+	{
+	}
+
+	//デストラクタ
+	DWImageBatch::~DWImageBatch()
+	{
+		this->release();
+	}
+
+	//デコード(workerNumが0以下なら論理コア数、INLINE_JOB_MAXNUM以下のジョブは呼び出しスレッドのみ、全ジョブ成功で0)
+	std::int32_t DWImageBatch::decode(const Job* const jobs, const std::int32_t jobNum, const std::int32_t workerNum)
+	{
+		std::int32_t rc = 0;
+
+		//前回の結果を破棄し、ジョブ毎のデコーダと結果を確保
+		this->release();
+		if (jobNum <= 0) {
+			return 0;
+		}
+		this->decorders_ = new DWImageDecorder[jobNum];
+		this->results_ = new Result[jobNum];
+		this->jobNum_ = jobNum;
+		for (std::int32_t i = 0; i < jobNum; i++) {
+			this->decorders_[i].setPremultiplied(jobs[i].isPremultiplied_);
+			this->decorders_[i].setPixelFormat(jobs[i].pixelFormat_);
+			this->results_[i].rc_ = -1;
+			this->results_[i].workerNo_ = -1;
+			this->results_[i].decodeUs_ = 0.0;
+		}
+
+		//ワーカー数を決定(ジョブ数を超えない、少ないジョブは呼び出しスレッドのみ)
+		std::int32_t num = workerNum;
+		if (num <= 0) {
+			num = static_cast<std::int32_t>(std::thread::hardware_concurrency());
+			if (num <= 0) { num = 1; }
+		}
+		if (num > jobNum) { num = jobNum; }
+		if ((workerNum <= 0) && (jobNum <= INLINE_JOB_MAXNUM)) { num = 1; }
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		//ワーカーがジョブ番号を順に取り出す(呼び出しスレッドもワーカー0として処理)
+		this->jobs_ = jobs;
+		this->nextJobNo_.store(0);
+		this->workerNum_ = DWWorkerPool::get()->run(DWImageBatch::callbackWork, this, num);
+		this->jobs_ = nullptr;
+
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		this->totalUs_ = std::chrono::duration<std::float64_t, std::micro>(end - start).count();
+
+		//1つでも失敗していれば-1
+		for (std::int32_t i = 0; i < jobNum; i++) {
+			if (this->results_[i].rc_ < 0) {
+				rc = -1;
+			}
+		}
+
+		return rc;
+	}
+
+	//ジョブのデコーダ取得(デコードデータはgetDecodeDataで取得、次回decodeまで有効)
+	DWImageDecorder* DWImageBatch::getDecorder(const std::int32_t jobNo)
+	{
+		if ((jobNo < 0) || (jobNo >= this->jobNum_)) {
+			return nullptr;
+		}
+		return &this->decorders_[jobNo];
+	}
+
+	//ジョブ結果取得
+	const DWImageBatch::Result* DWImageBatch::getResult(const std::int32_t jobNo)
+	{
+		if ((jobNo < 0) || (jobNo >= this->jobNum_)) {
+			return nullptr;
+		}
+		return &this->results_[jobNo];
+	}
+
+	//前回のワーカー数取得
+	std::int32_t DWImageBatch::getWorkerNum()
+	{
+		return this->workerNum_;
+	}
+
+	//前回の全ジョブの経過時間取得[us]
+	std::float64_t DWImageBatch::getTotalUs()
+	{
+		return this->totalUs_;
+	}
+
+	//ワーカー関数(ジョブがなくなるまで取り出してデコード)
+	void DWImageBatch::callbackWork(void* const user, const std::int32_t workerNo)
+	{
+		DWImageBatch* const batch = static_cast<DWImageBatch*>(user);
+
+		//各ジョブは専用のデコーダと結果のみを書き換える(出力先指定時は領域が重ならない前提)
+		for (;;) {
+			const std::int32_t jobNo = batch->nextJobNo_.fetch_add(1);
+			if (jobNo >= batch->jobNum_) {
+				break;
+			}
+			const Job& job = batch->jobs_[jobNo];
+			Result* const result = &batch->results_[jobNo];
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			if (job.target_ != nullptr) {
+				result->rc_ = batch->decorders_[jobNo].decode_RGBA8888(job.bodyFilePath_, job.blendFilePath_, job.format_, *job.target_, job.isFlip_);
+			}
+			else {
+				result->rc_ = batch->decorders_[jobNo].decode_RGBA8888(job.bodyFilePath_, job.blendFilePath_, job.format_, job.isFlip_);
+			}
+			const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+			result->workerNo_ = workerNo;
+			result->decodeUs_ = std::chrono::duration<std::float64_t, std::micro>(end - start).count();
+		}
+	}
+
+	//ジョブ結果を破棄
+	void DWImageBatch::release()
+	{
+		if (this->decorders_ != nullptr) {
+			delete[] this->decorders_;
+			this->decorders_ = nullptr;
+		}
+		if (this->results_ != nullptr) {
+			delete[] this->results_;
+			this->results_ = nullptr;
+		}
+		this->jobNum_ = 0;
+	}
+
+
+
+	//----------------------------------------------------------------
+	// DWImageCacheクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWImageCache::Handle::Handle() :
+		cache_(nullptr), entryNo_(-1), bitmap_()
+	{
+	}
+	DWImageCache::Handle::Handle(const Handle& org) :
+		cache_(org.cache_), entryNo_(org.entryNo_), bitmap_(org.bitmap_)
+	{
+		if (this->cache_ != nullptr) {
+			this->cache_->retain(this->entryNo_);
+		}
+	}
+	DWImageCache::Handle::Handle(DWImageCache* const cache, const std::int32_t entryNo, const DWBitmap& bitmap) :
+		cache_(cache), entryNo_(entryNo), bitmap_(bitmap)
+	{
+	}
+
+	//デストラクタ
+	DWImageCache::Handle::~Handle()
+	{
+		this->release();
+	}
+
+	//代入演算子
+	DWImageCache::Handle& DWImageCache::Handle::operator=(const Handle& org)
+	{
+		if (this != &org) {
+			//先に参照数を加算(同じエントリの場合に破棄されないように)
+			if (org.cache_ != nullptr) {
+				org.cache_->retain(org.entryNo_);
+			}
+			this->release();
+			this->cache_ = org.cache_;
+			this->entryNo_ = org.entryNo_;
+			this->bitmap_ = org.bitmap_;
+		}
+		return *this;
+	}
+
+	//有効か
+	bool DWImageCache::Handle::isValid() const
+	{
+		return (this->cache_ != nullptr);
+	}
+
+	//画像取得(画像データは参照中のみ有効)
+	const DWBitmap& DWImageCache::Handle::getBitmap() const
+	{
+		return this->bitmap_;
+	}
+
+	//参照を解放
+	void DWImageCache::Handle::release()
+	{
+		if (this->cache_ != nullptr) {
+			this->cache_->releaseRef(this->entryNo_);
+		}
+		this->cache_ = nullptr;
+		this->entryNo_ = -1;
+		this->bitmap_ = DWBitmap();
+	}
+
+	//コンストラクタ
+	DWImageCache::DWImageCache(const std::int32_t byteBudget) :
+		mtx_(), buckets_(), entries_(), byteBudget_(byteBudget), byteUsed_(0), useCount_(0), hitNum_(0), missNum_(0), evictNum_(0)
+	{
+		for (std::int32_t i = 0; i < BUCKET_NUM; i++) {
+			this->buckets_[i] = -1;
+		}
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			this->entries_[i].isValid_ = false;
+			this->entries_[i].decorder_ = nullptr;
+		}
+	}
+
+	//デストラクタ
+	DWImageCache::~DWImageCache()
+	{
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			if (this->entries_[i].isValid_) {
+				this->removeEntry(i);
+			}
+		}
+	}
+
+	//取得
+	DWImageCache* DWImageCache::get()
+	{
+		static DWImageCache cache(IMAGECACHE_BYTEBUDGET);
+		return &cache;
+	}
+
+	//画像取得(未キャッシュならデコードして登録、失敗時は無効なハンドル)
+	DWImageCache::Handle DWImageCache::acquire(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const bool isFlip, const DWPixelFormat pixelFormat)
+	{
+		//キーを作成(更新時刻が変われば別の画像として扱う)
+		const std::string bodyPath(bodyFilePath);
+		const std::string blendPath((blendFilePath != nullptr) ? blendFilePath : "");
+		std::int64_t bodyMtime = 0;
+		std::int64_t blendMtime = 0;
+		if (DWFileMap::getModifiedTime(bodyFilePath, &bodyMtime) < 0) {
+			return Handle();
+		}
+		if ((blendFilePath != nullptr) && (DWFileMap::getModifiedTime(blendFilePath, &blendMtime) < 0)) {
+			return Handle();
+		}
+		const std::uint32_t hash = this->getHash(bodyPath, blendPath, bodyMtime, blendMtime, format, isFlip, pixelFormat);
+
+		{
+			std::lock_guard<std::mutex> lock(this->mtx_);
+			const std::int32_t entryNo = this->find(hash, bodyPath, blendPath, bodyMtime, blendMtime, format, isFlip, pixelFormat);
+			if (entryNo >= 0) {
+				//ヒット
+				this->hitNum_++;
+				return this->addRef(entryNo);
+			}
+
+			//ミス
+			this->missNum_++;
+		}
+
+		//デコード(他のスレッドの参照を止めないようにロック外で)
+		DWImageDecorder* decorder = new DWImageDecorder();
+		decorder->setPixelFormat(pixelFormat);
+		if (decorder->decode_RGBA8888(bodyFilePath, blendFilePath, format, isFlip) < 0) {
+			delete decorder;
+			return Handle();
+		}
+		std::int32_t byteSize = 0;
+		(void)decorder->getDecodeData(&byteSize, nullptr, nullptr);
+
+		std::lock_guard<std::mutex> lock(this->mtx_);
+
+		//デコード中に他のスレッドが登録していればそちらを使う
+		std::int32_t entryNo = this->find(hash, bodyPath, blendPath, bodyMtime, blendMtime, format, isFlip, pixelFormat);
+		if (entryNo >= 0) {
+			delete decorder;
+			return this->addRef(entryNo);
+		}
+
+		//上限バイト数を超える間、参照のない古いエントリから追い出す
+		while ((this->byteUsed_ + byteSize) > this->byteBudget_) {
+			if (this->evictOldest() < 0) {
+				//追い出せるエントリなし(参照中の画像は一時的に上限を超えて保持)
+				break;
+			}
+		}
+
+		//空きエントリを検索(なければ追い出す)
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			if (!this->entries_[i].isValid_) {
+				entryNo = i;
+				break;
+			}
+		}
+		if (entryNo < 0) {
+			entryNo = this->evictOldest();
 		}
-
-		if (isFlip) {
-			//デコード結果を上下反転する
+		if (entryNo < 0) {
+			//登録不可(全エントリが参照中)
+			delete decorder;
+			return Handle();
 		}
 
-		//正常終了
-		rc = 0;
-
-	END:
-		return rc;
+		//登録してバケットの先頭へ連結
+		const std::int32_t bucketNo = static_cast<std::int32_t>(hash >> 24) & (BUCKET_NUM - 1);
+		Entry* entry = &this->entries_[entryNo];
+		entry->isValid_ = true;
+		entry->bodyPath_ = bodyPath;
+		entry->blendPath_ = blendPath;
+		entry->bodyMtime_ = bodyMtime;
+		entry->blendMtime_ = blendMtime;
+		entry->format_ = format;
+		entry->isFlip_ = isFlip;
+		entry->pixelFormat_ = pixelFormat;
+		entry->hash_ = hash;
+		entry->decorder_ = decorder;
+		entry->byteSize_ = byteSize;
+		entry->refCount_ = 0;
+		entry->next_ = this->buckets_[bucketNo];
+		this->buckets_[bucketNo] = entryNo;
+		this->byteUsed_ += byteSize;
+
+		return this->addRef(entryNo);
 	}
 
-	//デコードデータ取得
-	std::uint8_t* DWImageDecorder::getDecodeData(std::int32_t* const decDataSize, std::int32_t* const width, std::int32_t* const height)
+	//上限バイト数設定(超えた分は参照のないエントリから追い出す)
+	void DWImageCache::setByteBudget(const std::int32_t byteBudget)
 	{
-		if (decDataSize != nullptr) { *decDataSize = this->decDataSize_; }
-		if (width != nullptr) { *width = this->width_; }
-		if (height != nullptr) { *height = this->height_; }
-		return this->decData_;
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		this->byteBudget_ = byteBudget;
+
+		//上限を超えた分を追い出す
+		while (this->byteUsed_ > this->byteBudget_) {
+			if (this->evictOldest() < 0) {
+				break;
+			}
+		}
 	}
 
-	//本体BMP画像をRGBA8888画像へデコード
-	std::int32_t DWImageDecorder::decodeBMP_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize)
+	//参照のない全エントリ破棄
+	void DWImageCache::clear()
 	{
-		std::int32_t rc = -1;
-		std::int32_t ret = -1;
-
-		//本体BMP画像オブジェクト生成
-		DWImageBMP bmp_body;
-		ret = bmp_body.create(bodyData, bodyDataSize);
-		if (ret < 0) {
-			//生成失敗
-			goto END;
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			if ((this->entries_[i].isValid_) && (this->entries_[i].refCount_ == 0)) {
+				this->removeEntry(i);
+			}
 		}
+	}
 
-		//本体BMP画像幅高さを取得
-		bmp_body.getWH(&this->width_, &this->height_);
-
-		//デコードデータ格納領域を確保
-		this->decDataSize_ = this->width_ * this->height_ * BYTE_PER_PIXEL_RGBA8888;
-		this->decData_ = new std::uint8_t[this->decDataSize_];
+	//統計取得
+	std::int32_t DWImageCache::getHitNum()
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		return this->hitNum_;
+	}
+	std::int32_t DWImageCache::getMissNum()
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		return this->missNum_;
+	}
+	std::int32_t DWImageCache::getEvictNum()
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		return this->evictNum_;
+	}
+	std::int32_t DWImageCache::getByteUsed()
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		return this->byteUsed_;
+	}
+	std::int32_t DWImageCache::getEntryNum()
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		std::int32_t entryNum = 0;
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			if (this->entries_[i].isValid_) {
+				entryNum++;
+			}
+		}
+		return entryNum;
+	}
+	std::float64_t DWImageCache::getHitRate()
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		const std::int32_t total = this->hitNum_ + this->missNum_;
+		return (total > 0) ? (static_cast<std::float64_t>(this->hitNum_) / total) : 0.0;
+	}
 
-		//本体BMP画像をRGBA8888画像へデコード
-		ret = bmp_body.decode_RGBA8888(&this->decData_);
-		if (ret < 0) {
-			//デコード失敗
-			goto END;
+	//キーのハッシュ値を算出
+	std::uint32_t DWImageCache::getHash(const std::string& bodyPath, const std::string& blendPath, const std::int64_t bodyMtime, const std::int64_t blendMtime, const DWImageFormat format, const bool isFlip, const DWPixelFormat pixelFormat)
+	{
+		//FNV-1a
+		std::uint32_t hash = 2166136261U;
+		for (const std::char8_t c : bodyPath) {
+			hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619U;
 		}
+		hash = (hash ^ 0xFFU) * 16777619U;
+		for (const std::char8_t c : blendPath) {
+			hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619U;
+		}
+		hash = (hash * 31U) + static_cast<std::uint32_t>(bodyMtime ^ (bodyMtime >> 32));
+		hash = (hash * 31U) + static_cast<std::uint32_t>(blendMtime ^ (blendMtime >> 32));
+		hash = (hash * 31U) + static_cast<std::uint32_t>(format);
+		hash = (hash * 31U) + static_cast<std::uint32_t>(isFlip);
+		hash = (hash * 31U) + static_cast<std::uint32_t>(pixelFormat);
+		return hash * 0x9E3779B1U;
+	}
 
-		//正常終了
-		rc = 0;
+	//エントリ検索(ロック中に呼ぶ、なければ-1)
+	std::int32_t DWImageCache::find(const std::uint32_t hash, const std::string& bodyPath, const std::string& blendPath, const std::int64_t bodyMtime, const std::int64_t blendMtime, const DWImageFormat format, const bool isFlip, const DWPixelFormat pixelFormat)
+	{
+		const std::int32_t bucketNo = static_cast<std::int32_t>(hash >> 24) & (BUCKET_NUM - 1);
+		for (std::int32_t e = this->buckets_[bucketNo]; e >= 0; e = this->entries_[e].next_) {
+			const Entry& entry = this->entries_[e];
+			if ((entry.hash_ == hash) && (entry.bodyMtime_ == bodyMtime) && (entry.blendMtime_ == blendMtime) &&
+				(entry.format_ == format) && (entry.isFlip_ == isFlip) && (entry.pixelFormat_ == pixelFormat) && (entry.bodyPath_ == bodyPath) && (entry.blendPath_ == blendPath)) {
+				return e;
+			}
+		}
+		return -1;
+	}
 
-	END:
-		return rc;
+	//エントリの画像を参照開始(ロック中に呼ぶ)
+	DWImageCache::Handle DWImageCache::addRef(const std::int32_t entryNo)
+	{
+		Entry* entry = &this->entries_[entryNo];
+		entry->refCount_++;
+		entry->lastUse_ = ++this->useCount_;
+
+		DWBitmap bitmap;
+		bitmap.image_ = entry->decorder_->getDecodeData(&bitmap.imageSize_, &bitmap.width_, &bitmap.height_);
+		bitmap.format_ = entry->pixelFormat_;
+		bitmap.bytePerPixel_ = DWPixelConv::getBytePerPixel(entry->pixelFormat_);
+		bitmap.isPremultiplied_ = false;
+		return Handle(this, entryNo, bitmap);
 	}
 
-	//ブレンドBMP画像をRGBA8888画像へデコードし、本体デコード画像へブレンド
-	std::int32_t DWImageDecorder::blendBMP_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize)
+	//参照数を加算(ハンドルのコピー時)
+	void DWImageCache::retain(const std::int32_t entryNo)
 	{
-		std::int32_t rc = -1;
-		std::int32_t ret = -1;
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		this->entries_[entryNo].refCount_++;
+	}
 
-		std::uint8_t* decData_blend = nullptr;
+	//参照数を減算(ハンドルの解放時)
+	void DWImageCache::releaseRef(const std::int32_t entryNo)
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_);
+		this->entries_[entryNo].refCount_--;
 
-		//ブレンドBMP画像オブジェクト生成
-		DWImageBMP bmp_blend;
-		ret = bmp_blend.create(blendData, blendDataSize);
-		if (ret < 0) {
-			//生成失敗
-			goto END;
+		//参照中のため上限を超えて保持していた分を追い出す
+		while (this->byteUsed_ > this->byteBudget_) {
+			if (this->evictOldest() < 0) {
+				break;
+			}
 		}
+	}
 
-		//ブレンドBMP画像幅高さを取得
-		std::int32_t width_blend, height_blend;
-		bmp_blend.getWH(&width_blend, &height_blend);
-		if ((this->width_ != width_blend) || (this->height_ != height_blend)) {
-			//幅高さが不一致
-			goto END;
+	//参照のない最も古いエントリを追い出す(ロック中に呼ぶ、追い出したエントリ番号、なければ-1)
+	std::int32_t DWImageCache::evictOldest()
+	{
+		//参照のないエントリで最終参照が最も古いものを検索
+		std::int32_t entryNo = -1;
+		std::uint32_t oldestAge = 0;
+		for (std::int32_t i = 0; i < ENTRY_MAXNUM; i++) {
+			const Entry& entry = this->entries_[i];
+			const std::uint32_t age = this->useCount_ - entry.lastUse_;
+			if ((entry.isValid_) && (entry.refCount_ == 0) && ((entryNo < 0) || (age > oldestAge))) {
+				entryNo = i;
+				oldestAge = age;
+			}
 		}
-
-		//デコードデータ格納領域を確保
-		decData_blend = new std::uint8_t[this->decDataSize_];
-
-		//ブレンドBMP画像をRGBA8888画像へデコード
-		ret = bmp_blend.decode_RGBA8888(&decData_blend);
-		if (ret < 0) {
-			//デコード失敗
-			goto END;
+		if (entryNo < 0) {
+			return -1;
 		}
 
-		//RGBA8888画像のブレンド処理
-		this->blend_RGBA8888(decData_blend);
-
-		//正常終了
-		rc = 0;
+		this->removeEntry(entryNo);
+		this->evictNum_++;
 
-	END:
-		if (decData_blend != nullptr) {
-			delete[] decData_blend;
-		}
-		return rc;
+		return entryNo;
 	}
 
-	//本体PNG画像をRGBA8888画像へデコード
-	std::int32_t DWImageDecorder::decodePNG_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize)
+	//エントリを破棄(ロック中に呼ぶ)
+	void DWImageCache::removeEntry(const std::int32_t entryNo)
 	{
-		std::int32_t rc = -1;
-		std::int32_t ret = -1;
-
-		//本体PNG画像オブジェクト生成
-		DWImagePNG png_body;
-		ret = png_body.create(bodyData, bodyDataSize);
-		if (ret < 0) {
-			//生成失敗
-			goto END;
+		//バケットから切り離す
+		Entry* entry = &this->entries_[entryNo];
+		std::int32_t* link = &this->buckets_[static_cast<std::int32_t>(entry->hash_ >> 24) & (BUCKET_NUM - 1)];
+		while (*link != entryNo) {
+			link = &this->entries_[*link].next_;
 		}
+		*link = entry->next_;
+
+		//破棄
+		this->byteUsed_ -= entry->byteSize_;
+		delete entry->decorder_;
+		entry->decorder_ = nullptr;
+		entry->bodyPath_.clear();
+		entry->blendPath_.clear();
+		entry->isValid_ = false;
+	}
 
-		//本体PNG画像幅高さを取得
-		png_body.getWH(&this->width_, &this->height_);
 
-		//デコードデータ格納領域を確保
-		this->decDataSize_ = this->width_ * this->height_ * BYTE_PER_PIXEL_RGBA8888;
-		this->decData_ = new std::uint8_t[this->decDataSize_];
 
-		//本体PNG画像をRGBA8888画像へデコード
-		ret = png_body.decode_RGBA8888(&this->decData_);
-		if (ret < 0) {
-			//デコード失敗
-			goto END;
-		}
+	//----------------------------------------------------------------
+	// DWImageAtlasクラス
+	//----------------------------------------------------------------
 
-		//正常終了
-		rc = 0;
+	//コンストラクタ
+	DWImageAtlas::DWImageAtlas() :
+		page_(nullptr), pixelFormat_(DWPixelFormat::RGBA8888), pageSize_(0), width_(0), height_(0), regions_()
+	{
+	}
 
-	END:
-		return rc;
+	//デストラクタ
+	DWImageAtlas::~DWImageAtlas()
+	{
+		if (this->page_ != nullptr) {
+			delete[] this->page_;
+		}
 	}
 
-	//ブレンドPNG画像をRGBA8888画像へデコードし、本体デコード画像へブレンド
-	std::int32_t DWImageDecorder::blendPNG_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize)
+	//作成(文字毎の画像をデコードし、1枚のページへ配置)
+	std::int32_t DWImageAtlas::create(const std::char8_t* const chars, const std::int32_t charNum, const DWPixelFormat pixelFormat)
 	{
 		std::int32_t rc = -1;
 		std::int32_t ret = -1;
+		const std::int32_t bytePerPixel = DWPixelConv::getBytePerPixel(pixelFormat);
+		std::int32_t x = 0;
+		std::int32_t y = 0;
+		std::int32_t shelfHeight = 0;
+		std::int32_t pageWidth = 0;
+
+		//文字毎のデコード用バッチとジョブ(本関数の最後に解放)
+		DWImageBatch batch;
+		DWImageBatch::Job* jobs = new DWImageBatch::Job[charNum];
+		std::string* filePaths = new std::string[charNum];
+
+		//以前のページがあれば解放
+		if (this->page_ != nullptr) {
+			delete[] this->page_;
+			this->page_ = nullptr;
+		}
+		for (std::int32_t i = 0; i < REGION_MAXNUM; i++) {
+			this->regions_[i].isValid_ = false;
+		}
 
-		std::uint8_t* decData_blend = nullptr;
-
-		//ブレンドPNG画像オブジェクト生成
-		DWImagePNG png_blend;
-		ret = png_blend.create(blendData, blendDataSize);
+		//文字毎の画像をデコーダの内部領域へデコード(各ファイルの読み込みは1回、幅高さはデコード結果から取得)
+		for (std::int32_t i = 0; i < charNum; i++) {
+			filePaths[i] = DWFunc::getFilePath_TimeNumImage(chars[i], jobs[i].format_);
+			jobs[i].bodyFilePath_ = filePaths[i].c_str();
+			jobs[i].blendFilePath_ = nullptr;
+			jobs[i].target_ = nullptr;
+			//ページは乗算済みアルファ(描画時の合成は乗算1回)
+			jobs[i].pixelFormat_ = pixelFormat;
+			jobs[i].isPremultiplied_ = true;
+			jobs[i].isFlip_ = false;
+		}
+		ret = batch.decode(jobs, charNum);
 		if (ret < 0) {
-			//生成失敗
+			//デコード失敗
 			goto END;
 		}
 
-		//ブレンドPNG画像幅高さを取得
-		std::int32_t width_blend, height_blend;
-		png_blend.getWH(&width_blend, &height_blend);
-		if ((this->width_ != width_blend) || (this->height_ != height_blend)) {
-			//幅高さが不一致
-			goto END;
-		}
+		//文字毎の幅高さからページ内の配置を決定(横に並べ、最大幅を超えたら次の段へ)
+		for (std::int32_t i = 0; i < charNum; i++) {
+			std::int32_t width, height;
+			(void)batch.getDecorder(i)->getDecodeData(nullptr, &width, &height);
 
-		//デコードデータ格納領域を確保
-		decData_blend = new std::uint8_t[this->decDataSize_];
+			if ((x > 0) && ((x + width) > PAGE_MAXWIDTH)) {
+				//次の段へ
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
 
-		//ブレンドPNG画像をRGBA8888画像へデコード
-		ret = png_blend.decode_RGBA8888(&decData_blend);
-		if (ret < 0) {
-			//デコード失敗
-			goto END;
+			//領域はページの作成後に有効にする
+			Region* region = &this->regions_[static_cast<std::uint8_t>(chars[i])];
+			region->area_.xmin_ = x;
+			region->area_.ymin_ = y;
+			region->area_.xmax_ = x + width;
+			region->area_.ymax_ = y + height;
+
+			x += width;
+			if (x > pageWidth) { pageWidth = x; }
+			if (height > shelfHeight) { shelfHeight = height; }
 		}
 
-		//RGBA8888画像のブレンド処理
-		this->blend_RGBA8888(decData_blend);
+		//ページ領域を確保
+		this->pixelFormat_ = pixelFormat;
+		this->width_ = pageWidth;
+		this->height_ = y + shelfHeight;
+		this->pageSize_ = this->width_ * this->height_ * bytePerPixel;
+		this->page_ = new std::uint8_t[this->pageSize_];
+		memset(this->page_, 0, this->pageSize_);
+
+		//文字毎のデコード結果をページ内の領域へコピーし、文字領域を有効にする
+		for (std::int32_t i = 0; i < charNum; i++) {
+			Region* region = &this->regions_[static_cast<std::uint8_t>(chars[i])];
+			const std::uint8_t* const src = batch.getDecorder(i)->getDecodeData(nullptr, nullptr, nullptr);
+			const std::int32_t rowByte = (region->area_.xmax_ - region->area_.xmin_) * bytePerPixel;
+			for (std::int32_t h = region->area_.ymin_; h < region->area_.ymax_; h++) {
+				memcpy(this->page_ + (h * this->width_ * bytePerPixel) + (region->area_.xmin_ * bytePerPixel), src + ((h - region->area_.ymin_) * rowByte), rowByte);
+			}
+			region->isValid_ = true;
+		}
 
 		//正常終了
 		rc = 0;
 
 	END:
-		if (decData_blend != nullptr) {
-			delete[] decData_blend;
-		}
+		delete[] jobs;
+		delete[] filePaths;
 		return rc;
 	}
 
-
-	//RGBA8888画像のブレンド処理
-	void DWImageDecorder::blend_RGBA8888(std::uint8_t* const decData_blend)
+	//ページ取得
+	void DWImageAtlas::getPage(DWBitmap* const bitmap)
 	{
-		std::int32_t offset = 0;
-		for (std::int32_t h = 0; h < this->height_; h++) {
-			for (std::int32_t w = 0; w < this->width_; w++) {
-				this->decData_[offset + 3] = decData_blend[offset];
-				offset += BYTE_PER_PIXEL_RGBA8888;
-			}
+		if (bitmap != nullptr) {
+			bitmap->width_ = this->width_;
+			bitmap->height_ = this->height_;
+			bitmap->bytePerPixel_ = DWPixelConv::getBytePerPixel(this->pixelFormat_);
+			bitmap->imageSize_ = this->pageSize_;
+			bitmap->image_ = this->page_;
+			bitmap->format_ = this->pixelFormat_;
+			bitmap->isPremultiplied_ = (this->pixelFormat_ == DWPixelFormat::RGBA8888) || (this->pixelFormat_ == DWPixelFormat::RGBA4444);
 		}
 	}
 
+	//文字領域取得
+	std::int32_t DWImageAtlas::getRegion(const std::char8_t c, DWArea* const area)
+	{
+		std::int32_t rc = -1;
+
+		const Region& region = this->regions_[static_cast<std::uint8_t>(c)];
+		if (region.isValid_) {
+			if (area != nullptr) { *area = region.area_; }
+			rc = 0;
+		}
 
+		return rc;
+	}
 
 
 	//----------------------------------------------------------------
@@ -739,7 +2294,7 @@ namespace dw {
 	//コンストラクタ
 	DWImageBMP::DWImageBMP() :
 		bmp_(nullptr), bmpSize_(0), format_(BitmapFormat::INVALID), fileSize_(0), imageOffset_(0),
-		width_(0), height_(0), bitCount_(0), compression_(0), imageSize_(0), palleteNum_(0), palleteByte_(0), palleteOffset_(0)
+		width_(0), height_(0), bitCount_(0), compression_(0), imageSize_(0), palleteNum_(0), palleteByte_(0), palleteOffset_(0), masks_(), isPremultiplied_(false)
 	{
 	}
 
@@ -760,6 +2315,11 @@ namespace dw {
 		//------------------------------------------
 		//ファイルヘッダ読み込み
 
+		if (this->bmpSize_ < (BIH_HEADERSIZE_OFS + 4)) {
+			//ヘッダ不足
+			return -1;
+		}
+
 		//ファイルタイプを取得
 		std::uint8_t fileType[2];
 		ByteReader::read1ByteLe(this->bmp_, BFH_FILETYPE_OFS, &fileType[0]);
@@ -782,12 +2342,12 @@ namespace dw {
 			ByteReader::read4ByteLe(this->bmp_, BIH_HEADERSIZE_OFS, &infoHeaderSize);
 
 			//情報ヘッダサイズに応じてフォーマットを選択
-			if (infoHeaderSize == BIH_HEADERSIZE) {
-				//Windowsフォーマット
+			if ((infoHeaderSize >= std::uint32_t(BIH_HEADERSIZE)) && (infoHeaderSize <= std::uint32_t(BIH_HEADERSIZE_V5))) {
+				//Windowsフォーマット(V2～V5の拡張ヘッダを含む)
 				this->format_ = BitmapFormat::WIN;
 
 				//Bitmap情報ヘッダ(Windows)読み込み
-				rc = this->readInfoHeader_WINDOWS();
+				rc = this->readInfoHeader_WINDOWS(std::int32_t(infoHeaderSize));
 			}
 			else if (infoHeaderSize == BCH_HEADERSIZE) {
 				//OS/2フォーマット
@@ -818,18 +2378,50 @@ namespace dw {
 
 	//RGBA8888画像へデコード
 	std::int32_t DWImageBMP::decode_RGBA8888(std::uint8_t** const decData)
+	{
+		return this->decode_RGBA8888(*decData, this->width_ * BYTE_PER_PIXEL_RGBA8888);
+	}
+
+	//RGBA8888画像へデコード(decDataは画像の1行目、strideは出力先の1行のバイト数、負なら下から上へ並べる)
+	std::int32_t DWImageBMP::decode_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
 	{
 		std::int32_t rc = 0;
 
+		//ランレングス圧縮(RLE8は8bit、RLE4は4bitのみ)
+		if ((this->compression_ == COMPRESSION_BI_RLE8) || (this->compression_ == COMPRESSION_BI_RLE4)) {
+			const std::int32_t bitCount = (this->compression_ == COMPRESSION_BI_RLE8) ? 8 : 4;
+			if (this->bitCount_ == bitCount) {
+				rc = this->decodeRLEBitmap_RGBA8888(decData, stride);
+			}
+			else {
+				rc = -1;
+			}
+			return rc;
+		}
+
+		//ビットフィールド(16bit,32bitのみ)
+		if ((this->compression_ == COMPRESSION_BI_BITFIELDS) || (this->compression_ == COMPRESSION_BI_ALPHABITFIELDS)) {
+			if ((this->bitCount_ == 16) || (this->bitCount_ == 32)) {
+				rc = this->decodeBitFieldsBitmap_RGBA8888(decData, stride);
+			}
+			else {
+				rc = -1;
+			}
+			return rc;
+		}
+
 		switch (this->bitCount_) {
 		case 1:		//1bit
 		case 4:		//4bit
 		case 8:		//8bit
-			rc = this->decodePalleteBitmap_RGBA8888(decData);
+			rc = this->decodePalleteBitmap_RGBA8888(decData, stride);
+			break;
+		case 16:	//16bit(無圧縮は555)
+			rc = this->decodeBitFieldsBitmap_RGBA8888(decData, stride);
 			break;
 		case 24:	//24bit
 		case 32:	//32bit
-			rc = this->decodeTrueColorBitmap_RGBA8888(decData);
+			rc = this->decodeTrueColorBitmap_RGBA8888(decData, stride);
 			break;
 		default:
 			rc = -1;
@@ -839,9 +2431,59 @@ namespace dw {
 		return rc;
 	}
 
+	//RGBA8888画像のアルファへデコード(Rをマスク値として書き込み、R,G,Bは変更しない、引数はdecode_RGBA8888と同じ)
+	std::int32_t DWImageBMP::decodeAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		std::int32_t rc = -1;
+
+		if (this->compression_ == COMPRESSION_BI_RGB) {
+			switch (this->bitCount_) {
+			case 1:		//1bit
+			case 4:		//4bit
+			case 8:		//8bit
+				return this->decodePalleteBitmapAlpha_RGBA8888(decData, stride);
+			case 24:	//24bit
+			case 32:	//32bit
+				return this->decodeTrueColorBitmapAlpha_RGBA8888(decData, stride);
+			default:
+				break;
+			}
+		}
+
+		//それ以外(ランレングス圧縮、ビットフィールド)は一時領域へデコードしてからアルファへ書き込む
+		//(マスク値が変わらないよう、一時領域へは乗算せずにデコード)
+		const std::int32_t rowByte = this->width_ * BYTE_PER_PIXEL_RGBA8888;
+		std::uint8_t* tmp = new std::uint8_t[rowByte * this->height_];
+		const bool isPremultiplied = this->isPremultiplied_;
+		this->isPremultiplied_ = false;
+		if (this->decode_RGBA8888(tmp, rowByte) == 0) {
+			const DWPixelConv::RowFunc writeAlpha = (isPremultiplied) ?
+				DWPixelConv::getPremulAlphaRowFunc(DWPixelConv::Format::RGBA8888) : DWPixelConv::getAlphaRowFunc(DWPixelConv::Format::RGBA8888);
+			for (std::int32_t h = 0; h < this->height_; h++) {
+				writeAlpha(tmp + (h * rowByte), decData + (h * stride), this->width_);
+			}
+			rc = 0;
+		}
+		this->isPremultiplied_ = isPremultiplied;
+		delete[] tmp;
+
+		return rc;
+	}
+
+	//乗算済みアルファ出力の有効/無効設定(既定は無効、アルファへのデコードではマスク値をR,G,Bへ乗算)
+	void DWImageBMP::setPremultiplied(const bool isPremultiplied)
+	{
+		this->isPremultiplied_ = isPremultiplied;
+	}
+
 	//Bitmap情報ヘッダ(Windows)読み込み
-	std::int32_t DWImageBMP::readInfoHeader_WINDOWS()
+	std::int32_t DWImageBMP::readInfoHeader_WINDOWS(const std::int32_t infoHeaderSize)
 	{
+		if (this->bmpSize_ < (BIH_HEADERSIZE_OFS + BIH_HEADERSIZE)) {
+			//情報ヘッダ不足
+			return -1;
+		}
+
 		//画像の幅と高さを取得
 		std::uint32_t width = 0;
 		std::uint32_t height = 0;
@@ -868,6 +2510,31 @@ namespace dw {
 			palleteNum = 1 << bitCount;
 		}
 
+		//ビットフィールドのマスクを取得(40バイトのヘッダは直後に続く、アルファはV3以降かALPHABITFIELDSのみ)
+		std::uint32_t masks[4] = { 0 };
+		std::int32_t maskOffset = BIH_HEADERSIZE_OFS + infoHeaderSize;
+		if ((compression == COMPRESSION_BI_BITFIELDS) || (compression == COMPRESSION_BI_ALPHABITFIELDS)) {
+			const bool isAlpha = (compression == COMPRESSION_BI_ALPHABITFIELDS) || (infoHeaderSize >= BIH_HEADERSIZE_V3);
+			const std::int32_t maskNum = (isAlpha) ? 4 : 3;
+			if ((BIH_MASK_OFS + (maskNum * 4)) > this->bmpSize_) {
+				//マスクがデータ外
+				return -1;
+			}
+			for (std::int32_t c = 0; c < maskNum; c++) {
+				ByteReader::read4ByteLe(this->bmp_, BIH_MASK_OFS + (c * 4), &masks[c]);
+			}
+			if (infoHeaderSize == BIH_HEADERSIZE) {
+				//パレットはマスクの後
+				maskOffset += maskNum * 4;
+			}
+		}
+		else if (bitCount == 16) {
+			//無圧縮の16bitは555
+			masks[0] = 0x7C00;
+			masks[1] = 0x03E0;
+			masks[2] = 0x001F;
+		}
+
 		//メンバ変数に設定
 		this->width_ = int32_t(width);
 		this->height_ = int32_t(height);
@@ -876,14 +2543,23 @@ namespace dw {
 		this->imageSize_ = int32_t(imageSize);
 		this->palleteNum_ = int32_t(palleteNum);
 		this->palleteByte_ = int32_t(4);
-		this->palleteOffset_ = uint32_t(BIH_PALLETE_OFS);
+		this->palleteOffset_ = maskOffset;
+		for (std::int32_t c = 0; c < 4; c++) {
+			this->masks_[c] = masks[c];
+		}
 
-		return 0;
+		//画像サイズの妥当性チェック
+		return this->checkImageSize();
 	}
 
 	//Bitmap情報ヘッダ(OS/2)読み込み
 	std::int32_t DWImageBMP::readInfoHeader_OS2()
 	{
+		if (this->bmpSize_ < (BCH_HEADERSIZE_OFS + BCH_HEADERSIZE)) {
+			//情報ヘッダ不足
+			return -1;
+		}
+
 		//画像の幅と高さを取得
 		std::uint16_t width = 0;
 		std::uint16_t height = 0;
@@ -911,6 +2587,30 @@ namespace dw {
 		this->palleteByte_ = int32_t(3);
 		this->palleteOffset_ = int32_t(BCH_PALLETE_OFS);
 
+		//画像サイズの妥当性チェック
+		return this->checkImageSize();
+	}
+
+	//画像サイズの妥当性チェック(幅高さが正で、1行と画像全体のバイト数がint32に収まること)
+	std::int32_t DWImageBMP::checkImageSize()
+	{
+		if ((this->width_ <= 0) || (this->height_ <= 0)) {
+			//幅高さ異常(高さが負の上から下へ並ぶ画像は未対応)
+			return -1;
+		}
+		if ((this->imageOffset_ < 0) || (this->imageOffset_ > this->bmpSize_)) {
+			//画像データがデータ外
+			return -1;
+		}
+
+		//入力の1行(4バイト境界)と出力(RGBA8888)の1行のバイト数、画像全体でint32に収まらなければ異常
+		const std::int64_t srcRowByte = (((std::int64_t(this->width_) * this->bitCount_) + 31) / 32) * 4;
+		const std::int64_t dstRowByte = std::int64_t(this->width_) * BYTE_PER_PIXEL_RGBA8888;
+		if ((srcRowByte > (INT32_MAX / this->height_)) || (dstRowByte > (INT32_MAX / this->height_))) {
+			//画像サイズ異常
+			return -1;
+		}
+
 		return 0;
 	}
 
@@ -955,112 +2655,280 @@ namespace dw {
 				}
 			}
 		}
-		else {
-			//パレット数異常
-			rc = -1;
+		else {
+			//パレット数異常
+			rc = -1;
+		}
+
+		return rc;
+	}
+
+	//パレットをRGBA8888の変換テーブルへ展開(パレットインデックス→4バイト、パレット外は黒)
+	std::int32_t DWImageBMP::makePalleteColors(std::uint32_t* const colors)
+	{
+		//パレットデータを取得
+		PalColor pallete[PALLETE_MAXNUM] = { 0 };
+		if ((this->palleteNum_ < 0) || ((std::int64_t(this->palleteOffset_) + (std::int64_t(this->palleteNum_) * this->palleteByte_)) > this->bmpSize_)) {
+			//パレットがデータ外
+			return -1;
+		}
+		if (this->getPalleteData(pallete, PALLETE_MAXNUM) != 0) {
+			//パレット取得失敗
+			return -1;
+		}
+
+		for (std::int32_t p = 0; p < PALLETE_MAXNUM; p++) {
+			const std::uint8_t rgba[BYTE_PER_PIXEL_RGBA8888] = { pallete[p].r_, pallete[p].g_, pallete[p].b_, 255 };
+			memcpy(&colors[p], rgba, BYTE_PER_PIXEL_RGBA8888);
+		}
+
+		return 0;
+	}
+
+	//パレットBMP画像からRGBA8888画像へデコード
+	std::int32_t DWImageBMP::decodePalleteBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		//パレットをRGBA値の変換テーブルへ展開(アルファは255なので乗算済みアルファでも同じ)
+		std::uint32_t colors[PALLETE_MAXNUM];
+		if (this->makePalleteColors(colors) != 0) {
+			//パレット取得失敗
+			return -1;
+		}
+
+		//1行は4バイト境界(最終行のパディングは省略されていてもよい)
+		const std::int32_t srcRowByte = (((this->width_ * this->bitCount_) + 31) / 32) * 4;
+		const std::int32_t srcDataByte = ((this->width_ * this->bitCount_) + 7) / 8;
+		if ((std::int64_t(this->imageOffset_) + (std::int64_t(srcRowByte) * (this->height_ - 1)) + srcDataByte) > this->bmpSize_) {
+			//画像データ不足
+			return -1;
+		}
+
+		//ビット深度毎の行変換関数を選択(1バイトを8/2/1ピクセルへ展開し、1ピクセル4バイトで書き込む)
+		const DWPixelConv::IndexRowFunc convertRow = DWPixelConv::getIndexRowFunc(this->bitCount_);
+		if (convertRow == nullptr) {
+			//未対応のビット数
+			return -1;
+		}
+
+		//出力データへデコード後の画像データを設定
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			//一行ずつ処理(BMPは下の行から格納)
+			convertRow(this->bmp_ + this->imageOffset_ + (h * srcRowByte), decData + ((this->height_ - h - 1) * stride), this->width_, colors);
+		}
+
+		return 0;
+	}
+
+	//トゥルーカラーBitmap画像からRGBA8888画像へデコード
+	std::int32_t DWImageBMP::decodeTrueColorBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		//パディングバイト数を取得
+		std::int32_t paddingByte = getPaddingByte();
+
+		//画像データはBGR値(32bitの場合はBGRA値)、行変換関数を選択(乗算済みアルファは変換と同時に乗算)
+		const DWPixelConv::Format srcFormat = (this->bitCount_ == 32) ? DWPixelConv::Format::BGRA8888 : DWPixelConv::Format::BGR888;
+		const DWPixelConv::RowFunc convertRow = (this->isPremultiplied_) ? DWPixelConv::getPremulRowFunc(srcFormat) : DWPixelConv::getRowFunc(srcFormat);
+		const std::int32_t srcRowByte = this->width_ * DWPixelConv::getBytePerPixel(srcFormat);
+		if ((paddingByte < 0) || ((std::int64_t(this->imageOffset_) + ((std::int64_t(srcRowByte) + paddingByte) * (this->height_ - 1)) + srcRowByte) > this->bmpSize_)) {
+			//画像データ不足
+			return -1;
+		}
+
+		//出力データへデコード後の画像データを設定
+		std::int32_t readOffset = this->imageOffset_;
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			//一行ずつ処理(BMPは下の行から格納)
+			convertRow(this->bmp_ + readOffset, decData + ((this->height_ - h - 1) * stride), this->width_);
+
+			//読み込み位置を更新
+			readOffset += srcRowByte + paddingByte;
 		}
 
-		return rc;
+		return 0;
 	}
 
-	//パレットBMP画像からRGBA8888画像へデコード
-	std::int32_t DWImageBMP::decodePalleteBitmap_RGBA8888(std::uint8_t** const decData)
+	//ビットフィールド(16bit,32bit)BMP画像からRGBA8888画像へデコード
+	std::int32_t DWImageBMP::decodeBitFieldsBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
 	{
-		std::int32_t rc = 0;
+		//マスクからチャンネル毎のシフト量と拡張係数を求める(画像全体で1回)
+		DWPixelConv::BitFields fields;
+		if (DWPixelConv::makeBitFields(this->bitCount_, this->masks_, &fields) != 0) {
+			//マスク異常
+			return -1;
+		}
+		const DWPixelConv::BitFieldsRowFunc convertRow = DWPixelConv::getBitFieldsRowFunc(this->bitCount_);
+		//アルファありで乗算済みアルファの場合は、変換した行をキャッシュに残るうちにその場で乗算
+		const DWPixelConv::RowFunc premulRow = ((this->isPremultiplied_) && (fields.isAlpha_)) ? DWPixelConv::getPremulRowFunc(DWPixelConv::Format::RGBA8888) : nullptr;
+
+		//1行は4バイト境界
+		const std::int32_t srcRowByte = (((this->width_ * this->bitCount_) + 31) / 32) * 4;
+		if ((std::int64_t(this->imageOffset_) + (std::int64_t(srcRowByte) * this->height_)) > this->bmpSize_) {
+			//画像データ不足
+			return -1;
+		}
 
-		//パレットデータを取得
-		PalColor pallete[PALLETE_MAXNUM] = { 0 };
-		rc = this->getPalleteData(pallete, PALLETE_MAXNUM);
-		if (rc == 0) {
+		//出力データへデコード後の画像データを設定
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			//一行ずつ処理(BMPは下の行から格納)
+			std::uint8_t* const wp = decData + ((this->height_ - h - 1) * stride);
+			convertRow(this->bmp_ + this->imageOffset_ + (h * srcRowByte), wp, this->width_, fields);
+			if (premulRow != nullptr) {
+				premulRow(wp, wp, this->width_);
+			}
+		}
 
-			//パディングバイト数を取得
-			std::int32_t paddingByte = this->getPaddingByte();
+		return 0;
+	}
 
-			//出力データへデコード後の画像データを設定
-			std::int32_t readOffset = this->imageOffset_;
-			for (std::int32_t h = 0; h < this->height_; h++) {
-				//一行ずつ処理
-				std::int32_t writeOffset = (this->height_ - h - 1) * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-
-				//ビット数に応じたビットオフセットとビットマスク
-				std::int32_t bitOfs = 8 - this->bitCount_;
-				std::uint8_t bitMask = (0x01 << this->bitCount_) - 1;
-
-				for (std::int32_t w = 0; w < this->width_; w++) {
-					//画像データはパレットインデックス
-					std::uint8_t index = 0;
-					ByteReader::read1ByteLe(this->bmp_, int16_t(readOffset), &index);
-					std::int32_t palleteOffset = (index >> bitOfs) & bitMask;
-
-					//出力データへRGBA値を設定
-					*((*decData) + writeOffset + 0) = pallete[palleteOffset].r_;		//赤
-					*((*decData) + writeOffset + 1) = pallete[palleteOffset].g_;		//緑
-					*((*decData) + writeOffset + 2) = pallete[palleteOffset].b_;		//青
-					*((*decData) + writeOffset + 3) = 255;
-
-					//ビットオフセットを更新
-					bitOfs -= this->bitCount_;
-					if (bitOfs < 0) {
-						//次の読み込み位置に更新
-						bitOfs = 8 - this->bitCount_;
-						readOffset++;
+	//ランレングス圧縮(RLE8,RLE4)BMP画像からRGBA8888画像へデコード
+	std::int32_t DWImageBMP::decodeRLEBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		//パレットをRGBA値の変換テーブルへ展開
+		std::uint32_t colors[PALLETE_MAXNUM];
+		if (this->makePalleteColors(colors) != 0) {
+			//パレット取得失敗
+			return -1;
+		}
+
+		//デルタ、行末で飛ばした画素は透明にするため、先に全体をクリア(乗算済みアルファでも0)
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			memset(decData + (h * stride), 0, this->width_ * BYTE_PER_PIXEL_RGBA8888);
+		}
+
+		//画像データは(個数,値)の組の並び、個数0はエスケープ(0:行末、1:終端、2:デルタ、3以上:非圧縮の画素列)
+		const bool isRLE4 = (this->compression_ == COMPRESSION_BI_RLE4);
+		const std::uint8_t* rp = this->bmp_ + this->imageOffset_;
+		const std::uint8_t* const rpEnd = this->bmp_ + this->bmpSize_;
+		std::int32_t x = 0;
+		std::int32_t y = 0;		//下の行から0,1,...
+		while (((rp + 2) <= rpEnd) && (y < this->height_)) {
+			const std::int32_t count = rp[0];
+			const std::uint8_t value = rp[1];
+			rp += 2;
+
+			if (count > 0) {
+				//連続する画素(RLE4は上位4bitと下位4bitの色を交互に)、画像幅を超える分は捨てる
+				const std::int32_t num = (count < (this->width_ - x)) ? count : (this->width_ - x);
+				std::uint8_t* wp = decData + ((this->height_ - y - 1) * stride) + (x * BYTE_PER_PIXEL_RGBA8888);
+				const std::uint32_t color0 = (isRLE4) ? colors[value >> 4] : colors[value];
+				const std::uint32_t color1 = (isRLE4) ? colors[value & 0x0F] : colors[value];
+				if (color0 == color1) {
+					//1色で塗りつぶし
+					for (std::int32_t i = 0; i < num; i++) {
+						memcpy(wp + (i * BYTE_PER_PIXEL_RGBA8888), &color0, BYTE_PER_PIXEL_RGBA8888);
+					}
+				}
+				else {
+					//2色の組で塗りつぶし
+					const std::uint32_t pair[2] = { color0, color1 };
+					std::int32_t i = 0;
+					for (; (i + 2) <= num; i += 2) {
+						memcpy(wp + (i * BYTE_PER_PIXEL_RGBA8888), pair, sizeof(pair));
+					}
+					if (i < num) {
+						memcpy(wp + (i * BYTE_PER_PIXEL_RGBA8888), &color0, BYTE_PER_PIXEL_RGBA8888);
 					}
-					//書き込み位置を更新
-					writeOffset += BYTE_PER_PIXEL_RGBA8888;
 				}
-				readOffset += paddingByte;
+				x += num;
+			}
+			else if (value == 0) {
+				//行末
+				x = 0;
+				y++;
+			}
+			else if (value == 1) {
+				//終端
+				break;
+			}
+			else if (value == 2) {
+				//デルタ(右へdx、上へdy移動)
+				if ((rp + 2) > rpEnd) {
+					break;
+				}
+				x += rp[0];
+				y += rp[1];
+				rp += 2;
+				if (x > this->width_) {
+					x = this->width_;
+				}
+			}
+			else {
+				//非圧縮の画素列(2バイト境界までパディング)
+				const std::int32_t byteNum = (isRLE4) ? ((value + 1) / 2) : value;
+				if ((rp + byteNum) > rpEnd) {
+					break;
+				}
+				const std::int32_t num = (value < (this->width_ - x)) ? value : (this->width_ - x);
+				std::uint8_t* wp = decData + ((this->height_ - y - 1) * stride) + (x * BYTE_PER_PIXEL_RGBA8888);
+				for (std::int32_t i = 0; i < num; i++) {
+					const std::uint8_t index = (isRLE4) ? ((rp[i >> 1] >> (((i & 1) == 0) ? 4 : 0)) & 0x0F) : rp[i];
+					memcpy(wp + (i * BYTE_PER_PIXEL_RGBA8888), &colors[index], BYTE_PER_PIXEL_RGBA8888);
+				}
+				x += num;
+				rp += byteNum + (byteNum & 1);
 			}
-		}
-		else {
-			//パレット取得失敗
-			rc = -1;
 		}
 
-		return rc;
+		//データが途中で終わっている場合も、デコードできた部分を有効とする
+		return 0;
 	}
 
-	//トゥルーカラーBitmap画像からRGBA8888画像へデコード
-	std::int32_t DWImageBMP::decodeTrueColorBitmap_RGBA8888(std::uint8_t** const decData)
+	//パレットBMP画像からRGBA8888画像のアルファへデコード
+	std::int32_t DWImageBMP::decodePalleteBitmapAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
 	{
-		//パディングバイト数を取得
-		std::int32_t paddingByte = getPaddingByte();
+		//パレットをRGBA値の変換テーブルへ展開(Rをマスク値とする、パレット外は0)
+		std::uint32_t colors[PALLETE_MAXNUM];
+		if (this->makePalleteColors(colors) != 0) {
+			//パレット取得失敗
+			return -1;
+		}
 
-		//出力データへデコード後の画像データを設定
-		std::int32_t readOffset = this->imageOffset_;
+		//1行は4バイト境界(最終行のパディングは省略されていてもよい)
+		const std::int32_t srcRowByte = (((this->width_ * this->bitCount_) + 31) / 32) * 4;
+		const std::int32_t srcDataByte = ((this->width_ * this->bitCount_) + 7) / 8;
+		if ((std::int64_t(this->imageOffset_) + (std::int64_t(srcRowByte) * (this->height_ - 1)) + srcDataByte) > this->bmpSize_) {
+			//画像データ不足
+			return -1;
+		}
+
+		//ビット深度毎の行変換関数で1行分のRGBAへ展開し、Rをアルファへ書き込む(乗算済みアルファは書き込みと同時に乗算)
+		const DWPixelConv::IndexRowFunc convertRow = DWPixelConv::getIndexRowFunc(this->bitCount_);
+		if (convertRow == nullptr) {
+			//未対応のビット数
+			return -1;
+		}
+		const DWPixelConv::RowFunc writeAlpha = (this->isPremultiplied_) ? DWPixelConv::getPremulAlphaRowFunc(DWPixelConv::Format::RGBA8888) : DWPixelConv::getAlphaRowFunc(DWPixelConv::Format::RGBA8888);
+
+		//出力データのアルファへマスク値を設定
+		std::uint8_t* const row = new std::uint8_t[this->width_ * BYTE_PER_PIXEL_RGBA8888];
 		for (std::int32_t h = 0; h < this->height_; h++) {
-			//一行ずつ処理
-			std::int32_t writeIndex = (this->height_ - h - 1) * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-
-			for (std::int32_t w = 0; w < this->width_; w++) {
-				//画像データはBGR値
-				std::uint8_t b = 255;
-				ByteReader::read1ByteLe(this->bmp_, int32_t(readOffset) + 0, &b);
-				std::uint8_t g = 255;
-				ByteReader::read1ByteLe(this->bmp_, int32_t(readOffset) + 1, &g);
-				std::uint8_t r = 255;
-				ByteReader::read1ByteLe(this->bmp_, int32_t(readOffset) + 2, &r);
-				std::uint8_t a = 255;
-				if (this->bitCount_ == 32) {
-					//ビット数が32bitの場合、A値を読み込み
-					ByteReader::read1ByteLe(this->bmp_, int32_t(readOffset) + 3, &a);
-
-					//読み込み位置を更新
-					readOffset++;
-				}
+			//一行ずつ処理(BMPは下の行から格納)
+			convertRow(this->bmp_ + this->imageOffset_ + (h * srcRowByte), row, this->width_, colors);
+			writeAlpha(row, decData + ((this->height_ - h - 1) * stride), this->width_);
+		}
+		delete[] row;
 
-				//出力データへRGBA値を設定
-				*((*decData) + writeIndex + 0) = r;		//赤
-				*((*decData) + writeIndex + 1) = g;		//緑
-				*((*decData) + writeIndex + 2) = b;		//青
-				*((*decData) + writeIndex + 3) = a;		//アルファ
+		return 0;
+	}
 
-														//読み込み位置を更新
-				readOffset += 3;
+	//トゥルーカラーBitmap画像からRGBA8888画像のアルファへデコード
+	std::int32_t DWImageBMP::decodeTrueColorBitmapAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		//画像データはBGR値(32bitの場合はBGRA値)、Rをアルファへ書き込む関数を選択(乗算済みアルファは書き込みと同時に乗算)
+		const DWPixelConv::Format srcFormat = (this->bitCount_ == 32) ? DWPixelConv::Format::BGRA8888 : DWPixelConv::Format::BGR888;
+		const DWPixelConv::RowFunc writeAlpha = (this->isPremultiplied_) ? DWPixelConv::getPremulAlphaRowFunc(srcFormat) : DWPixelConv::getAlphaRowFunc(srcFormat);
+
+		//1行は4バイト境界
+		const std::int32_t srcRowByte = (((this->width_ * this->bitCount_) + 31) / 32) * 4;
+		if ((std::int64_t(this->imageOffset_) + (std::int64_t(srcRowByte) * (this->height_ - 1)) + (this->width_ * DWPixelConv::getBytePerPixel(srcFormat))) > this->bmpSize_) {
+			//画像データ不足
+			return -1;
+		}
 
-				//書き込み位置を更新
-				writeIndex += BYTE_PER_PIXEL_RGBA8888;
-			}
-			readOffset += paddingByte;
+		//出力データのアルファへマスク値を設定
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			//一行ずつ処理(BMPは下の行から格納)
+			writeAlpha(this->bmp_ + this->imageOffset_ + (h * srcRowByte), decData + ((this->height_ - h - 1) * stride), this->width_);
 		}
 
 		return 0;
@@ -1074,8 +2942,9 @@ namespace dw {
 
 	//コンストラクタ
 	DWImagePNG::DWImagePNG() :
-		png_(nullptr), pngSize_(0), width_(0), height_(0), rowByte_(0), bitDepth_(0), colorType_(0),
-		pngStr_(nullptr), pngInfo_(nullptr)
+		png_(nullptr), pngSize_(0), readOffset_(0), width_(0), height_(0), bitDepth_(0), colorType_(0),
+		pngStr_(nullptr), pngInfo_(nullptr), work_(nullptr), alphaWork_(nullptr), isPremultiplied_(false), passFunc_(nullptr), passUser_(nullptr),
+		reduceRow_(nullptr), expandRow_(nullptr), indexRow_(nullptr), channelNum_(0), isTransColor_(false), colors_()
 	{
 	}
 
@@ -1088,14 +2957,19 @@ namespace dw {
 		if (this->pngStr_ != nullptr) {
 			png_destroy_read_struct(&this->pngStr_, nullptr, nullptr);
 		}
+		this->releaseWork();
 	}
 
-	//PNG読み込みコールバック関数
+	//PNG読み込みコールバック関数(データ不足はpng_errorでsetjmpへ戻る)
 	void DWImagePNG::callbackReadPng(png_structp pngStr, png_bytep data, png_size_t length)
 	{
-		png_bytepp buf = (png_bytepp)png_get_io_ptr(pngStr);
-		memcpy_s(data, length, *buf, length);
-		*buf += length;
+		DWImagePNG* const png = static_cast<DWImagePNG*>(png_get_io_ptr(pngStr));
+		if (length > static_cast<png_size_t>(png->pngSize_ - png->readOffset_)) {
+			//データ不足
+			png_error(pngStr, "PNG data is truncated");
+		}
+		(void)memcpy_s(data, length, png->png_ + png->readOffset_, length);
+		png->readOffset_ += static_cast<std::int32_t>(length);
 	}
 
 	//作成
@@ -1106,11 +2980,10 @@ namespace dw {
 		//メンバへ保持
 		this->png_ = png;
 		this->pngSize_ = pngSize;
+		this->readOffset_ = 0;
 
 		//PNGシグネチャのチェック
-		png_byte sig[PNG_BYTES_TO_CHECK];
-		(void)memcpy_s(sig, PNG_BYTES_TO_CHECK, this->png_, PNG_BYTES_TO_CHECK);
-		if (png_sig_cmp(sig, 0, PNG_BYTES_TO_CHECK) == 0) {
+		if ((this->pngSize_ >= PNG_BYTES_TO_CHECK) && (png_sig_cmp(this->png_, 0, PNG_BYTES_TO_CHECK) == 0)) {
 			//PNG画像
 
 			//PNG構造ポインタ作成
@@ -1118,13 +2991,22 @@ namespace dw {
 
 			//PNG情報ポインタ作成
 			this->pngInfo_ = png_create_info_struct(this->pngStr_);
+			if ((this->pngStr_ == nullptr) || (this->pngInfo_ == nullptr)) {
+				//作成失敗
+				return -1;
+			}
+
+			//IHDRまでのデータ不足、破損はlibpngのエラーでここへ戻る
+			if (setjmp(png_jmpbuf(this->pngStr_)) != 0) {
+				return -1;
+			}
 
 			//シグネチャ読み込み済み
 			png_set_sig_bytes(this->pngStr_, PNG_BYTES_TO_CHECK);
-			this->png_ += PNG_BYTES_TO_CHECK;
+			this->readOffset_ = PNG_BYTES_TO_CHECK;
 
 			//PNG読み込みコールバック関数を登録
-			png_set_read_fn(this->pngStr_, &this->png_, callbackReadPng);
+			png_set_read_fn(this->pngStr_, this, callbackReadPng);
 
 			//PNG読み込み
 			png_read_info(this->pngStr_, this->pngInfo_);
@@ -1132,9 +3014,13 @@ namespace dw {
 			//IHDRチャンクの各種情報取得
 			this->width_ = png_get_image_width(this->pngStr_, this->pngInfo_);
 			this->height_ = png_get_image_height(this->pngStr_, this->pngInfo_);
-			this->rowByte_ = int32_t(png_get_rowbytes(this->pngStr_, this->pngInfo_));
 			this->bitDepth_ = png_get_bit_depth(this->pngStr_, this->pngInfo_);
 			this->colorType_ = png_get_color_type(this->pngStr_, this->pngInfo_);
+
+			//画像全体の作業領域(16bitのRGBAは1ピクセル8バイト)がint32に収まらなければ異常(幅高さはIHDRで1以上)
+			if ((std::int64_t(this->width_) * 8) > (INT32_MAX / this->height_)) {
+				rc = -1;
+			}
 		}
 		else {
 			//PNG画像でない
@@ -1154,211 +3040,482 @@ namespace dw {
 	//RGBA8888画像へデコード
 	std::int32_t DWImagePNG::decode_RGBA8888(std::uint8_t** const decData)
 	{
-		std::int32_t rc = 0;
+		return this->decode_RGBA8888(*decData, this->width_ * BYTE_PER_PIXEL_RGBA8888);
+	}
+
+	//RGBA8888画像へデコード(decDataは画像の1行目、strideは出力先の1行のバイト数、負なら下から上へ並べる)
+	std::int32_t DWImagePNG::decode_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		std::int32_t rc = -1;
 
 		if (this->pngStr_ != nullptr) {
-			//デコード後の画像データを格納するメモリを確保(本関数の最後に解放)
-			png_size_t pngSize = this->height_ * sizeof(png_bytep) + this->height_ * this->rowByte_;
-			png_byte* tmp = new png_byte[pngSize];
-			png_bytepp png = (png_bytepp)tmp;
+			//データ不足、破損はlibpngのエラーでsetjmpへ戻る(-1)
+			if (setjmp(png_jmpbuf(this->pngStr_)) == 0) {
+				//libpngの変換で出力先へ直接デコード
+				rc = this->decodeRows_RGBA8888(decData, stride);
+			}
 
-			//png_read_imageには各行へのポインタを渡すため、2次元配列化
-			png_bytep wp = (png_bytep)&png[this->height_];
-			for (std::int32_t h = 0; h < this->height_; h++) {
-				png[h] = wp;
-				wp += this->rowByte_;
+			//作業領域を解放(エラーで中断した場合も)
+			this->releaseWork();
+		}
+
+		return rc;
+	}
+
+	//RGBA8888画像のアルファへデコード(R(グレー画像はグレー)をマスク値として書き込み、R,G,Bは変更しない、引数はdecode_RGBA8888と同じ)
+	std::int32_t DWImagePNG::decodeAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		std::int32_t rc = -1;
+
+		if (this->pngStr_ != nullptr) {
+			//データ不足、破損はlibpngのエラーでsetjmpへ戻る(-1)
+			if (setjmp(png_jmpbuf(this->pngStr_)) == 0) {
+				rc = this->decodeAlphaRows_RGBA8888(decData, stride);
 			}
 
-			//PNGイメージ読み込み
-			png_read_image(this->pngStr_, png);
+			//作業領域を解放(エラーで中断した場合も)
+			this->releaseWork();
+		}
 
-			switch (this->colorType_) {
-			case PNG_COLOR_TYPE_GRAY:		//0:グレー
-				rc = this->decodeGrayScalePng_RGBA8888(decData, png);
-				break;
-			case PNG_COLOR_TYPE_RGB:		//2:トゥルーカラー
-				rc = this->decodeTrueColorPng_RGBA8888(decData, png, false);
-				break;
-			case PNG_COLOR_TYPE_PALETTE:	//3:パレット
-				rc = this->decodePalletePng_RGBA8888(decData, png);
-				break;
-			case PNG_COLOR_TYPE_GRAY_ALPHA:	//4:グレー+アルファ
-				break;
-			case PNG_COLOR_TYPE_RGB_ALPHA:	//6:トゥルーカラー+アルファ
-				rc = this->decodeTrueColorPng_RGBA8888(decData, png, true);
-				break;
-			default:
-				break;
-			};
+		return rc;
+	}
 
-			//デコード後の画像データを格納するメモリを解放
-			delete[] png;
+	//出力先の各行のアルファへ直接デコード(インターレースはRGBA8888画像の作業領域を経由)
+	std::int32_t DWImagePNG::decodeAlphaRows_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		std::int32_t rc = -1;
+		DWPixelConv::Format srcFormat = DWPixelConv::Format::RGBA8888;
+		DWPixelConv::RowFunc writeAlpha = nullptr;
+
+		if (png_get_interlace_type(this->pngStr_, this->pngInfo_) != PNG_INTERLACE_NONE) {
+			//インターレースは行単位で読めないため、作業領域へデコードしてからアルファへ書き込む
+			//(マスク値が変わらないよう、作業領域へは乗算せずにデコード)
+			const std::int32_t rowByte = this->width_ * BYTE_PER_PIXEL_RGBA8888;
+			this->alphaWork_ = new std::uint8_t[rowByte * this->height_];
+			const bool isPremultiplied = this->isPremultiplied_;
+			this->isPremultiplied_ = false;
+			if (this->decodeRows_RGBA8888(this->alphaWork_, rowByte) == 0) {
+				writeAlpha = (isPremultiplied) ? DWPixelConv::getPremulAlphaRowFunc(srcFormat) : DWPixelConv::getAlphaRowFunc(srcFormat);
+				for (std::int32_t h = 0; h < this->height_; h++) {
+					writeAlpha(this->alphaWork_ + (h * rowByte), decData + (h * stride), this->width_);
+				}
+				rc = 0;
+			}
+			this->isPremultiplied_ = isPremultiplied;
+			goto END;
 		}
-		else {
-			//PNG構造未作成
-			rc = -1;
+
+		//パレットはRGBへ、1,2,4bitグレーは8bitへ展開、16bitは8bitへ四捨五入(アルファ、透過色は使用しない)
+		if (this->colorType_ == PNG_COLOR_TYPE_PALETTE) {
+			png_set_palette_to_rgb(this->pngStr_);
 		}
+		if ((this->colorType_ == PNG_COLOR_TYPE_GRAY) && (this->bitDepth_ < 8)) {
+			png_set_expand_gray_1_2_4_to_8(this->pngStr_);
+		}
+		if (this->bitDepth_ == 16) {
+			png_set_scale_16(this->pngStr_);
+		}
+		png_read_update_info(this->pngStr_, this->pngInfo_);
+
+		//変換後のチャンネル数に応じて、先頭の色をアルファへ書き込む関数を選択(乗算済みアルファは書き込みと同時に乗算)
+		switch (png_get_channels(this->pngStr_, this->pngInfo_)) {
+		case 1:
+			srcFormat = DWPixelConv::Format::GRAY8;
+			break;
+		case 2:
+			srcFormat = DWPixelConv::Format::GRAYALPHA88;
+			break;
+		case 3:
+			srcFormat = DWPixelConv::Format::RGB888;
+			break;
+		case 4:
+			srcFormat = DWPixelConv::Format::RGBA8888;
+			break;
+		default:
+			goto END;
+		}
+		writeAlpha = (this->isPremultiplied_) ? DWPixelConv::getPremulAlphaRowFunc(srcFormat) : DWPixelConv::getAlphaRowFunc(srcFormat);
+
+		//1行ずつ読み込み、出力先のアルファへ書き込む
+		this->work_ = new png_byte[png_get_rowbytes(this->pngStr_, this->pngInfo_)];
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			png_read_row(this->pngStr_, this->work_, nullptr);
+			writeAlpha(this->work_, decData + (h * stride), this->width_);
+		}
+
+		//正常終了
+		rc = 0;
 
+	END:
 		return rc;
 	}
 
-	//グレーPNG画像からRGBA8888画像へデコード
-	std::int32_t DWImagePNG::decodeGrayScalePng_RGBA8888(std::uint8_t** const decData, const png_bytepp png)
+	//乗算済みアルファ出力の有効/無効設定(既定は無効、アルファへのデコードではマスク値をR,G,Bへ乗算)
+	void DWImagePNG::setPremultiplied(const bool isPremultiplied)
 	{
-		std::int32_t rc = 0;
+		this->isPremultiplied_ = isPremultiplied;
+	}
 
-		if (this->bitDepth_ <= 8) {
-			//ビット深度が1bit,2bit,4bit,8bitの場合
+	//パス完了コールバック関数設定(インターレース画像は各パスの完了毎に、粗い画像を出力先へ書き込んでから通知)
+	void DWImagePNG::setPassFunc(const PassFunc passFunc, void* const user)
+	{
+		this->passFunc_ = passFunc;
+		this->passUser_ = user;
+	}
 
-			//ビット深度で表現できる最大値
-			png_byte bitMaxValue = (0x01 << this->bitDepth_) - 1;
+	//出力先の各行へ直接デコード(インターレースなしは画像全体の中間バッファなし)
+	std::int32_t DWImagePNG::decodeRows_RGBA8888(std::uint8_t* const decData, const std::int32_t stride)
+	{
+		std::int32_t rc = -1;
+		const std::int32_t rowByte = this->width_ * BYTE_PER_PIXEL_RGBA8888;
+		std::int32_t srcRowByte = 0;
+		std::int32_t passNum = 1;
 
-			//グレーサンプル値(輝度に応じたグレーカラー取得に必要)
-			png_byte graySample = 255 / bitMaxValue;
+		//1,2,4bitのパレット、グレーはlibpngで1ピクセル1バイトへ展開(値は変換テーブルでRGBAへ)
+		if (this->bitDepth_ < 8) {
+			png_set_packing(this->pngStr_);
+		}
+		//インターレース(Adam7)はlibpngで各パスの画素を行へ合成(インターレースなしは1パス)
+		passNum = png_set_interlace_handling(this->pngStr_);
+		png_read_update_info(this->pngStr_, this->pngInfo_);
+		if (this->prepareConvertRow() != 0) {
+			//未対応のカラータイプ、ビット深度
+			goto END;
+		}
 
-			//出力データへデコード後の画像データを設定
-			for (std::int32_t h = 0; h < this->height_; h++) {
-				//一行ずつ処理
-				png_bytep wp = png[h];
-
-				//書き込み位置と読み込み位置を初期化
-				std::int32_t writeOffset = h * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-				std::int32_t readOffset = 0;
-
-				//ビット深度に応じたビットオフセット
-				png_int_16 bitOfs = 8 - this->bitDepth_;
-
-				for (std::int32_t w = 0; w < this->width_; w++) {
-					//輝度を取得
-					png_byte brightness = (wp[readOffset] >> bitOfs) & bitMaxValue;
-
-					//輝度に応じたグレーカラーを取得
-					png_byte grayColor = graySample * brightness;
-
-					//出力データへRGBA値を設定
-					*((*decData) + writeOffset + 0) = grayColor;
-					*((*decData) + writeOffset + 1) = grayColor;
-					*((*decData) + writeOffset + 2) = grayColor;
-					*((*decData) + writeOffset + 3) = 255;
-
-					//ビットオフセットを更新
-					bitOfs -= this->bitDepth_;
-					if (bitOfs < 0) {
-						//次の読み込み位置に更新
-						bitOfs = 8 - this->bitDepth_;
-						readOffset++;
-					}
-					//書き込み位置を更新
-					writeOffset += BYTE_PER_PIXEL_RGBA8888;
-				}
-			}
+		//読み込む行バイト数を確認(1ピクセル1サンプル1バイト、16bitは2バイト)
+		srcRowByte = std::int32_t(png_get_rowbytes(this->pngStr_, this->pngInfo_));
+		if (srcRowByte != (this->width_ * this->channelNum_ * ((this->bitDepth_ == 16) ? 2 : 1))) {
+			//変換不可
+			goto END;
 		}
-		else {
-			//ビット深度が1bit,2bit,4bit,8bit以外の場合
-			//ビット深度が16bitの可能性があるが、現状48bitカラーは表現できないので実装しない
-			//16bit以外でここに来た場合は異常
-			rc = -1;
+		if (passNum > 1) {
+			//インターレースは全パスを読み込んでから変換
+			rc = this->decodeInterlace_RGBA8888(decData, stride, srcRowByte, passNum);
+			goto END;
+		}
+		if ((this->bitDepth_ == 16) || (this->isTransColor_)) {
+			//16bit(出力先の1行に収まらない)と透過色の適用(変換前の行が必要)は、1行分の作業領域へ読み込む
+			this->work_ = new png_byte[srcRowByte];
+		}
+
+		//出力先の行末側へ読み込み、変換関数でその場展開する(展開は前から行うので未読の部分を上書きしない)
+		for (std::int32_t h = 0; h < this->height_; h++) {
+			std::uint8_t* const wp = decData + (h * stride);
+			const png_bytep rp = (this->work_ != nullptr) ? this->work_ : (wp + (rowByte - srcRowByte));
+			png_read_row(this->pngStr_, rp, nullptr);
+			this->convertRow_RGBA8888(rp, wp);
 		}
+		if (this->passFunc_ != nullptr) {
+			this->passFunc_(this->passUser_, 1, 1);
+		}
+
+		//正常終了
+		rc = 0;
 
+	END:
 		return rc;
 	}
 
-	//トゥルーカラーPNG画像からRGBA8888画像へデコード
-	std::int32_t DWImagePNG::decodeTrueColorPng_RGBA8888(std::uint8_t** const decData, const png_bytepp png, const bool isAlpha)
+	//インターレース(Adam7)画像を出力先へデコード(srcRowByteは読み込む1行のバイト数、パス完了コールバック関数があればパス毎に出力先へ書き込む)
+	std::int32_t DWImagePNG::decodeInterlace_RGBA8888(std::uint8_t* const decData, const std::int32_t stride, const std::int32_t srcRowByte, const std::int32_t passNum)
 	{
-		std::int32_t rc = 0;
-
-		if (this->bitDepth_ == 8) {
-			//ビット深度が8bitの場合
+		const std::int32_t rowByte = this->width_ * BYTE_PER_PIXEL_RGBA8888;
+		const bool isProgressive = (this->passFunc_ != nullptr);
+		png_bytep image = nullptr;
+
+		if ((this->bitDepth_ == 16) || (this->isTransColor_) || (isProgressive)) {
+			//16bit(出力先の1行に収まらない)、透過色の適用、パス毎の書き込み(変換後も後続パスで変換前の画素が必要)は、
+			//画像全体の作業領域へ読み込む
+			this->work_ = new png_byte[srcRowByte * this->height_];
+			image = this->work_;
+		}
 
-			//出力データへデコード後の画像データを設定
+		//各パスは全行を読み込む(後続パスは読み込み済みの行へ自パスの画素を合成)
+		for (std::int32_t pass = 0; pass < passNum; pass++) {
 			for (std::int32_t h = 0; h < this->height_; h++) {
-				//一行ずつ処理
-				png_bytep wp = png[h];
-
-				//書き込み位置と読み込み位置を初期化
-				std::int32_t writeOffset = h * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-				std::int32_t readOffset = 0;
-
-				for (std::int32_t w = 0; w < this->width_; w++) {
-					//出力データへRGBA値を設定
-					*((*decData) + writeOffset + 0) = wp[readOffset + 0];
-					*((*decData) + writeOffset + 1) = wp[readOffset + 1];
-					*((*decData) + writeOffset + 2) = wp[readOffset + 2];
-					*((*decData) + writeOffset + 3) = (isAlpha) ? wp[readOffset + 3] : 255;
-
-					//書き込み位置を更新
-					writeOffset += BYTE_PER_PIXEL_RGBA8888;
-					readOffset += (isAlpha) ? 4 : 3;
+				const png_bytep rp = (image != nullptr) ? (image + (h * srcRowByte)) : (decData + (h * stride) + (rowByte - srcRowByte));
+				if (isProgressive) {
+					//未読の画素を自パスの画素で埋める(粗い画像として表示できる)
+					png_read_row(this->pngStr_, nullptr, rp);
+				}
+				else {
+					//自パスの画素のみ書き込む
+					png_read_row(this->pngStr_, rp, nullptr);
+				}
+			}
+
+			if ((isProgressive) || (pass == (passNum - 1))) {
+				//出力先へ変換(画像全体のメモリがなければ出力先の行末側からその場展開)
+				for (std::int32_t h = 0; h < this->height_; h++) {
+					std::uint8_t* const wp = decData + (h * stride);
+					const png_bytep rp = (image != nullptr) ? (image + (h * srcRowByte)) : (wp + (rowByte - srcRowByte));
+					this->convertRow_RGBA8888(rp, wp);
 				}
 			}
+			if (isProgressive) {
+				this->passFunc_(this->passUser_, pass + 1, passNum);
+			}
 		}
-		else {
-			//ビット深度が8bit以外は何もしない
-			//ビット深度が16bitの可能性があるが、現状48bitカラーは表現できないので実装しない
-			//16bit以外でここに来た場合は異常
-			rc = -1;
+
+		return 0;
+	}
+
+	//作業領域を解放
+	void DWImagePNG::releaseWork()
+	{
+		if (this->work_ != nullptr) {
+			delete[] this->work_;
+			this->work_ = nullptr;
 		}
+		if (this->alphaWork_ != nullptr) {
+			delete[] this->alphaWork_;
+			this->alphaWork_ = nullptr;
+		}
+	}
 
-		return rc;
+	//行変換の準備(カラータイプ、ビット深度に応じて変換関数と変換テーブルを選択、1,2,4bitは1ピクセル1バイトへ展開済み)
+	std::int32_t DWImagePNG::prepareConvertRow()
+	{
+		const bool isTRNS = (png_get_valid(this->pngStr_, this->pngInfo_, PNG_INFO_tRNS) != 0);
+
+		//16bitは8bitへ縮小してから展開
+		this->reduceRow_ = (this->bitDepth_ == 16) ? DWPixelConv::getReduce16RowFunc() : nullptr;
+		this->expandRow_ = nullptr;
+		this->indexRow_ = nullptr;
+		this->isTransColor_ = false;
+
+		switch (this->colorType_) {
+		case PNG_COLOR_TYPE_GRAY:		//0:グレー
+			this->channelNum_ = 1;
+			if (this->bitDepth_ <= 8) {
+				//輝度を変換テーブルでRGBAへ(透過色はテーブルのアルファへ)
+				this->makeGrayColors(this->bitDepth_, isTRNS);
+				this->indexRow_ = DWPixelConv::getIndexRowFunc(8);
+			}
+			else {
+				//8bitへ縮小した輝度を変換テーブルでRGBAへ(透過色は16bitの値で比較して適用)
+				this->makeGrayColors(8, false);
+				this->indexRow_ = DWPixelConv::getIndexRowFunc(8);
+				this->isTransColor_ = isTRNS;
+			}
+			break;
+		case PNG_COLOR_TYPE_RGB:		//2:トゥルーカラー
+			this->channelNum_ = 3;
+			this->expandRow_ = DWPixelConv::getRowFunc(DWPixelConv::Format::RGB888);
+			this->isTransColor_ = isTRNS;
+			break;
+		case PNG_COLOR_TYPE_PALETTE:	//3:パレット
+			this->channelNum_ = 1;
+			if (this->makePalleteColors() != 0) {
+				//パレットデータ取得失敗
+				return -1;
+			}
+			this->indexRow_ = DWPixelConv::getIndexRowFunc(8);
+			break;
+		case PNG_COLOR_TYPE_GRAY_ALPHA:	//4:グレー+アルファ
+			this->channelNum_ = 2;
+			this->expandRow_ = (this->isPremultiplied_) ? DWPixelConv::getPremulRowFunc(DWPixelConv::Format::GRAYALPHA88) : DWPixelConv::getRowFunc(DWPixelConv::Format::GRAYALPHA88);
+			break;
+		case PNG_COLOR_TYPE_RGB_ALPHA:	//6:トゥルーカラー+アルファ
+			this->channelNum_ = 4;
+			this->expandRow_ = (this->isPremultiplied_) ? DWPixelConv::getPremulRowFunc(DWPixelConv::Format::RGBA8888) : DWPixelConv::getRowFunc(DWPixelConv::Format::RGBA8888);
+			break;
+		default:
+			return -1;
+		}
+
+		if ((this->expandRow_ == nullptr) && (this->indexRow_ == nullptr)) {
+			//未対応のビット深度
+			return -1;
+		}
+		return 0;
 	}
 
-	//パレットPNG画像からRGBA8888画像へデコード
-	std::int32_t DWImagePNG::decodePalletePng_RGBA8888(std::uint8_t** const decData, const png_bytepp png)
+	//デコード後の1行をRGBA8888の1行へ変換(srcはdstの行末側に置いてもよい、16bitと透過色の適用はdstと重ならないこと)
+	void DWImagePNG::convertRow_RGBA8888(const png_bytep src, std::uint8_t* const dst)
 	{
-		std::int32_t rc = 0;
+		const std::int32_t sampleNum = this->width_ * this->channelNum_;
+
+		//16bitは出力先の行末側へ8bitへ縮小して書き込み、そこからその場展開
+		const std::uint8_t* rp = src;
+		if (this->reduceRow_ != nullptr) {
+			std::uint8_t* const reduced = dst + ((this->width_ * BYTE_PER_PIXEL_RGBA8888) - sampleNum);
+			this->reduceRow_(src, reduced, sampleNum);
+			rp = reduced;
+		}
+
+		if (this->indexRow_ != nullptr) {
+			this->indexRow_(rp, dst, this->width_, this->colors_);
+		}
+		else if ((rp != dst) || (this->isPremultiplied_)) {
+			//RGBAを出力先へ直接読み込んだ場合は、乗算済みアルファのみ変換
+			this->expandRow_(rp, dst, this->width_);
+		}
+
+		if (this->isTransColor_) {
+			this->applyTransColor(src, dst);
+		}
+	}
 
+	//パレットをRGBA8888の変換テーブルへ展開(透過色(tRNS)はアルファへ、パレット外は黒、乗算済みアルファは乗算)
+	std::int32_t DWImagePNG::makePalleteColors()
+	{
 		//PLTEチャンク読み込み
 		png_colorp pallete = nullptr;
 		std::int32_t palleteNum = 0;
 		png_get_PLTE(this->pngStr_, this->pngInfo_, &pallete, &palleteNum);
+		if ((pallete == nullptr) || (palleteNum <= 0)) {
+			//パレットデータ取得失敗
+			return -1;
+		}
+
+		//tRNSチャンク読み込み(パレットインデックス毎のアルファ、なければ不透明)
+		png_bytep transAlpha = nullptr;
+		std::int32_t transNum = 0;
+		if (png_get_valid(this->pngStr_, this->pngInfo_, PNG_INFO_tRNS) != 0) {
+			png_get_tRNS(this->pngStr_, this->pngInfo_, &transAlpha, &transNum, nullptr);
+		}
 
-		if ((pallete != nullptr) && (palleteNum > 0)) {
-			//パレットデータ取得成功
+		for (std::int32_t p = 0; p < PALLETE_MAXNUM; p++) {
+			const png_color color = (p < palleteNum) ? pallete[p] : png_color{ 0, 0, 0 };
+			const std::uint8_t alpha = ((transAlpha != nullptr) && (p < transNum)) ? transAlpha[p] : 255;
+			const std::uint8_t rgba[BYTE_PER_PIXEL_RGBA8888] = { color.red, color.green, color.blue, alpha };
+			memcpy(&this->colors_[p], rgba, BYTE_PER_PIXEL_RGBA8888);
+		}
+		if (this->isPremultiplied_) {
+			//変換テーブルを乗算済みにしておけば、展開時の乗算は不要
+			std::uint8_t* const colors = reinterpret_cast<std::uint8_t*>(this->colors_);
+			DWPixelConv::getPremulRowFunc(DWPixelConv::Format::RGBA8888)(colors, colors, PALLETE_MAXNUM);
+		}
 
-			//出力データへデコード後の画像データを設定
-			for (std::int32_t h = 0; h < this->height_; h++) {
-				//一行ずつ処理
-				png_bytep wp = png[h];
-
-				//書き込み位置と読み込み位置を初期化
-				std::int32_t writeOffset = h * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-				std::int32_t readOffset = 0;
-
-				//ビット深度に応じたビットオフセットとビットマスク
-				png_int_16 bitOfs = 8 - this->bitDepth_;
-				png_byte bitMask = (0x01 << this->bitDepth_) - 1;
-
-				for (std::int32_t w = 0; w < this->width_; w++) {
-					//画像データはパレットインデックス
-					png_byte palleteIndex = (wp[readOffset] >> bitOfs) & bitMask;
-
-					//出力データへRGBA値を設定
-					*((*decData) + writeOffset + 0) = pallete[palleteIndex].red;
-					*((*decData) + writeOffset + 1) = pallete[palleteIndex].green;
-					*((*decData) + writeOffset + 2) = pallete[palleteIndex].blue;
-					*((*decData) + writeOffset + 3) = 255;
-
-					//ビットオフセットを更新
-					bitOfs -= this->bitDepth_;
-					if (bitOfs < 0) {
-						//次の読み込み位置に更新
-						bitOfs = 8 - this->bitDepth_;
-						readOffset++;
-					}
-					//書き込み位置を更新
-					writeOffset += BYTE_PER_PIXEL_RGBA8888;
+		return 0;
+	}
+
+	//輝度をRGBA8888のグレーの変換テーブルへ展開(bitDepthは1,2,4,8、輝度の最大値を255へ拡大、isTRNSなら透過色の輝度を透明に)
+	void DWImagePNG::makeGrayColors(const std::int32_t bitDepth, const bool isTRNS)
+	{
+		const std::int32_t bitMaxValue = (0x01 << bitDepth) - 1;
+		const std::int32_t graySample = 255 / bitMaxValue;
+		for (std::int32_t brightness = 0; brightness <= bitMaxValue; brightness++) {
+			const std::uint8_t grayColor = static_cast<std::uint8_t>(graySample * brightness);
+			const std::uint8_t rgba[BYTE_PER_PIXEL_RGBA8888] = { grayColor, grayColor, grayColor, 255 };
+			memcpy(&this->colors_[brightness], rgba, BYTE_PER_PIXEL_RGBA8888);
+		}
+
+		png_color_16p transColor = nullptr;
+		if ((isTRNS) && (png_get_tRNS(this->pngStr_, this->pngInfo_, nullptr, nullptr, &transColor) != 0) && (transColor != nullptr) && (transColor->gray <= bitMaxValue)) {
+			//透明(乗算済みアルファでも同じ)
+			const std::uint8_t grayColor = static_cast<std::uint8_t>(graySample * transColor->gray);
+			const std::uint8_t rgba[BYTE_PER_PIXEL_RGBA8888] = { grayColor, grayColor, grayColor, 0 };
+			memcpy(&this->colors_[transColor->gray], rgba, BYTE_PER_PIXEL_RGBA8888);
+			if (this->isPremultiplied_) {
+				this->colors_[transColor->gray] = 0;
+			}
+		}
+	}
+
+	//透過色(tRNS)と一致するピクセルを透明にする(グレー16bit、トゥルーカラー用、srcは変換前の1行で8bitか16bit)
+	void DWImagePNG::applyTransColor(const png_bytep src, std::uint8_t* const dst)
+	{
+		png_color_16p transColor = nullptr;
+		if ((png_get_tRNS(this->pngStr_, this->pngInfo_, nullptr, nullptr, &transColor) == 0) || (transColor == nullptr)) {
+			return;
+		}
+
+		//比較する値(グレーは輝度、トゥルーカラーはR,G,B)
+		const std::int32_t sampleByte = this->bitDepth_ / 8;
+		const std::uint16_t keys[3] = {
+			(this->channelNum_ == 1) ? transColor->gray : transColor->red, transColor->green, transColor->blue };
+		for (std::int32_t w = 0; w < this->width_; w++) {
+			const png_byte* rp = src + (w * this->channelNum_ * sampleByte);
+			bool isMatch = true;
+			for (std::int32_t c = 0; (c < this->channelNum_) && (isMatch); c++) {
+				const std::uint16_t value = (sampleByte == 2) ? static_cast<std::uint16_t>((rp[c * 2] << 8) | rp[(c * 2) + 1]) : rp[c];
+				isMatch = (value == keys[c]);
+			}
+			if (isMatch) {
+				//透明(乗算済みアルファはR,G,Bも0)
+				std::uint8_t* const wp = dst + (w * BYTE_PER_PIXEL_RGBA8888);
+				if (this->isPremultiplied_) {
+					memset(wp, 0, BYTE_PER_PIXEL_RGBA8888);
+				}
+				else {
+					wp[3] = 0;
 				}
 			}
 		}
-		else {
-			//パレットデータ取得失敗
-			rc = -1;
+	}
+
+
+
+
+	//----------------------------------------------------------------
+	// DWTickSchedulerクラス
+	//----------------------------------------------------------------
+
+	//コンストラクタ
+	DWTickScheduler::DWTickScheduler() :
+		deadline_(), marginUs_(0), lateUs_(0), maxLateUs_(0)
+	{
+	}
+
+	//次の秒境界まで待ち(lockは取得済みであること、isWakeupがtrueになれば途中で戻る)
+	bool DWTickScheduler::waitNextTick(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, const bool& isWakeup)
+	{
+		//現在時刻の次の秒境界を絶対時刻で求める(寝過ごした場合も次の境界へ合わせるため誤差が蓄積しない)
+		const std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+		const std::chrono::seconds sec = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch());
+		this->deadline_ = std::chrono::system_clock::time_point(sec + std::chrono::seconds(1));
+
+		//オーバースリープ分だけ早めに起床(起床要求があれば即座に戻る)
+		const std::chrono::system_clock::time_point wakeup = this->deadline_ - std::chrono::microseconds(this->marginUs_);
+		if (cv.wait_until(lock, wakeup, [&isWakeup] { return isWakeup; })) {
+			//起床要求
+			return false;
 		}
 
-		return rc;
+		//オーバースリープを実測し、早起き幅を補正(1/8の重みで平滑化)
+		const std::int32_t overUs = static_cast<std::int32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - wakeup).count());
+		this->marginUs_ = ((this->marginUs_ * 7) + overUs) / 8;
+		if (this->marginUs_ < 0) { this->marginUs_ = 0; }
+		if (this->marginUs_ > MARGIN_MAX_US) { this->marginUs_ = MARGIN_MAX_US; }
+
+		//秒境界より前に起床した場合は、残りを再度待つ(譲りながらの待ちはしない、秒境界を過ぎていれば即座に戻る)
+		if (cv.wait_until(lock, this->deadline_, [&isWakeup] { return isWakeup; })) {
+			//起床要求
+			return false;
+		}
+
+		return true;
 	}
 
+	//表示完了を通知(秒境界からの表示遅延を記録)
+	void DWTickScheduler::notifyPresent()
+	{
+		if (this->deadline_ == std::chrono::system_clock::time_point()) {
+			//秒境界を未待ち合わせ(初回フレーム)
+			return;
+		}
+
+		const std::chrono::system_clock::duration late = std::chrono::system_clock::now() - this->deadline_;
+		this->lateUs_ = static_cast<std::int32_t>(std::chrono::duration_cast<std::chrono::microseconds>(late).count());
+		if (this->lateUs_ > this->maxLateUs_) {
+			this->maxLateUs_ = this->lateUs_;
+		}
+	}
+
+	//直近の表示遅延取得[us]
+	std::int32_t DWTickScheduler::getLateUs()
+	{
+		return this->lateUs_;
+	}
+
+	//最大表示遅延取得[us]
+	std::int32_t DWTickScheduler::getMaxLateUs()
+	{
+		return this->maxLateUs_;
+	}
 
 
 
@@ -1369,7 +3526,10 @@ namespace dw {
 	//時刻取得
 	DWTime DWFunc::getTime()
 	{
-		time_t t = time(nullptr);
+		return DWFunc::getTime(time(nullptr));
+	}
+	DWTime DWFunc::getTime(const time_t t)
+	{
 		struct tm tm;
 		(void)localtime_s(&tm, &t);
 
@@ -1399,9 +3559,20 @@ namespace dw {
 		case '8':	filePath = filePath + "8_eight.png";	format = DWImageFormat::PNG;	break;
 		case '9':	filePath = filePath + "9_nine.png";		format = DWImageFormat::PNG;	break;
 		case ':':	filePath = filePath + "sym_colon.png";	format = DWImageFormat::PNG;	break;
+		case ';':	filePath = filePath + "sym_semicolon.png";	format = DWImageFormat::PNG;	break;
+		case ',':	filePath = filePath + "sym_comma.png";	format = DWImageFormat::PNG;	break;
+		case '.':	filePath = filePath + "sym_dot.png";	format = DWImageFormat::PNG;	break;
 		//case ':':	filePath = filePath + "win-24.bmp";		format = DWImageFormat::BMP;	break;
 		default:	break;
 		}
 		return filePath;
 	}
+
+	//数字画像の文字一覧取得
+	const std::char8_t* DWFunc::getChars_TimeNumImage(std::int32_t* const charNum)
+	{
+		static const std::char8_t CHARS[] = "0123456789:;,.";
+		if (charNum != nullptr) { *charNum = static_cast<std::int32_t>(sizeof(CHARS) - 1); }
+		return CHARS;
+	}
 }
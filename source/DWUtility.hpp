@@ -2,14 +2,16 @@
 #define INCLUDED_DWUTILITY_HPP
 
 #include "DWType.hpp"
-#include <Windows.h>
+#include "DWRenderer.hpp"
+#include "DWPixelConv.hpp"
 #include <time.h>
 #include <mutex>
+#include <condition_variable>
 #include <string>
 #include <fstream>
-
-//OpenGL
-#include <gl/GL.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
 
 //FreeType
 #include <ft2build.h>
@@ -19,12 +21,12 @@
 
 //libpng
 #include <png.h>
-#include <pngstruct.h>
 
 namespace dw {
 
-	//DWWindowクラス
-	class DWWindow {
+	//DWGlyphCacheクラス(描画済みグリフのキャッシュ)
+	class DWGlyphCache {
+	public:
 		//フォント寸法情報
 		struct FontMetrics {
 			//メンバ変数
@@ -37,28 +39,139 @@ namespace dw {
 			std::int32_t	kerningX_;	//水平方向カーニング
 			std::int32_t	kerningY_;	//垂直方向カーニング
 		};
-		//フォントグリフ
-		struct FontGlyph {
-			FT_UInt			index_;		//グリフインデックス
-			FT_Glyph		image_;		//グリフイメージ
-			FontMetrics		metrics_;	//寸法情報
+		//キャッシュ済みグリフ
+		struct Glyph {
+			FontMetrics		metrics_;			//寸法情報
+			std::uint8_t*	image_;				//グリフイメージ(A8、1行=metrics_.width_バイト)
+			std::uint32_t	atlasGeneration_;	//グリフアトラスの配置世代(0:未配置)
+			DWArea			atlasArea_;			//グリフアトラス内の領域
+		};
+
+	private:
+		//エントリ最大数
+		static const std::int32_t ENTRY_MAXNUM = 512;
+		//ハッシュバケット数(2のべき乗)
+		static const std::int32_t BUCKET_NUM = 256;
+
+		//エントリ
+		struct Entry {
+			bool			isValid_;		//有効/無効
+			FT_Face			face_;			//キー:フェイス
+			std::int32_t	textSize_;		//キー:文字サイズ(96dpi)
+			FT_UInt			index_;			//キー:グリフインデックス
+			FT_Render_Mode	renderMode_;	//キー:描画モード
+			Glyph			glyph_;			//グリフ
+			std::uint32_t	lastUse_;		//最終参照世代(LRU追い出し用)
+			std::int32_t	next_;			//同一バケットの次エントリ(-1:終端)
 		};
 
 		//メンバ変数
-		HWND		hWnd_;
-		HDC			hDC_;
-		HGLRC		hGLRC_;
+		std::int32_t	buckets_[BUCKET_NUM];	//バケット毎の先頭エントリ(-1:なし)
+		Entry			entries_[ENTRY_MAXNUM];	//エントリテーブル
+		std::int32_t	byteBudget_;			//グリフイメージの上限バイト数
+		std::int32_t	byteUsed_;				//グリフイメージの使用バイト数
+		std::uint32_t	generation_;			//参照世代
+		std::int32_t	hitNum_;				//ヒット数
+		std::int32_t	missNum_;				//ミス数
+
+	public:
+		//コンストラクタ
+		DWGlyphCache(const std::int32_t byteBudget);
+		//デストラクタ
+		~DWGlyphCache();
+		//参照世代を進める(現世代で参照したグリフは追い出さない)
+		void nextGeneration();
+		//グリフ取得(未キャッシュならFreeTypeで描画して登録、失敗時はnullptr)
+		Glyph* get(FT_Face face, const std::int32_t textSize, const FT_UInt index, const FT_Render_Mode renderMode);
+		//上限バイト数設定
+		void setByteBudget(const std::int32_t byteBudget);
+		//全エントリ破棄
+		void clear();
+		//統計取得
+		std::int32_t getHitNum();
+		std::int32_t getMissNum();
+		std::int32_t getByteUsed();
+
+	private:
+		//ハッシュ値からバケット番号を算出
+		std::int32_t getBucketNo(FT_Face face, const std::int32_t textSize, const FT_UInt index, const FT_Render_Mode renderMode);
+		//グリフをA8画像へ描画
+		std::int32_t renderGlyph(FT_Face face, const std::int32_t textSize, const FT_UInt index, const FT_Render_Mode renderMode, Glyph* const glyph);
+		//最も古いエントリを追い出す(追い出したエントリ番号、なければ-1)
+		std::int32_t evictOldest();
+
+		//コピーコンストラクタ(禁止)
+		DWGlyphCache(const DWGlyphCache& org) = delete;
+		//代入演算子(禁止)
+		DWGlyphCache& operator=(const DWGlyphCache& org) = delete;
+	};
 
-		FT_Library	ftLibrary_;
-		FT_Face		ftFace_;
+	//DWGlyphAtlasクラス(グリフを1枚のアルファ画像へ詰めて配置)
+	class DWGlyphAtlas {
+		//ページ幅高さ[pixel]
+		static const std::int32_t PAGE_WIDTH = 512;
+		static const std::int32_t PAGE_HEIGHT = 512;
+		//グリフ間の余白[pixel](線形補間で隣のグリフがにじまないように)
+		static const std::int32_t PADDING = 1;
+		//シェルフ最大数
+		static const std::int32_t SHELF_MAXNUM = 64;
+
+		//シェルフ(同じ高さ以下のグリフを横に並べる行)
+		struct Shelf {
+			std::int32_t	y_;			//上端
+			std::int32_t	height_;	//高さ
+			std::int32_t	x_;			//次の配置位置
+		};
 
-		DWSize		size_;
+		//メンバ変数
+		std::uint8_t*	page_;					//ページデータ(A8)
+		Shelf			shelves_[SHELF_MAXNUM];	//シェルフ
+		std::int32_t	shelfNum_;				//使用中のシェルフ数
+		std::uint32_t	generation_;			//配置世代(リセット毎に加算)
 
 	public:
-		//作成
+		//コンストラクタ
+		DWGlyphAtlas();
+		//デストラクタ
+		~DWGlyphAtlas();
+		//グリフを配置(イメージをページへコピー、空きがなければ-1)
+		std::int32_t add(DWGlyphCache::Glyph* const glyph);
+		//全配置を破棄(配置世代を進める)
+		void reset();
+		//配置世代取得
+		std::uint32_t getGeneration();
+		//ページ取得
+		void getPage(DWBitmap* const bitmap);
+
+	private:
+		//コピーコンストラクタ(禁止)
+		DWGlyphAtlas(const DWGlyphAtlas& org) = delete;
+		//代入演算子(禁止)
+		DWGlyphAtlas& operator=(const DWGlyphAtlas& org) = delete;
+	};
+
+	//DWWindowクラス
+	class DWWindow {
+		//メンバ変数
+		DWRenderer*	renderer_;	//描画バックエンド
+
+		FT_Library		ftLibrary_;
+		FT_Face			ftFace_;
+		DWGlyphCache	glyphCache_;	//グリフキャッシュ
+		DWGlyphAtlas	glyphAtlas_;	//グリフアトラス
+		std::int32_t	glyphPageID_;	//グリフアトラスの常駐画像ID
+
+	public:
+#if defined(_WIN32)
+		//作成(Win32ウィンドウへOpenGLで描画)
 		static void create(void* native);
+#endif
+		//作成(ヘッドレス、CPU上のフレームバッファへ描画、fontPathがnullptrなら既定のフォント、フォントを読み込めなければ作成せず-1)
+		static std::int32_t createHeadless(const std::int32_t width, const std::int32_t height, const char* const fontPath = nullptr);
 		//取得
 		static DWWindow* get();
+		//既定のフォントファイルパス取得
+		static const char* getDefaultFontPath();
 		//破棄
 		static void destroy();
 
@@ -68,48 +181,161 @@ namespace dw {
 		void endDraw();
 		//画面塗りつぶし
 		void clear(const DWColor& color);
+		//矩形塗りつぶし
+		void fillRect(const DWArea& area, const DWColor& color);
+		//ウィンドウサイズ更新(描画スレッドから呼ぶこと)
+		void updateSize();
+		//ウィンドウサイズ取得
+		DWSize getSize();
+		//描画終了後もバックバッファの内容が保持されるか(falseなら毎フレーム全体再描画が必要)
+		bool isBackBufferKept();
+		//文字列の行高さ取得[pixel]
+		std::int32_t getTextLineHeight(const std::int32_t textSize);
 		//文字描画
 		void drawText(const DWText& text, const DWCoord& coord, const DWColor& color);
 		//画像描画
 		void drawBitmap(const DWBitmap& bitmap, const DWCoord& coord);
+		void drawBitmap(const DWBitmap& bitmap, const DWArea& srcArea, const DWCoord& coord);
+		void drawBitmap(const std::int32_t bitmapID, const DWCoord& coord);
+		void drawBitmap(const std::int32_t bitmapID, const DWArea& srcArea, const DWCoord& coord);
+		//常駐画像登録(画像データは登録解除まで保持すること)
+		std::int32_t registerBitmap(const DWBitmap& bitmap);
+		//常駐画像登録解除
+		void unregisterBitmap(const std::int32_t bitmapID);
+		//前フレームのテクスチャ転送バイト数取得
+		std::int32_t getUploadByte();
+		//前フレームの描画コール数取得
+		std::int32_t getDrawCallNum();
+		//グリフキャッシュ取得
+		DWGlyphCache* getGlyphCache();
+		//描画バックエンド取得
+		DWRenderer* getRenderer();
 
 	private:
+		//未配置のグリフをグリフアトラスへ配置
+		std::int32_t placeGlyphs(DWGlyphCache::Glyph* const* const glyphs, const std::int32_t glyphNum);
+
 		//コンストラクタ
-		DWWindow(HWND hWnd);
+		DWWindow(DWRenderer* const renderer, const char* const fontPath);
 		//デストラクタ
 		~DWWindow();
 	};
 
+	//DWFileMapクラス(ファイルをメモリへマップ、マップできなければ読み込み)
+	class DWFileMap {
+		//マップする最小サイズ[byte](これより小さいファイルはマップより読み込みの方が速い)
+		static const std::int32_t MAP_MINSIZE = 256 * 1024;
+
+		//メンバ変数
+		std::uint8_t*	data_;		//ファイルデータ(マップ時は読み取り専用)
+		std::int32_t	size_;		//ファイルサイズ
+		bool			isMapped_;	//マップ済み(false:new[]で確保して読み込み)
+
+	public:
+		//コンストラクタ
+		DWFileMap();
+		//デストラクタ
+		~DWFileMap();
+		//オープン(isMapEnableがfalseまたはマップ失敗時は全体を読み込む、MAP_MINSIZE未満は常に読み込む)
+		std::int32_t open(const std::char8_t* const filePath, const bool isMapEnable = true);
+		//クローズ
+		void close();
+		//データ取得
+		std::uint8_t* getData();
+		//サイズ取得
+		std::int32_t getSize();
+		//マップ済みか
+		bool isMapped();
+		//ファイルをページキャッシュから破棄(コールド計測用、未対応環境は-1)
+		static std::int32_t dropCache(const std::char8_t* const filePath);
+		//ファイルの更新時刻取得(環境毎の単位、比較にのみ使用)
+		static std::int32_t getModifiedTime(const std::char8_t* const filePath, std::int64_t* const mtime);
+
+	private:
+		//マップ(MAP_MINSIZE未満は同じハンドルから読み込む)
+		std::int32_t map(const std::char8_t* const filePath);
+		//全体を読み込み
+		std::int32_t read(const std::char8_t* const filePath);
+
+		//コピーコンストラクタ(禁止)
+		DWFileMap(const DWFileMap& org) = delete;
+		//代入演算子(禁止)
+		DWFileMap& operator=(const DWFileMap& org) = delete;
+	};
+
 	//DWImageDecorderクラス
 	class DWImageDecorder {
+	public:
+		//進捗コールバック関数(passは書き込みが完了したパス番号(1始まり)、passNumは全パス数(インターレースPNG以外は1))
+		typedef void(*ProgressFunc)(void* const user, const std::int32_t pass, const std::int32_t passNum);
+
+	private:
 		//メンバ変数
 		std::uint8_t*	decData_;		//デコードデータ
 		std::int32_t	decDataSize_;	//デコードデータサイズ
 		std::int32_t	width_;			//幅
 		std::int32_t	height_;		//高さ
+		std::uint8_t*	dst_;			//書き込み先(画像の1行目の左端ピクセル)
+		std::int32_t	dstStride_;		//書き込み先の1行のバイト数(上下反転時は負)
+		std::uint8_t*	workData_;		//RGBA8888の作業領域(RGBA8888以外で出力する場合のみ、デコード中のみ確保)
+		std::uint8_t*	packDst_;		//出力画素フォーマットの書き込み先(作業領域から変換、画像の1行目の左端ピクセル)
+		std::int32_t	packStride_;	//出力画素フォーマットの書き込み先の1行のバイト数
+		bool			isFileMap_;		//画像ファイルをマップして読む
+		bool			isPremultiplied_;	//乗算済みアルファで出力
+		DWPixelFormat	pixelFormat_;	//出力画素フォーマット
+		ProgressFunc	progressFunc_;	//進捗コールバック関数(nullptr:通知なし)
+		void*			progressUser_;	//進捗コールバック関数へ渡すユーザーデータ
+		std::int32_t	passNum_;		//デコード中の画像の全パス数
 
 	public:
 		//コンストラクタ
 		DWImageDecorder();
 		//デストラクタ
 		~DWImageDecorder();
-		//RGBA8888画像へデコード
+		//RGBA8888画像へデコード(isFlipなら上下反転、デコード時の書き込み順で反転するため追加処理なし、setPixelFormatの指定があればその画素フォーマットで出力)
 		std::int32_t decode_RGBA8888(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const bool isFlip = false);
 		std::int32_t decode_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, std::uint8_t* const blendData, const std::int32_t blendDataSize, const DWImageFormat format, const bool isFlip = false);
-		//デコードデータ取得
+		//呼び出し元の出力先へRGBA8888画像をデコード(出力先の内部領域は確保しない、strideと書き込み位置は出力画素フォーマットのバイト数で指定)
+		std::int32_t decode_RGBA8888(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const DWDecodeTarget& target, const bool isFlip = false);
+		std::int32_t decode_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, std::uint8_t* const blendData, const std::int32_t blendDataSize, const DWImageFormat format, const DWDecodeTarget& target, const bool isFlip = false);
+		//デコードせずに幅高さ取得
+		std::int32_t readWH(const std::char8_t* const bodyFilePath, const DWImageFormat format, std::int32_t* const width, std::int32_t* const height);
+		std::int32_t readWH(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, const DWImageFormat format, std::int32_t* const width, std::int32_t* const height);
+		//デコードデータ取得(出力先指定でデコードした場合はnullptr)
 		std::uint8_t* getDecodeData(std::int32_t* const decDataSize, std::int32_t* const width, std::int32_t* const height);
+		//画像ファイルのマップ有効/無効設定(既定は有効、無効時は全体を読み込む)
+		void setFileMap(const bool isFileMap);
+		//乗算済みアルファ出力の有効/無効設定(既定は無効、有効時はR,G,Bにアルファを乗算して出力)
+		void setPremultiplied(const bool isPremultiplied);
+		//出力画素フォーマット設定(既定はRGBA8888、それ以外はRGBA8888でデコードしてから1行ずつ変換)
+		void setPixelFormat(const DWPixelFormat pixelFormat);
+		//出力画素フォーマット取得
+		DWPixelFormat getPixelFormat();
+		//乗算済みアルファで出力するか(乗算済みアルファ出力が有効で、出力画素フォーマットがR,G,Bとアルファを持つ)
+		bool isPremultipliedOutput();
+		//進捗コールバック関数設定(インターレースPNGは各パスの粗い画像を出力先へ書き込む毎に通知、ブレンド前なのでアルファは本体のもの、
+		//最後の通知はブレンドと出力画素フォーマットへの変換の完了後)
+		void setProgressFunc(const ProgressFunc progressFunc, void* const user);
 
 	private:
-		//本体BMP画像をRGBA8888画像へデコード
-		std::int32_t decodeBMP_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize);
-		//ブレンドBMP画像をRGBA8888画像へデコードし、本体デコード画像へブレンド
-		std::int32_t blendBMP_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize);
-		//本体PNG画像をRGBA8888画像へデコード
-		std::int32_t decodePNG_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize);
-		//ブレンドPNG画像をRGBA8888画像へデコードし、本体デコード画像へブレンド
-		std::int32_t blendPNG_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize);
-		//RGBA8888画像のブレンド処理
-		void blend_RGBA8888(std::uint8_t* const decData_blend);
+		//本体PNG画像のパス完了コールバック関数(最終パス以外を出力画素フォーマットへ変換して通知)
+		static void callbackPassPng(void* const user, const std::int32_t pass, const std::int32_t passNum);
+		//ファイル指定のデコード(targetがnullptrなら内部領域へ)
+		std::int32_t decodeFile(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const DWDecodeTarget* const target, const bool isFlip);
+		//デコード(targetがnullptrなら内部領域へ)
+		std::int32_t decode(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, std::uint8_t* const blendData, const std::int32_t blendDataSize, const DWImageFormat format, const DWDecodeTarget* const target, const bool isFlip);
+		//書き込み先を準備(幅高さ取得後に呼ぶ、isFlipなら最終行から負のstrideで書き込む)
+		std::int32_t prepareDest(const DWDecodeTarget* const target, const bool isFlip);
+		//作業領域のRGBA8888画像を出力画素フォーマットへ変換
+		void packDest();
+		//本体BMP画像をRGBA8888画像へデコード(isPremultipliedなら乗算済みアルファで出力)
+		std::int32_t decodeBMP_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, const DWDecodeTarget* const target, const bool isFlip, const bool isPremultiplied);
+		//ブレンドBMP画像を本体デコード画像のアルファへデコード(isPremultipliedなら乗算済みアルファで出力)
+		std::int32_t blendBMP_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize, const bool isPremultiplied);
+		//本体PNG画像をRGBA8888画像へデコード(isPremultipliedなら乗算済みアルファで出力)
+		std::int32_t decodePNG_RGBA8888(std::uint8_t* const bodyData, const std::int32_t bodyDataSize, const DWDecodeTarget* const target, const bool isFlip, const bool isPremultiplied);
+		//ブレンドPNG画像を本体デコード画像のアルファへデコード(isPremultipliedなら乗算済みアルファで出力)
+		std::int32_t blendPNG_RGBA8888(std::uint8_t* const blendData, const std::int32_t blendDataSize, const bool isPremultiplied);
 
 		//コピーコンストラクタ(禁止)
 		DWImageDecorder(const DWImageDecorder& org) = delete;
@@ -117,6 +343,264 @@ namespace dw {
 		DWImageDecorder& operator=(const DWImageDecorder& org) = delete;
 	};
 
+	//DWWorkerPoolクラス(常駐ワーカースレッドで処理を並列に実行)
+	class DWWorkerPool {
+	public:
+		//ワーカー関数(workerNoは0始まり、0は呼び出しスレッド)
+		typedef void(*WorkFunc)(void* const user, const std::int32_t workerNo);
+
+	private:
+		//常駐ワーカースレッドの最大数
+		static const std::int32_t THREAD_MAXNUM = 63;
+
+		//メンバ変数
+		std::mutex				runMtx_;		//実行中の呼び出し元(同時に1つ、実行中なら呼び出しスレッドのみで処理)
+		std::mutex				mtx_;			//以下の状態を保護
+		std::condition_variable	cv_;			//ワーカーの起床
+		std::condition_variable	doneCv_;		//ワーカーの完了
+		std::thread				threads_[THREAD_MAXNUM];	//常駐ワーカースレッド(初回に必要な数だけ作成)
+		std::int32_t			threadNum_;		//作成済みの常駐ワーカースレッド数
+		WorkFunc				func_;			//実行中のワーカー関数
+		void*					user_;			//実行中のワーカー関数へ渡すユーザーデータ
+		std::int32_t			helperNum_;		//実行に参加する常駐ワーカースレッド数
+		std::int32_t			doneNum_;		//完了した常駐ワーカースレッド数
+		std::uint32_t			generation_;	//実行毎に更新(ワーカーの起床判定)
+		bool					isEnd_;			//終了要求
+
+	public:
+		//インスタンス取得
+		static DWWorkerPool* get();
+		//実行(呼び出しスレッドと常駐ワーカースレッドのworkerNum個でfuncを並列に実行し、全ワーカーの完了まで待つ、実際のワーカー数を返す)
+		//(ワーカー関数内から呼んだ場合、他の呼び出し元が実行中の場合は呼び出しスレッドのみで処理)
+		std::int32_t run(const WorkFunc func, void* const user, const std::int32_t workerNum);
+
+	private:
+		//コンストラクタ
+		DWWorkerPool();
+		//デストラクタ(常駐ワーカースレッドを終了)
+		~DWWorkerPool();
+		//常駐ワーカースレッドをnum個まで作成(作成できた数を返す)
+		std::int32_t createThreads(const std::int32_t num);
+		//常駐ワーカースレッド(seenは作成時の実行世代)
+		void work(const std::int32_t workerNo, std::uint32_t seen);
+
+		//コピーコンストラクタ(禁止)
+		DWWorkerPool(const DWWorkerPool& org) = delete;
+		//代入演算子(禁止)
+		DWWorkerPool& operator=(const DWWorkerPool& org) = delete;
+	};
+
+	//DWImageBatchクラス(複数画像を常駐ワーカースレッドで並列にデコード)
+	class DWImageBatch {
+		//呼び出しスレッドのみでデコードするジョブ数(ワーカーの起床の方が高くつく小さな画像一式向け)
+		static const std::int32_t INLINE_JOB_MAXNUM = 16;
+
+	public:
+		//ジョブ
+		struct Job {
+			const std::char8_t*		bodyFilePath_;	//本体画像ファイルパス
+			const std::char8_t*		blendFilePath_;	//ブレンド画像ファイルパス(nullptr:なし)
+			DWImageFormat			format_;		//画像フォーマット
+			const DWDecodeTarget*	target_;		//出力先(nullptr:ジョブ毎のデコーダ内部領域、ジョブ間で重ならないこと)
+			DWPixelFormat			pixelFormat_;	//出力画素フォーマット
+			bool					isPremultiplied_;	//乗算済みアルファで出力
+			bool					isFlip_;		//上下反転
+		};
+		//ジョブ結果
+		struct Result {
+			std::int32_t	rc_;		//デコード結果(0:成功)
+			std::int32_t	workerNo_;	//処理したワーカー番号
+			std::float64_t	decodeUs_;	//デコード時間[us]
+		};
+
+	private:
+		//メンバ変数
+		DWImageDecorder*			decorders_;		//ジョブ毎のデコーダ(libpngの構造体はデコーダ毎に持つ)
+		Result*						results_;		//ジョブ毎の結果
+		std::int32_t				jobNum_;		//ジョブ数
+		std::int32_t				workerNum_;		//前回のワーカー数
+		std::float64_t				totalUs_;		//前回の全ジョブの経過時間[us]
+		const Job*					jobs_;			//実行中のジョブ
+		std::atomic<std::int32_t>	nextJobNo_;		//次に取り出すジョブ番号
+
+	public:
+		//コンストラクタ
+		DWImageBatch();
+		//デストラクタ
+		~DWImageBatch();
+		//デコード(workerNumが0以下なら論理コア数、INLINE_JOB_MAXNUM以下のジョブは呼び出しスレッドのみ、全ジョブ成功で0)
+		std::int32_t decode(const Job* const jobs, const std::int32_t jobNum, const std::int32_t workerNum = 0);
+		//ジョブのデコーダ取得(デコードデータはgetDecodeDataで取得、次回decodeまで有効)
+		DWImageDecorder* getDecorder(const std::int32_t jobNo);
+		//ジョブ結果取得
+		const Result* getResult(const std::int32_t jobNo);
+		//前回のワーカー数取得
+		std::int32_t getWorkerNum();
+		//前回の全ジョブの経過時間取得[us]
+		std::float64_t getTotalUs();
+
+	private:
+		//ワーカー関数(ジョブがなくなるまで取り出してデコード)
+		static void callbackWork(void* const user, const std::int32_t workerNo);
+		//ジョブ結果を破棄
+		void release();
+
+		//コピーコンストラクタ(禁止)
+		DWImageBatch(const DWImageBatch& org) = delete;
+		//代入演算子(禁止)
+		DWImageBatch& operator=(const DWImageBatch& org) = delete;
+	};
+
+	//DWImageCacheクラス(デコード済み画像のキャッシュ、プロセス共通)
+	class DWImageCache {
+		//エントリ最大数
+		static const std::int32_t ENTRY_MAXNUM = 256;
+		//ハッシュバケット数(2のべき乗)
+		static const std::int32_t BUCKET_NUM = 64;
+
+		//エントリ
+		struct Entry {
+			bool				isValid_;		//有効/無効
+			std::string			bodyPath_;		//キー:本体画像ファイルパス
+			std::string			blendPath_;		//キー:ブレンド画像ファイルパス(空:なし)
+			std::int64_t		bodyMtime_;		//キー:本体画像ファイルの更新時刻
+			std::int64_t		blendMtime_;	//キー:ブレンド画像ファイルの更新時刻
+			DWImageFormat		format_;		//キー:画像フォーマット
+			bool				isFlip_;		//キー:上下反転
+			DWPixelFormat		pixelFormat_;	//キー:出力画素フォーマット
+			std::uint32_t		hash_;			//キーのハッシュ値
+			DWImageDecorder*	decorder_;		//デコード結果
+			std::int32_t		byteSize_;		//デコードデータサイズ
+			std::int32_t		refCount_;		//参照数(0より大きい間は追い出さない)
+			std::uint32_t		lastUse_;		//最終参照時刻(LRU追い出し用)
+			std::int32_t		next_;			//同一バケットの次エントリ(-1:終端)
+		};
+
+	public:
+		//デコード済み画像の参照(コピーで参照数を加算、破棄で減算)
+		class Handle {
+			//メンバ変数
+			DWImageCache*	cache_;		//キャッシュ(nullptr:無効)
+			std::int32_t	entryNo_;	//エントリ番号
+			DWBitmap		bitmap_;	//デコード済み画像
+
+		public:
+			//コンストラクタ
+			Handle();
+			Handle(const Handle& org);
+			//デストラクタ
+			~Handle();
+			//代入演算子
+			Handle& operator=(const Handle& org);
+			//有効か
+			bool isValid() const;
+			//画像取得(画像データは参照中のみ有効)
+			const DWBitmap& getBitmap() const;
+			//参照を解放
+			void release();
+
+		private:
+			friend class DWImageCache;
+			//参照開始(参照数は加算済み)
+			Handle(DWImageCache* const cache, const std::int32_t entryNo, const DWBitmap& bitmap);
+		};
+
+	private:
+		//メンバ変数
+		std::mutex		mtx_;					//エントリと統計の排他
+		std::int32_t	buckets_[BUCKET_NUM];	//バケット毎の先頭エントリ(-1:なし)
+		Entry			entries_[ENTRY_MAXNUM];	//エントリテーブル
+		std::int32_t	byteBudget_;			//デコードデータの上限バイト数
+		std::int32_t	byteUsed_;				//デコードデータの使用バイト数
+		std::uint32_t	useCount_;				//参照時刻(参照毎に加算)
+		std::int32_t	hitNum_;				//ヒット数
+		std::int32_t	missNum_;				//ミス数
+		std::int32_t	evictNum_;				//追い出し数
+
+	public:
+		//取得
+		static DWImageCache* get();
+
+		//画像取得(未キャッシュならデコードして登録、失敗時は無効なハンドル)
+		Handle acquire(const std::char8_t* const bodyFilePath, const std::char8_t* const blendFilePath, const DWImageFormat format, const bool isFlip = false, const DWPixelFormat pixelFormat = DWPixelFormat::RGBA8888);
+		//上限バイト数設定(超えた分は参照のないエントリから追い出す)
+		void setByteBudget(const std::int32_t byteBudget);
+		//参照のない全エントリ破棄
+		void clear();
+		//統計取得
+		std::int32_t getHitNum();
+		std::int32_t getMissNum();
+		std::int32_t getEvictNum();
+		std::int32_t getByteUsed();
+		std::int32_t getEntryNum();
+		std::float64_t getHitRate();
+
+	private:
+		//コンストラクタ
+		DWImageCache(const std::int32_t byteBudget);
+		//デストラクタ
+		~DWImageCache();
+		//キーのハッシュ値を算出
+		std::uint32_t getHash(const std::string& bodyPath, const std::string& blendPath, const std::int64_t bodyMtime, const std::int64_t blendMtime, const DWImageFormat format, const bool isFlip, const DWPixelFormat pixelFormat);
+		//エントリ検索(ロック中に呼ぶ、なければ-1)
+		std::int32_t find(const std::uint32_t hash, const std::string& bodyPath, const std::string& blendPath, const std::int64_t bodyMtime, const std::int64_t blendMtime, const DWImageFormat format, const bool isFlip, const DWPixelFormat pixelFormat);
+		//エントリの画像を参照開始(ロック中に呼ぶ)
+		Handle addRef(const std::int32_t entryNo);
+		//参照数を加算(ハンドルのコピー時)
+		void retain(const std::int32_t entryNo);
+		//参照数を減算(ハンドルの解放時)
+		void releaseRef(const std::int32_t entryNo);
+		//参照のない最も古いエントリを追い出す(ロック中に呼ぶ、追い出したエントリ番号、なければ-1)
+		std::int32_t evictOldest();
+		//エントリを破棄(ロック中に呼ぶ)
+		void removeEntry(const std::int32_t entryNo);
+
+		//コピーコンストラクタ(禁止)
+		DWImageCache(const DWImageCache& org) = delete;
+		//代入演算子(禁止)
+		DWImageCache& operator=(const DWImageCache& org) = delete;
+	};
+
+	//DWImageAtlasクラス
+	class DWImageAtlas {
+		//ページ最大幅[pixel]
+		static const std::int32_t PAGE_MAXWIDTH = 1024;
+		//領域テーブル数(1バイト文字コード分)
+		static const std::int32_t REGION_MAXNUM = 256;
+
+		//文字領域
+		struct Region {
+			bool			isValid_;	//有効/無効
+			DWArea			area_;		//ページ内の領域
+		};
+
+		//メンバ変数
+		std::uint8_t*	page_;						//ページデータ
+		DWPixelFormat	pixelFormat_;				//ページの画素フォーマット
+		std::int32_t	pageSize_;					//ページデータサイズ
+		std::int32_t	width_;						//ページ幅
+		std::int32_t	height_;					//ページ高さ
+		Region			regions_[REGION_MAXNUM];	//文字領域テーブル
+
+	public:
+		//コンストラクタ
+		DWImageAtlas();
+		//デストラクタ
+		~DWImageAtlas();
+		//作成(文字毎の画像をデコードし、1枚のページへ配置)
+		std::int32_t create(const std::char8_t* const chars, const std::int32_t charNum, const DWPixelFormat pixelFormat = DWPixelFormat::RGBA8888);
+		//ページ取得
+		void getPage(DWBitmap* const bitmap);
+		//文字領域取得
+		std::int32_t getRegion(const std::char8_t c, DWArea* const area);
+
+	private:
+		//コピーコンストラクタ(禁止)
+		DWImageAtlas(const DWImageAtlas& org) = delete;
+		//代入演算子(禁止)
+		DWImageAtlas& operator=(const DWImageAtlas& org) = delete;
+	};
+
 	//DWImageBMPBMPクラス
 	class DWImageBMP {
 
@@ -143,6 +627,9 @@ namespace dw {
 		static const std::int32_t BIH_PALLETENUM_OFS = 46;	//パレット数[使用色数]
 		static const std::int32_t BIH_IMPCOLORNUM_OFS = 50;	//重要色数
 		static const std::int32_t BIH_PALLETE_OFS = 54;		//パレット
+		static const std::int32_t BIH_MASK_OFS = 54;		//ビットフィールドのマスク(R,G,B,A、V2以降は情報ヘッダ内)
+		static const std::int32_t BIH_HEADERSIZE_V3 = 56;	//アルファマスクを含む情報ヘッダサイズ[byte]
+		static const std::int32_t BIH_HEADERSIZE_V5 = 124;	//最大の情報ヘッダサイズ[byte](V2～V5の先頭40バイトは共通)
 															//Bitmapコアヘッダ(OS/2)
 		static const std::int32_t BCH_HEADERSIZE = 12;
 		static const std::int32_t BCH_HEADERSIZE_OFS = 14;	//情報ヘッダサイズ[byte]
@@ -156,6 +643,7 @@ namespace dw {
 		static const std::uint32_t COMPRESSION_BI_RLE8 = 1;			//ランレングス圧縮[8bpp]
 		static const std::uint32_t COMPRESSION_BI_RLE4 = 2;			//ランレングス圧縮[4bpp]
 		static const std::uint32_t COMPRESSION_BI_BITFIELDS = 3;	//ビットフィールド
+		static const std::uint32_t COMPRESSION_BI_ALPHABITFIELDS = 6;	//ビットフィールド(アルファあり)
 
 																	//パレットカラー構造体
 		struct PalColor {
@@ -185,6 +673,8 @@ namespace dw {
 		std::int32_t	palleteNum_;	//パレット数
 		std::int32_t	palleteByte_;	//1パレットあたりのバイト数
 		std::int32_t	palleteOffset_;	//パレットまでのオフセット
+		std::uint32_t	masks_[4];		//ビットフィールドのマスク(R,G,B,A)
+		bool			isPremultiplied_;	//乗算済みアルファで出力
 
 	public:
 		//コンストラクタ
@@ -197,20 +687,38 @@ namespace dw {
 		void getWH(std::int32_t* const width, std::int32_t* const height);
 		//RGBA8888画像へデコード
 		std::int32_t decode_RGBA8888(std::uint8_t** const decData);
+		//RGBA8888画像へデコード(decDataは画像の1行目、strideは出力先の1行のバイト数、負なら下から上へ並べる)
+		std::int32_t decode_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//RGBA8888画像のアルファへデコード(Rをマスク値として書き込み、R,G,Bは変更しない、引数はdecode_RGBA8888と同じ)
+		std::int32_t decodeAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//乗算済みアルファ出力の有効/無効設定(既定は無効、アルファへのデコードではマスク値をR,G,Bへ乗算)
+		void setPremultiplied(const bool isPremultiplied);
 
 	private:
 		//Bitmap情報ヘッダ(Windows)読み込み
-		std::int32_t readInfoHeader_WINDOWS();
+		std::int32_t readInfoHeader_WINDOWS(const std::int32_t infoHeaderSize);
 		//Bitmap情報ヘッダ(OS/2)読み込み
 		std::int32_t readInfoHeader_OS2();
+		//画像サイズの妥当性チェック(幅高さが正で、1行と画像全体のバイト数がint32に収まること)
+		std::int32_t checkImageSize();
 		//パディングバイト数を取得
 		std::uint32_t getPaddingByte();
 		//パレットデータを取得
 		std::int32_t getPalleteData(PalColor* const pallete, const std::int32_t numMaxPal);
+		//パレットをRGBA8888の変換テーブルへ展開(パレットインデックス→4バイト、パレット外は黒)
+		std::int32_t makePalleteColors(std::uint32_t* const colors);
 		//パレットBMP画像からRGBA8888画像へデコード
-		std::int32_t decodePalleteBitmap_RGBA8888(std::uint8_t** const decData);
+		std::int32_t decodePalleteBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
 		//トゥルーカラーBitmap画像からRGBA8888画像へデコード
-		std::int32_t decodeTrueColorBitmap_RGBA8888(std::uint8_t** const decData);
+		std::int32_t decodeTrueColorBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//ランレングス圧縮(RLE8,RLE4)BMP画像からRGBA8888画像へデコード
+		std::int32_t decodeRLEBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//ビットフィールド(16bit,32bit)BMP画像からRGBA8888画像へデコード
+		std::int32_t decodeBitFieldsBitmap_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//パレットBMP画像からRGBA8888画像のアルファへデコード
+		std::int32_t decodePalleteBitmapAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//トゥルーカラーBitmap画像からRGBA8888画像のアルファへデコード
+		std::int32_t decodeTrueColorBitmapAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
 
 		//コピーコンストラクタ(禁止)
 		DWImageBMP(const DWImageBMP& org) = delete;
@@ -220,29 +728,48 @@ namespace dw {
 
 	//DWImagePNGクラス
 	class DWImagePNG {
+	public:
+		//パス完了コールバック関数(passは完了したパス番号(1始まり)、passNumは全パス数(インターレースなしは1))
+		typedef void(*PassFunc)(void* const user, const std::int32_t pass, const std::int32_t passNum);
 
+	private:
 		//PNGシグネチャのバイト数
 		static const std::int32_t PNG_BYTES_TO_CHECK = 4;
+		//パレットの最大数
+		static const std::int32_t PALLETE_MAXNUM = 256;
 
 		//メンバ変数
 		std::uint8_t*	png_;			//PNGデータ
 		std::int32_t	pngSize_;		//PNGデータサイズ
+		std::int32_t	readOffset_;	//libpngへ渡した次の読み込み位置(PNGデータ先頭からのバイト数)
 		std::int32_t	width_;			//幅
 		std::int32_t	height_;		//高さ
-		std::int32_t	rowByte_;		//行バイト数
 		std::uint8_t	bitDepth_;		//ビット深度
 		std::uint8_t	colorType_;		//カラータイプ
 		std::int16_t	dmy_;
 
 		png_structp		pngStr_;		//PNG構造ポインタ(解放必要)
 		png_infop		pngInfo_;		//PNG情報ポインタ(解放必要)
+		png_bytep		work_;			//デコード中の作業領域(libpngのエラーでsetjmpへ戻った場合も解放できるようメンバで保持)
+		std::uint8_t*	alphaWork_;		//アルファへのデコード中のRGBA8888画像(インターレースのみ、解放はwork_と同じ)
+		bool			isPremultiplied_;	//乗算済みアルファで出力
+		PassFunc		passFunc_;		//パス完了コールバック関数(nullptr:通知なし)
+		void*			passUser_;		//パス完了コールバック関数へ渡すユーザーデータ
+
+		//行変換(prepareConvertRowで選択)
+		DWPixelConv::RowFunc		reduceRow_;		//16bit→8bitの縮小関数(8bit以下はnullptr)
+		DWPixelConv::RowFunc		expandRow_;		//8bitのサンプル→RGBA8888の展開関数(インデックスはnullptr)
+		DWPixelConv::IndexRowFunc	indexRow_;		//インデックス(パレット、グレー)→RGBA8888の展開関数
+		std::int32_t				channelNum_;	//1ピクセルのサンプル数
+		bool						isTransColor_;	//透過色(tRNS)を展開後に適用(グレー16bit、トゥルーカラー)
+		std::uint32_t				colors_[PALLETE_MAXNUM];	//インデックスの変換テーブル(R,G,B,Aの4バイト)
 
 	public:
 		//コンストラクタ
 		DWImagePNG();
 		//デストラクタ
 		~DWImagePNG();
-		//PNG読み込みコールバック関数
+		//PNG読み込みコールバック関数(データ不足はpng_errorでsetjmpへ戻る)
 		static void callbackReadPng(png_structp pngStr, png_bytep data, png_size_t length);
 		//作成
 		std::int32_t create(std::uint8_t* const png, const std::int32_t pngSize);
@@ -250,14 +777,34 @@ namespace dw {
 		void getWH(std::int32_t* const width, std::int32_t* const height);
 		//RGBA8888画像へデコード
 		std::int32_t decode_RGBA8888(std::uint8_t** const decData);
+		//RGBA8888画像へデコード(decDataは画像の1行目、strideは出力先の1行のバイト数、負なら下から上へ並べる)
+		std::int32_t decode_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//RGBA8888画像のアルファへデコード(R(グレー画像はグレー)をマスク値として書き込み、R,G,Bは変更しない、引数はdecode_RGBA8888と同じ)
+		std::int32_t decodeAlpha_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//乗算済みアルファ出力の有効/無効設定(既定は無効、アルファへのデコードではマスク値をR,G,Bへ乗算)
+		void setPremultiplied(const bool isPremultiplied);
+		//パス完了コールバック関数設定(インターレース画像は各パスの完了毎に、粗い画像を出力先へ書き込んでから通知)
+		void setPassFunc(const PassFunc passFunc, void* const user);
 
 	private:
-		//グレーPNG画像からRGBA8888画像へデコード
-		std::int32_t decodeGrayScalePng_RGBA8888(std::uint8_t** const decData, const png_bytepp png);
-		//トゥルーカラーPNG画像からRGBA8888画像へデコード
-		std::int32_t decodeTrueColorPng_RGBA8888(std::uint8_t** const decData, const png_bytepp png, const bool isAlpha);
-		//パレットPNG画像からRGBA8888画像へデコード
-		std::int32_t decodePalletePng_RGBA8888(std::uint8_t** const decData, const png_bytepp png);
+		//出力先の各行へ直接デコード(インターレースなしは画像全体の中間バッファなし)
+		std::int32_t decodeRows_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//出力先の各行のアルファへ直接デコード(インターレースはRGBA8888画像の作業領域を経由)
+		std::int32_t decodeAlphaRows_RGBA8888(std::uint8_t* const decData, const std::int32_t stride);
+		//インターレース(Adam7)画像を出力先へデコード(srcRowByteは読み込む1行のバイト数、パス完了コールバック関数があればパス毎に出力先へ書き込む)
+		std::int32_t decodeInterlace_RGBA8888(std::uint8_t* const decData, const std::int32_t stride, const std::int32_t srcRowByte, const std::int32_t passNum);
+		//行変換の準備(カラータイプ、ビット深度に応じて変換関数と変換テーブルを選択、1,2,4bitは1ピクセル1バイトへ展開済み)
+		std::int32_t prepareConvertRow();
+		//デコード後の1行をRGBA8888の1行へ変換(srcはdstの行末側に置いてもよい、16bitと透過色の適用はdstと重ならないこと)
+		void convertRow_RGBA8888(const png_bytep src, std::uint8_t* const dst);
+		//パレットをRGBA8888の変換テーブルへ展開(透過色(tRNS)はアルファへ、パレット外は黒、乗算済みアルファは乗算)
+		std::int32_t makePalleteColors();
+		//輝度をRGBA8888のグレーの変換テーブルへ展開(bitDepthは1,2,4,8、輝度の最大値を255へ拡大、isTRNSなら透過色の輝度を透明に)
+		void makeGrayColors(const std::int32_t bitDepth, const bool isTRNS);
+		//透過色(tRNS)と一致するピクセルを透明にする(グレー16bit、トゥルーカラー用、srcは変換前の1行で8bitか16bit)
+		void applyTransColor(const png_bytep src, std::uint8_t* const dst);
+		//作業領域を解放
+		void releaseWork();
 
 		//コピーコンストラクタ(禁止)
 		DWImagePNG(const DWImagePNG& org) = delete;
@@ -265,13 +812,40 @@ namespace dw {
 		DWImagePNG& operator=(const DWImagePNG& org) = delete;
 	};
 
+	//DWTickSchedulerクラス
+	class DWTickScheduler {
+		//早起き幅の上限[us]
+		static const std::int32_t MARGIN_MAX_US = 20000;
+
+		//メンバ変数
+		std::chrono::system_clock::time_point	deadline_;	//待ち合わせた秒境界
+		std::int32_t	marginUs_;		//秒境界より早く起床する幅[us](オーバースリープの実測から補正)
+		std::int32_t	lateUs_;		//直近の表示遅延[us]
+		std::int32_t	maxLateUs_;		//最大表示遅延[us]
+
+	public:
+		//コンストラクタ
+		DWTickScheduler();
+		//次の秒境界まで待ち(lockは取得済みであること、isWakeupがtrueになれば途中で戻る)
+		bool waitNextTick(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, const bool& isWakeup);
+		//表示完了を通知(秒境界からの表示遅延を記録)
+		void notifyPresent();
+		//直近の表示遅延取得[us]
+		std::int32_t getLateUs();
+		//最大表示遅延取得[us]
+		std::int32_t getMaxLateUs();
+	};
+
 	//DWFuncクラス
 	class DWFunc {
 	public:
 		//時刻取得
 		static DWTime getTime();
+		static DWTime getTime(const time_t t);
 		//数字画像ファイルパス取得
 		static std::string getFilePath_TimeNumImage(const std::char8_t timeNumber, DWImageFormat& format);
+		//数字画像の文字一覧取得
+		static const std::char8_t* getChars_TimeNumImage(std::int32_t* const charNum);
 	};
 };
 
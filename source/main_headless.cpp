@@ -0,0 +1,649 @@
+﻿#include "DWType.hpp"
+#include "DWMain.hpp"
+#include "DWUtility.hpp"
+#include "DWPixelConv.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <string>
+#include <vector>
+
+
+//定数定義
+namespace {
+
+	//フレームバッファ幅高さ(Win32版のウィンドウサイズに合わせる)
+	static const std::int32_t WIN_WIDTH = 500;
+	static const std::int32_t WIN_HEIGHT = 200;
+
+	//既定の計測フレーム数
+	static const std::int32_t DEFAULT_FRAME_NUM = 1000;
+
+	//画素フォーマット変換計測の画像幅高さ
+	static const std::int32_t PIXEL_WIDTH = 4096;
+	static const std::int32_t PIXEL_HEIGHT = 2048;
+	//画素フォーマット変換計測の既定の繰り返し数
+	static const std::int32_t DEFAULT_PIXEL_LOOP_NUM = 10;
+
+	//画像読み込み計測の既定の繰り返し数
+	static const std::int32_t DEFAULT_LOAD_LOOP_NUM = 20;
+
+	//並列デコード計測の既定の繰り返し数(数字画像一式を繰り返してジョブ数を増やす)
+	static const std::int32_t DEFAULT_BATCH_REPEAT_NUM = 20;
+
+	//画像キャッシュ計測の既定の繰り返し数
+	static const std::int32_t DEFAULT_CACHE_LOOP_NUM = 100;
+
+	//段階表示計測の既定の繰り返し数
+	static const std::int32_t DEFAULT_PROGRESSIVE_LOOP_NUM = 20;
+}
+
+//内部関数
+namespace {
+
+	//従来のインデックス→RGBA変換(1ピクセル毎にビットオフセットを更新して分岐、ビット深度毎の行変換関数との比較用)
+	void rowIndexToRGBA_bitLoop(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint32_t* const colors, const std::int32_t bitDepth)
+	{
+		std::int32_t writeOffset = 0;
+		std::int32_t readOffset = 0;
+		std::int32_t bitOfs = 8 - bitDepth;
+		const std::uint8_t bitMask = static_cast<std::uint8_t>((0x01 << bitDepth) - 1);
+		for (std::int32_t w = 0; w < width; w++) {
+			const std::uint8_t index = (src[readOffset] >> bitOfs) & bitMask;
+			const std::uint8_t* const color = reinterpret_cast<const std::uint8_t*>(&colors[index]);
+			dst[writeOffset + 0] = color[0];
+			dst[writeOffset + 1] = color[1];
+			dst[writeOffset + 2] = color[2];
+			dst[writeOffset + 3] = color[3];
+
+			bitOfs -= bitDepth;
+			if (bitOfs < 0) {
+				bitOfs = 8 - bitDepth;
+				readOffset++;
+			}
+			writeOffset += 4;
+		}
+	}
+
+	//画素フォーマット変換の計測(命令セット毎の変換速度[MB/s]を出力)
+	void benchmarkPixelConv(const std::int32_t loopNum)
+	{
+		struct Kernel {
+			dw::DWPixelConv::Format	format_;
+			const char*				name_;
+		};
+		static const Kernel KERNELS[] = {
+			{ dw::DWPixelConv::Format::RGB888, "RGB->RGBA" },
+			{ dw::DWPixelConv::Format::BGR888, "BGR->RGBA" },
+			{ dw::DWPixelConv::Format::BGRA8888, "BGRA->RGBA" },
+			{ dw::DWPixelConv::Format::RGBA8888, "RGBA->RGBA" },
+			{ dw::DWPixelConv::Format::GRAYALPHA88, "GA->RGBA" },
+		};
+		struct BitFieldsKernel {
+			std::int32_t	bitCount_;
+			std::uint32_t	masks_[4];
+			const char*		name_;
+		};
+		static const BitFieldsKernel BITFIELDS_KERNELS[] = {
+			{ 16, { 0xF800, 0x07E0, 0x001F, 0 }, "RGB565" },
+			{ 16, { 0x7C00, 0x03E0, 0x001F, 0x8000 }, "ARGB1555" },
+			{ 32, { 0x3FF00000, 0x000FFC00, 0x000003FF, 0xC0000000 }, "A2RGB10" },
+		};
+		//マスク画像をアルファへ書き込む関数
+		static const Kernel ALPHA_KERNELS[] = {
+			{ dw::DWPixelConv::Format::GRAY8, "GRAY->A" },
+			{ dw::DWPixelConv::Format::RGB888, "RGB->A" },
+			{ dw::DWPixelConv::Format::BGRA8888, "BGRA->A" },
+		};
+		//乗算済みアルファへ変換する関数
+		static const Kernel PREMUL_KERNELS[] = {
+			{ dw::DWPixelConv::Format::BGRA8888, "BGRA->pRGBA" },
+			{ dw::DWPixelConv::Format::RGBA8888, "RGBA->pRGBA" },
+			{ dw::DWPixelConv::Format::GRAYALPHA88, "GA->pRGBA" },
+		};
+		//RGBA8888から出力フォーマットへ詰める関数
+		struct PackKernel {
+			dw::DWPixelFormat	format_;
+			const char*			name_;
+		};
+		static const PackKernel PACK_KERNELS[] = {
+			{ dw::DWPixelFormat::RGB565, "RGBA->565" },
+			{ dw::DWPixelFormat::RGBA4444, "RGBA->4444" },
+			{ dw::DWPixelFormat::A8, "RGBA->A8" },
+			{ dw::DWPixelFormat::L8, "RGBA->L8" },
+		};
+		//インデックス(パレット、グレー)をRGBAへ展開する関数
+		struct IndexKernel {
+			std::int32_t	bitDepth_;
+			const char*		loopName_;
+			const char*		name_;
+		};
+		static const IndexKernel INDEX_KERNELS[] = {
+			{ 1, "IDX1 loop", "IDX1->RGBA" },
+			{ 2, "IDX2 loop", "IDX2->RGBA" },
+			{ 4, "IDX4 loop", "IDX4->RGBA" },
+			{ 8, "IDX8 loop", "IDX8->RGBA" },
+		};
+		static const dw::DWPixelConv::Isa ISAS[] = {
+			dw::DWPixelConv::Isa::SCALAR,
+			dw::DWPixelConv::Isa::SSSE3,
+			dw::DWPixelConv::Isa::AVX2,
+		};
+
+		//合成画像(4バイト/ピクセル分)と変換先、検証用の変換先を確保
+		const std::int32_t pixelNum = PIXEL_WIDTH * PIXEL_HEIGHT;
+		std::uint8_t* src = new std::uint8_t[pixelNum * 4];
+		std::uint8_t* dst = new std::uint8_t[pixelNum * 4];
+		std::uint8_t* ref = new std::uint8_t[pixelNum * 4];
+		std::uint32_t seed = 1;
+		for (std::int32_t i = 0; i < pixelNum * 4; i++) {
+			seed = (seed * 1103515245U) + 12345U;
+			src[i] = static_cast<std::uint8_t>(seed >> 16);
+		}
+		std::uint32_t colors[256];
+		for (std::int32_t i = 0; i < 256; i++) {
+			seed = (seed * 1103515245U) + 12345U;
+			colors[i] = seed;
+		}
+
+		printf("pixel conv: %dx%d, %d loops, best isa %s\n", PIXEL_WIDTH, PIXEL_HEIGHT, loopNum,
+			dw::DWPixelConv::getIsaName(dw::DWPixelConv::getBestIsa()));
+		//trueならスカラー版でも比較用の結果を更新しない(従来実装の結果と比較する場合)
+		bool isKeepRef = false;
+		//全行を変換して結果をスカラー版と比較し、速度を出力(convertImageは画像全体を変換)
+		auto measure = [&](const char* const name, const dw::DWPixelConv::Isa isa, const std::function<void()>& convertImage) {
+			//1回目は計測せず、結果をスカラー版と比較
+			convertImage();
+			if ((isa == dw::DWPixelConv::Isa::SCALAR) && (!isKeepRef)) {
+				memcpy(ref, dst, pixelNum * 4);
+			}
+			const bool isMatch = (memcmp(ref, dst, pixelNum * 4) == 0);
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (std::int32_t loop = 0; loop < loopNum; loop++) {
+				convertImage();
+			}
+			const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+			//RGBA8888側(変換先、出力フォーマットへ詰める場合は変換元)のバイト数で速度を算出(16bit→8bitは変換元のバイト数)
+			const std::float64_t sec = std::chrono::duration<std::float64_t>(end - start).count();
+			const std::float64_t mbps = (static_cast<std::float64_t>(pixelNum) * 4.0 * loopNum) / (sec * 1024.0 * 1024.0);
+			printf("  %-11s %-6s: %10.1f MB/s%s\n", name, dw::DWPixelConv::getIsaName(isa), mbps, (isMatch) ? "" : "  (MISMATCH)");
+		};
+
+		const std::int32_t dstRowByte = PIXEL_WIDTH * 4;
+		for (const Kernel& kernel : KERNELS) {
+			const std::int32_t srcRowByte = PIXEL_WIDTH * dw::DWPixelConv::getBytePerPixel(kernel.format_);
+			for (const dw::DWPixelConv::Isa isa : ISAS) {
+				const dw::DWPixelConv::RowFunc convertRow = dw::DWPixelConv::getRowFunc(kernel.format_, isa);
+				if (convertRow == nullptr) {
+					//実行中のCPUでは使用できない
+					continue;
+				}
+				measure(kernel.name_, isa, [&]() {
+					for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+						convertRow(src + (h * srcRowByte), dst + (h * dstRowByte), PIXEL_WIDTH);
+					}
+				});
+			}
+		}
+		for (const Kernel& kernel : PREMUL_KERNELS) {
+			const std::int32_t srcRowByte = PIXEL_WIDTH * dw::DWPixelConv::getBytePerPixel(kernel.format_);
+			for (const dw::DWPixelConv::Isa isa : ISAS) {
+				const dw::DWPixelConv::RowFunc convertRow = dw::DWPixelConv::getPremulRowFunc(kernel.format_, isa);
+				if (convertRow == nullptr) {
+					//実行中のCPUでは使用できない
+					continue;
+				}
+				measure(kernel.name_, isa, [&]() {
+					for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+						convertRow(src + (h * srcRowByte), dst + (h * dstRowByte), PIXEL_WIDTH);
+					}
+				});
+			}
+		}
+		for (const PackKernel& kernel : PACK_KERNELS) {
+			const std::int32_t packRowByte = PIXEL_WIDTH * dw::DWPixelConv::getBytePerPixel(kernel.format_);
+			for (const dw::DWPixelConv::Isa isa : ISAS) {
+				const dw::DWPixelConv::RowFunc packRow = dw::DWPixelConv::getPackRowFunc(kernel.format_, isa);
+				if (packRow == nullptr) {
+					//実行中のCPUでは使用できない
+					continue;
+				}
+				measure(kernel.name_, isa, [&]() {
+					for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+						packRow(src + (h * dstRowByte), dst + (h * packRowByte), PIXEL_WIDTH);
+					}
+				});
+			}
+		}
+		for (const Kernel& kernel : ALPHA_KERNELS) {
+			const std::int32_t srcRowByte = PIXEL_WIDTH * dw::DWPixelConv::getBytePerPixel(kernel.format_);
+			for (const dw::DWPixelConv::Isa isa : ISAS) {
+				const dw::DWPixelConv::RowFunc writeAlpha = dw::DWPixelConv::getAlphaRowFunc(kernel.format_, isa);
+				if (writeAlpha == nullptr) {
+					//実行中のCPUでは使用できない
+					continue;
+				}
+				measure(kernel.name_, isa, [&]() {
+					for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+						writeAlpha(src + (h * srcRowByte), dst + (h * dstRowByte), PIXEL_WIDTH);
+					}
+				});
+			}
+		}
+		for (const dw::DWPixelConv::Isa isa : ISAS) {
+			//16bitサンプル→8bit(1行は幅の2倍のサンプル数)
+			const dw::DWPixelConv::RowFunc reduceRow = dw::DWPixelConv::getReduce16RowFunc(isa);
+			if (reduceRow == nullptr) {
+				//実行中のCPUでは使用できない
+				continue;
+			}
+			measure("16->8", isa, [&]() {
+				for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+					reduceRow(src + (h * dstRowByte), dst + (h * PIXEL_WIDTH * 2), PIXEL_WIDTH * 2);
+				}
+			});
+		}
+		for (const IndexKernel& kernel : INDEX_KERNELS) {
+			//従来実装の結果と比較(スカラー版のみ)
+			const std::int32_t srcRowByte = ((PIXEL_WIDTH * kernel.bitDepth_) + 7) / 8;
+			const dw::DWPixelConv::IndexRowFunc convertRow = dw::DWPixelConv::getIndexRowFunc(kernel.bitDepth_);
+			measure(kernel.loopName_, dw::DWPixelConv::Isa::SCALAR, [&]() {
+				for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+					rowIndexToRGBA_bitLoop(src + (h * srcRowByte), dst + (h * dstRowByte), PIXEL_WIDTH, colors, kernel.bitDepth_);
+				}
+			});
+			isKeepRef = true;
+			measure(kernel.name_, dw::DWPixelConv::Isa::SCALAR, [&]() {
+				for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+					convertRow(src + (h * srcRowByte), dst + (h * dstRowByte), PIXEL_WIDTH, colors);
+				}
+			});
+			isKeepRef = false;
+		}
+		for (const BitFieldsKernel& kernel : BITFIELDS_KERNELS) {
+			dw::DWPixelConv::BitFields fields;
+			(void)dw::DWPixelConv::makeBitFields(kernel.bitCount_, kernel.masks_, &fields);
+			const std::int32_t srcRowByte = PIXEL_WIDTH * (kernel.bitCount_ / 8);
+			for (const dw::DWPixelConv::Isa isa : ISAS) {
+				const dw::DWPixelConv::BitFieldsRowFunc convertRow = dw::DWPixelConv::getBitFieldsRowFunc(kernel.bitCount_, isa);
+				if (convertRow == nullptr) {
+					//実行中のCPUでは使用できない
+					continue;
+				}
+				measure(kernel.name_, isa, [&]() {
+					for (std::int32_t h = 0; h < PIXEL_HEIGHT; h++) {
+						convertRow(src + (h * srcRowByte), dst + (h * dstRowByte), PIXEL_WIDTH, fields);
+					}
+				});
+			}
+		}
+
+		delete[] ref;
+		delete[] dst;
+		delete[] src;
+	}
+
+	//読み込み計測の対象画像
+	struct LoadFile {
+		std::string			path_;
+		dw::DWImageFormat	format_;
+	};
+
+	//計測対象の画像一覧を取得(画像指定がなければ数字画像一式)
+	std::vector<LoadFile> getLoadFiles(const std::int32_t pathNum, char* const* const paths)
+	{
+		std::vector<LoadFile> files;
+		if (pathNum > 0) {
+			for (std::int32_t i = 0; i < pathNum; i++) {
+				//拡張子がbmpならBMP、それ以外はPNG
+				LoadFile file;
+				file.path_ = paths[i];
+				const std::size_t dot = file.path_.rfind('.');
+				file.format_ = ((dot != std::string::npos) && (file.path_.compare(dot, std::string::npos, ".bmp") == 0)) ? dw::DWImageFormat::BMP : dw::DWImageFormat::PNG;
+				files.push_back(file);
+			}
+		}
+		else {
+			std::int32_t charNum = 0;
+			const std::char8_t* chars = dw::DWFunc::getChars_TimeNumImage(&charNum);
+			for (std::int32_t i = 0; i < charNum; i++) {
+				LoadFile file;
+				file.path_ = dw::DWFunc::getFilePath_TimeNumImage(chars[i], file.format_);
+				files.push_back(file);
+			}
+		}
+		return files;
+	}
+
+	//画像一式の読み込み時間[us]を計測(isDecodeがfalseならファイル入力のみ)
+	std::float64_t measureLoad(const std::vector<LoadFile>& files, const bool isFileMap, const bool isCold, const bool isDecode, const std::int32_t loopNum)
+	{
+		dw::DWImageDecorder decorder;
+		decorder.setFileMap(isFileMap);
+
+		std::float64_t totalSec = 0.0;
+		std::uint32_t sum = 0;
+		for (std::int32_t loop = 0; loop < loopNum; loop++) {
+			//コールドはページキャッシュから破棄してから計測
+			if (isCold) {
+				for (const LoadFile& file : files) {
+					(void)dw::DWFileMap::dropCache(file.path_.c_str());
+				}
+			}
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (const LoadFile& file : files) {
+				if (isDecode) {
+					(void)decorder.decode_RGBA8888(file.path_.c_str(), nullptr, file.format_);
+				}
+				else {
+					//全バイトを参照(マップ時のページフォールトを含める)
+					dw::DWFileMap fileMap;
+					if (fileMap.open(file.path_.c_str(), isFileMap) == 0) {
+						const std::uint8_t* data = fileMap.getData();
+						for (std::int32_t b = 0; b < fileMap.getSize(); b++) {
+							sum += data[b];
+						}
+					}
+				}
+			}
+			const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			totalSec += std::chrono::duration<std::float64_t>(end - start).count();
+		}
+
+		//最適化で参照が消えないように
+		if (sum == 1) {
+			printf("\n");
+		}
+		return (totalSec * 1000000.0) / loopNum;
+	}
+
+	//画像読み込みの計測(従来の読み込みとファイルマップのコールド/ウォーム時間を出力、画像指定がなければ数字画像一式)
+	void benchmarkLoad(const std::int32_t loopNum, const std::int32_t pathNum, char* const* const paths)
+	{
+		const std::vector<LoadFile> files = getLoadFiles(pathNum, paths);
+		const bool isDropCache = (dw::DWFileMap::dropCache(files[0].path_.c_str()) == 0);
+
+		printf("load: %d files, %d loops%s\n", static_cast<std::int32_t>(files.size()), loopNum, (isDropCache) ? "" : " (cold is not supported)");
+		printf("                   input only         input + decode\n");
+		printf("                 cold      warm      cold      warm   [us/set]\n");
+		static const bool FILEMAPS[] = { false, true };
+		for (const bool isFileMap : FILEMAPS) {
+			printf("  %-8s: %9.1f %9.1f %9.1f %9.1f\n", (isFileMap) ? "mmap" : "read",
+				measureLoad(files, isFileMap, true, false, loopNum), measureLoad(files, isFileMap, false, false, loopNum),
+				measureLoad(files, isFileMap, true, true, loopNum), measureLoad(files, isFileMap, false, true, loopNum));
+		}
+	}
+
+	//並列デコードの計測(ワーカー数毎の全ジョブの経過時間と1ワーカーに対する速度比を出力)
+	void benchmarkBatch(const std::int32_t repeatNum, const std::int32_t pathNum, char* const* const paths)
+	{
+		//画像一式をrepeatNum回並べたジョブ
+		const std::vector<LoadFile> files = getLoadFiles(pathNum, paths);
+		std::vector<dw::DWImageBatch::Job> jobs;
+		for (std::int32_t loop = 0; loop < repeatNum; loop++) {
+			for (const LoadFile& file : files) {
+				dw::DWImageBatch::Job job;
+				job.bodyFilePath_ = file.path_.c_str();
+				job.blendFilePath_ = nullptr;
+				job.format_ = file.format_;
+				job.target_ = nullptr;
+				job.pixelFormat_ = dw::DWPixelFormat::RGBA8888;
+				job.isPremultiplied_ = false;
+				job.isFlip_ = false;
+				jobs.push_back(job);
+			}
+		}
+		const std::int32_t jobNum = static_cast<std::int32_t>(jobs.size());
+
+		//ワーカー数は1から論理コア数まで倍々に(最後は論理コア数)
+		std::vector<std::int32_t> workerNums;
+		const std::int32_t coreNum = static_cast<std::int32_t>(std::thread::hardware_concurrency());
+		for (std::int32_t num = 1; num < coreNum; num *= 2) {
+			workerNums.push_back(num);
+		}
+		workerNums.push_back((coreNum > 0) ? coreNum : 1);
+
+		//1ワーカーの結果を基準に、デコード結果の一致も確認(1回目はファイルキャッシュの準備として捨てる)
+		dw::DWImageBatch base;
+		(void)base.decode(jobs.data(), jobNum, 1);
+		(void)base.decode(jobs.data(), jobNum, 1);
+
+		printf("batch: %d jobs, %d cores\n", jobNum, coreNum);
+		printf("  workers     total[ms]   speedup   job avg[us]   failed\n");
+		for (const std::int32_t workerNum : workerNums) {
+			dw::DWImageBatch batch;
+			(void)batch.decode(jobs.data(), jobNum, workerNum);
+
+			std::float64_t jobUs = 0.0;
+			std::int32_t failNum = 0;
+			bool isMatch = true;
+			for (std::int32_t i = 0; i < jobNum; i++) {
+				const dw::DWImageBatch::Result* result = batch.getResult(i);
+				jobUs += result->decodeUs_;
+				if (result->rc_ < 0) {
+					failNum++;
+					continue;
+				}
+				std::int32_t size = 0, baseSize = 0;
+				const std::uint8_t* data = batch.getDecorder(i)->getDecodeData(&size, nullptr, nullptr);
+				const std::uint8_t* baseData = base.getDecorder(i)->getDecodeData(&baseSize, nullptr, nullptr);
+				if ((size != baseSize) || (memcmp(data, baseData, size) != 0)) {
+					isMatch = false;
+				}
+			}
+			printf("  %7d %13.2f %9.2f %13.1f %8d%s\n", batch.getWorkerNum(), batch.getTotalUs() / 1000.0,
+				base.getTotalUs() / batch.getTotalUs(), jobUs / jobNum, failNum, (isMatch) ? "" : "  (MISMATCH)");
+		}
+	}
+
+	//画像キャッシュの計測(画像一式を繰り返し取得し、毎回デコードする場合と比較)
+	void benchmarkCache(const std::int32_t loopNum, const std::int32_t budgetKB, const std::int32_t pathNum, char* const* const paths)
+	{
+		const std::vector<LoadFile> files = getLoadFiles(pathNum, paths);
+		const std::int32_t fileNum = static_cast<std::int32_t>(files.size());
+
+		//毎回デコードする場合
+		const std::float64_t decodeUs = measureLoad(files, true, false, true, loopNum);
+
+		//キャッシュから取得する場合(取得したハンドルは1周毎に解放)
+		dw::DWImageCache* cache = dw::DWImageCache::get();
+		if (budgetKB > 0) {
+			cache->setByteBudget(budgetKB * 1024);
+		}
+		std::vector<dw::DWImageCache::Handle> handles(fileNum);
+		std::int32_t failNum = 0;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::int32_t loop = 0; loop < loopNum; loop++) {
+			for (std::int32_t i = 0; i < fileNum; i++) {
+				handles[i] = cache->acquire(files[i].path_.c_str(), nullptr, files[i].format_);
+				if (!handles[i].isValid()) {
+					failNum++;
+				}
+			}
+			for (dw::DWImageCache::Handle& handle : handles) {
+				handle.release();
+			}
+		}
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		const std::float64_t cacheUs = std::chrono::duration<std::float64_t, std::micro>(end - start).count() / loopNum;
+
+		if (budgetKB > 0) {
+			printf("cache: %d files, %d loops, budget %d KB\n", fileNum, loopNum, budgetKB);
+		}
+		else {
+			printf("cache: %d files, %d loops, default budget\n", fileNum, loopNum);
+		}
+		printf("  decode every time: %10.1f us/set\n", decodeUs);
+		printf("  image cache      : %10.1f us/set\n", cacheUs);
+		printf("  hit rate %.3f (hit %d, miss %d), resident %d bytes in %d entries, evict %d, failed %d\n",
+			cache->getHitRate(), cache->getHitNum(), cache->getMissNum(), cache->getByteUsed(), cache->getEntryNum(), cache->getEvictNum(), failNum);
+	}
+
+	//段階表示計測のパス毎の経過時間
+	struct ProgressTime {
+		std::chrono::steady_clock::time_point	start_;		//デコード開始時刻
+		std::vector<std::float64_t>				passUs_;	//デコード開始から各パスの通知までの経過時間の合計[us]
+	};
+
+	//進捗コールバック関数(デコード開始からの経過時間をパス毎に加算)
+	void callbackProgress(void* const user, const std::int32_t pass, const std::int32_t passNum)
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		ProgressTime* const time = static_cast<ProgressTime*>(user);
+		if (static_cast<std::int32_t>(time->passUs_.size()) < passNum) {
+			time->passUs_.resize(passNum, 0.0);
+		}
+		time->passUs_[pass - 1] += std::chrono::duration<std::float64_t, std::micro>(now - time->start_).count();
+	}
+
+	//段階表示の計測(画像毎に、各パスの粗い画像を表示できるまでの時間を段階表示なしのデコード時間と比較)
+	void benchmarkProgressive(const std::int32_t loopNum, const std::int32_t pathNum, char* const* const paths)
+	{
+		const std::vector<LoadFile> files = getLoadFiles(pathNum, paths);
+
+		printf("progressive: %d files, %d loops\n", static_cast<std::int32_t>(files.size()), loopNum);
+		for (const LoadFile& file : files) {
+			//段階表示なしのデコード時間
+			const std::float64_t fullUs = measureLoad(std::vector<LoadFile>(1, file), true, false, true, loopNum);
+
+			//段階表示ありのデコード(パス毎に出力先へ書き込んで通知)
+			dw::DWImageDecorder decorder;
+			ProgressTime time;
+			decorder.setProgressFunc(callbackProgress, &time);
+			std::int32_t failNum = 0;
+			for (std::int32_t loop = 0; loop < loopNum; loop++) {
+				time.start_ = std::chrono::steady_clock::now();
+				if (decorder.decode_RGBA8888(file.path_.c_str(), nullptr, file.format_) < 0) {
+					failNum++;
+				}
+			}
+
+			std::int32_t width = 0, height = 0;
+			(void)decorder.getDecodeData(nullptr, &width, &height);
+			const std::int32_t passNum = static_cast<std::int32_t>(time.passUs_.size());
+			printf("  %s (%dx%d, %d passes)%s\n", file.path_.c_str(), width, height, passNum, (failNum > 0) ? "  (FAILED)" : "");
+			printf("    pass   elapsed[us]   ratio\n");
+			for (std::int32_t pass = 0; pass < passNum; pass++) {
+				const std::float64_t passUs = time.passUs_[pass] / loopNum;
+				printf("    %4d %13.1f %7.2f\n", pass + 1, passUs, passUs / fullUs);
+			}
+			printf("    full %13.1f %7.2f\n", fullUs, 1.0);
+		}
+	}
+}
+
+//メイン(ヘッドレスで描画処理を計測)
+int main(int argc, char* argv[])
+{
+	if ((argc > 1) && (strcmp(argv[1], "pixel") == 0)) {
+		//画素フォーマット変換の計測
+		std::int32_t loopNum = DEFAULT_PIXEL_LOOP_NUM;
+		if (argc > 2) {
+			loopNum = std::atoi(argv[2]);
+		}
+		if (loopNum <= 0) {
+			printf("usage: %s pixel [loopNum]\n", argv[0]);
+			return 1;
+		}
+		benchmarkPixelConv(loopNum);
+		return 0;
+	}
+	if ((argc > 1) && (strcmp(argv[1], "load") == 0)) {
+		//画像読み込みの計測
+		std::int32_t loopNum = DEFAULT_LOAD_LOOP_NUM;
+		if (argc > 2) {
+			loopNum = std::atoi(argv[2]);
+		}
+		if (loopNum <= 0) {
+			printf("usage: %s load [loopNum] [imageFile...]\n", argv[0]);
+			return 1;
+		}
+		benchmarkLoad(loopNum, (argc > 3) ? (argc - 3) : 0, argv + 3);
+		return 0;
+	}
+	if ((argc > 1) && (strcmp(argv[1], "batch") == 0)) {
+		//並列デコードの計測
+		std::int32_t repeatNum = DEFAULT_BATCH_REPEAT_NUM;
+		if (argc > 2) {
+			repeatNum = std::atoi(argv[2]);
+		}
+		if (repeatNum <= 0) {
+			printf("usage: %s batch [repeatNum] [imageFile...]\n", argv[0]);
+			return 1;
+		}
+		benchmarkBatch(repeatNum, (argc > 3) ? (argc - 3) : 0, argv + 3);
+		return 0;
+	}
+	if ((argc > 1) && (strcmp(argv[1], "cache") == 0)) {
+		//画像キャッシュの計測
+		std::int32_t loopNum = DEFAULT_CACHE_LOOP_NUM;
+		std::int32_t budgetKB = 0;
+		if (argc > 2) {
+			loopNum = std::atoi(argv[2]);
+		}
+		if (argc > 3) {
+			budgetKB = std::atoi(argv[3]);
+		}
+		if ((loopNum <= 0) || (budgetKB < 0)) {
+			printf("usage: %s cache [loopNum] [budgetKB] [imageFile...]\n", argv[0]);
+			return 1;
+		}
+		benchmarkCache(loopNum, budgetKB, (argc > 4) ? (argc - 4) : 0, argv + 4);
+		return 0;
+	}
+	if ((argc > 1) && (strcmp(argv[1], "progressive") == 0)) {
+		//段階表示の計測
+		std::int32_t loopNum = DEFAULT_PROGRESSIVE_LOOP_NUM;
+		if (argc > 2) {
+			loopNum = std::atoi(argv[2]);
+		}
+		if (loopNum <= 0) {
+			printf("usage: %s progressive [loopNum] [imageFile...]\n", argv[0]);
+			return 1;
+		}
+		benchmarkProgressive(loopNum, (argc > 3) ? (argc - 3) : 0, argv + 3);
+		return 0;
+	}
+
+	//計測フレーム数
+	std::int32_t frameNum = DEFAULT_FRAME_NUM;
+	if (argc > 1) {
+		frameNum = std::atoi(argv[1]);
+	}
+	if (frameNum <= 0) {
+		printf("usage: %s [frameNum] [fontFile] | pixel [loopNum] | load [loopNum] [imageFile...] | batch [repeatNum] [imageFile...] | cache [loopNum] [budgetKB] [imageFile...] | progressive [loopNum] [imageFile...]\n", argv[0]);
+		return 1;
+	}
+
+	//フォントファイル(未指定なら既定のフォント)
+	const char* fontPath = (argc > 2) ? argv[2] : dw::DWWindow::getDefaultFontPath();
+
+	//DWWindow作成(CPU上のフレームバッファ)
+	if (dw::DWWindow::createHeadless(WIN_WIDTH, WIN_HEIGHT, fontPath) != 0) {
+		printf("font load failed: %s (usage: %s [frameNum] [fontFile])\n", fontPath, argv[0]);
+		return 1;
+	}
+
+	//全体再描画と差分再描画のフレーム時間を計測
+	const std::float64_t fullUs = dw::DWMain::benchmark(frameNum, true);
+	const std::float64_t dirtyUs = dw::DWMain::benchmark(frameNum, false);
+	printf("frames: %d (%dx%d)\n", frameNum, WIN_WIDTH, WIN_HEIGHT);
+	printf("full redraw : %10.2f us/frame\n", fullUs);
+	printf("dirty redraw: %10.2f us/frame\n", dirtyUs);
+
+	//グリフキャッシュの統計
+	dw::DWGlyphCache* glyphCache = dw::DWWindow::get()->getGlyphCache();
+	printf("glyph cache : hit %d, miss %d, %d bytes\n", glyphCache->getHitNum(), glyphCache->getMissNum(), glyphCache->getByteUsed());
+
+	//DWWindow破棄
+	dw::DWWindow::destroy();
+
+	return 0;
+}
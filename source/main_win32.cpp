@@ -47,6 +47,13 @@ namespace {
 		::PostQuitMessage(0);
 	}
 
+	//WM_SIZE,WM_PAINTイベント処理
+	void WndProc_WMInvalidate()
+	{
+		//DWMain全体再描画要求
+		dw::DWMain::invalidate();
+	}
+
 	//ウィンドウプロシージャ
 	LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	{
@@ -61,6 +68,16 @@ namespace {
 			WndProc_WMDestroy();
 			break;
 
+		case WM_SIZE:
+			WndProc_WMInvalidate();
+			break;
+
+		case WM_PAINT:
+			WndProc_WMInvalidate();
+			//更新領域の検証はデフォルト処理で実施
+			ret = ::DefWindowProc(hWnd, msg, wParam, lParam);
+			break;
+
 		default:
 			//デフォルト処理
 			ret = ::DefWindowProc(hWnd, msg, wParam, lParam);